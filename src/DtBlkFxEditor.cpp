@@ -593,6 +593,11 @@ DtBlkFxEditor::FooterComponent::FooterComponent(DtBlkFxEditor& e)
   addAndMakeVisible(randomizeButton);
   randomizeButton.onClick = [&] { owner.startRandomization(); };
 
+  addAndMakeVisible(statsButton);
+  statsButton.setClickingTogglesState(true);
+  statsButton.setTooltip("Show what the engine is costing");
+  statsButton.onClick = [&] { owner.showStats(statsButton.getToggleState()); };
+
   addAndMakeVisible(smoothSlider);
   smoothSlider.setSliderStyle(juce::Slider::LinearHorizontal);
   smoothSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 15);
@@ -649,6 +654,8 @@ void DtBlkFxEditor::FooterComponent::resized()
 
   // Randomize on the right
   randomizeButton.setBounds(area.removeFromRight(100).withHeight(24));
+  area.removeFromRight(10);
+  statsButton.setBounds(area.removeFromRight(50).withHeight(24));
 
   // Smooth slider in the middle, but ensure space for the attached label
   // Label is attached to the left, so we need to leave a gap.
@@ -658,6 +665,78 @@ void DtBlkFxEditor::FooterComponent::resized()
   smoothSlider.setBounds(area.withHeight(24));
 }
 
+//==============================================================================
+DtBlkFxEditor::StatsComponent::StatsComponent()
+{
+  // only shows what's under it
+  setInterceptsMouseClicks(false, false);
+}
+
+void DtBlkFxEditor::StatsComponent::paint(juce::Graphics& g)
+{
+  g.fillAll(juce::Colours::black.withAlpha(0.7f));
+  g.setColour(juce::Colours::white);
+  g.setFont(12.0f);
+
+  auto area = getLocalBounds().reduced(8, 6);
+  for (auto& line : lines)
+    g.drawText(line, area.removeFromTop(16), juce::Justification::centredLeft, true);
+}
+
+void DtBlkFxEditor::StatsComponent::update(const DtBlkFxAudioProcessor::EngineStats& s)
+{
+  const double mb = 1.0 / (1 << 20);
+  lines.clear();
+
+  lines.add(juce::String::formatted("callback %.1f us avg, %.1f us max, %.1f%% of the buffer",
+                                    s.cost.avg_secs * 1e6,
+                                    s.cost.max_secs * 1e6,
+                                    s.callback_secs > 0.0
+                                        ? 100.0 * s.cost.avg_secs / s.callback_secs
+                                        : 0.0));
+  lines.add(juce::String::formatted("%.1f blks per sec of input (adaptive hop %s)",
+                                    s.cost.blk_rate,
+                                    s.adaptive_hop ? "on" : "off"));
+  lines.add(juce::String::formatted("memory %.1f MB (x0 %.1f, x1 %.1f, x3 %.1f), shared %.1f MB",
+                                    s.mem.instance() * mb,
+                                    s.mem.x0 * mb,
+                                    s.mem.x1 * mb,
+                                    s.mem.x3 * mb,
+                                    s.mem.scratch * mb));
+
+  if (s.memo.budget_bytes)
+    lines.add(juce::String::formatted("memo %ld of %ld blks hit (%.0f%%), %ld added, %.0f MB",
+                                      s.memo.hits,
+                                      s.memo.lookups,
+                                      s.memo.lookups ? 100.0 * s.memo.hits / s.memo.lookups : 0.0,
+                                      s.memo.inserts,
+                                      s.memo.budget_bytes * mb));
+  else
+    lines.add("memo off");
+
+  if (s.diff.full + s.diff.resonator + s.diff.pruned)
+    lines.add(juce::String::formatted("diff resynth %ld full, %ld resonator, %ld pruned",
+                                      s.diff.full,
+                                      s.diff.resonator,
+                                      s.diff.pruned));
+  else
+    lines.add("no diff resynth blks");
+
+  repaint();
+}
+
+void DtBlkFxEditor::showStats(bool on)
+{
+  // start counting from now
+  DtBlkFxAudioProcessor::EngineStats s;
+  audioProcessor.getEngineStats(s, /*reset*/ true);
+  statsTicks = 0;
+
+  stats.lines.clear();
+  stats.setVisible(on);
+  stats.repaint();
+}
+
 //==============================================================================
 void DtBlkFxEditor::startRandomization()
 {
@@ -815,6 +894,7 @@ DtBlkFxEditor::DtBlkFxEditor(DtBlkFxAudioProcessor& p)
   addAndMakeVisible(outputSpectrogram);
   addAndMakeVisible(footer);
   addAndMakeVisible(limiter);
+  addChildComponent(stats);
 
   // Channel Selectors Removed
   inputSpectrogram.setLabel("Input L+R");
@@ -854,6 +934,14 @@ void DtBlkFxEditor::timerCallback()
     audioProcessor.newOutputSpectrogramDataAvailable = false;
   }
 
+  // stats over the last half second
+  if (stats.isVisible() && ++statsTicks * getTimerInterval() >= 500) {
+    DtBlkFxAudioProcessor::EngineStats s;
+    audioProcessor.getEngineStats(s, /*reset*/ true);
+    stats.update(s);
+    statsTicks = 0;
+  }
+
   updateInterpolation();
 }
 
@@ -883,6 +971,9 @@ void DtBlkFxEditor::resized()
   // outputChannelSelector removed
   outputSpectrogram.setBounds(specArea.removeFromTop(specHeight));
 
+  // overlay over both spectrograms
+  stats.setBounds(inputSpectrogram.getBounds().getUnion(outputSpectrogram.getBounds()));
+
   int rowHeight = 70; // Reduced row height
   for (auto& row : paramRows) {
     row->setBounds(area.removeFromTop(rowHeight));
@@ -95,6 +95,9 @@ public:
   void loadPreset();
   void loadFactoryPreset(int index);
 
+  // show or hide the stats overlay, the stats start from when it's shown
+  void showStats(bool on);
+
   struct FooterComponent : public juce::Component {
     FooterComponent(DtBlkFxEditor& editor);
     ~FooterComponent() override = default;
@@ -104,6 +107,7 @@ public:
 
     DtBlkFxEditor& owner;
     juce::TextButton randomizeButton{"Randomize"};
+    juce::TextButton statsButton{"Stats"};
     juce::Slider smoothSlider;
     juce::Label smoothLabel;
     juce::ComboBox presetBox;
@@ -127,6 +131,19 @@ public:
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> enableAttachment;
   };
 
+  // debug overlay over the spectrograms with what the core is costing (see
+  // DtBlkFxAudioProcessor::getEngineStats), shown by the footer's stats button
+  struct StatsComponent : public juce::Component {
+    StatsComponent();
+    ~StatsComponent() override = default;
+
+    void paint(juce::Graphics& g) override;
+
+    void update(const DtBlkFxAudioProcessor::EngineStats& stats);
+
+    juce::StringArray lines;
+  };
+
 private:
   DtBlkFxAudioProcessor& audioProcessor;
 
@@ -137,6 +154,9 @@ private:
   SpectrogramComponent inputSpectrogram;
   SpectrogramComponent outputSpectrogram;
 
+  StatsComponent stats;
+  int statsTicks = 0; // timer ticks since the stats were last updated
+
   // Interpolation State
   bool isInterpolating = false;
   double interpolationTime = 0.0;
@@ -19,6 +19,7 @@
 
 #include "DtBlkFxProcessor.h"
 #include "DtBlkFxEditor.h"
+#include "RtCheck.h"
 #include "rfftw_float.h"
 
 DtBlkFxAudioProcessor::DtBlkFxAudioProcessor()
@@ -34,11 +35,19 @@ DtBlkFxAudioProcessor::DtBlkFxAudioProcessor()
 {
   static bool initialized = false;
   if (!initialized) {
+    // use fft sizes tuned for this cpu if the tuner has been run (see src/tools/FFTSzTune.cpp)
+    juce::File tuned = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                           .getChildFile("DtBlkFx")
+                           .getChildFile("fft_sizes.txt");
+    if (tuned.existsAsFile())
+      LoadFFTSzTable(tuned.getFullPathName().toRawUTF8());
+
     CreateFFTWfPlans();
     initialized = true;
   }
 
   core = new DtBlkFx(nullptr);
+  std::memset(&core->timeInfo, 0, sizeof(core->timeInfo));
   core->setSampleRate(getSampleRate());
   core->setBlockSize(getBlockSize());
 
@@ -55,6 +64,8 @@ DtBlkFxAudioProcessor::DtBlkFxAudioProcessor()
     // Sync initial values
     core->setParameter(i, apvts.getRawParameterValue("param_" + juce::String(i))->load());
   }
+
+  startTimerHz(10);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout DtBlkFxAudioProcessor::createParameterLayout()
@@ -83,6 +94,12 @@ juce::AudioProcessorValueTreeState::ParameterLayout DtBlkFxAudioProcessor::creat
           name = "Overlap";
           defaultValue = 0.5f;
           break;
+        case BlkFxParam::WOLA:
+          name = "WOLA Window";
+          break;
+        case BlkFxParam::FREEZE:
+          name = "Freeze";
+          break;
         default:
           name = "Global " + juce::String(p.glob_param);
           break;
@@ -132,6 +149,12 @@ juce::AudioProcessorValueTreeState::ParameterLayout DtBlkFxAudioProcessor::creat
       50.0f));
   layout.add(std::make_unique<juce::AudioParameterBool>(limiterEnabledId, "Limiter Enabled", true));
 
+  // Memo cache for looped input
+  layout.add(std::make_unique<juce::AudioParameterInt>(memoBudgetId, "Memo Cache MB", 0, 1024, 0));
+
+  // Adaptive hop
+  layout.add(std::make_unique<juce::AudioParameterBool>(adaptiveHopId, "Adaptive Hop", false));
+
   return layout;
 }
 
@@ -141,18 +164,93 @@ void DtBlkFxAudioProcessor::parameterChanged(const juce::String& parameterID, fl
     if (parameterID.startsWith("param_")) {
       int index = parameterID.substring(6).getIntValue();
       core->setParameter(index, newValue);
+
+      // allocate the wola window or freeze buffers now rather than on the next timer tick (never
+      // on the audio thread)
+      if ((index == BlkFxParam::WOLA || index == BlkFxParam::FREEZE) &&
+          juce::MessageManager::existsAndIsCurrentThread())
+        core->reserveBlk();
     }
   }
 }
 
 DtBlkFxAudioProcessor::~DtBlkFxAudioProcessor()
 {
+  stopTimer();
   if (core) {
     delete core;
     core = nullptr;
   }
 }
 
+void DtBlkFxAudioProcessor::timerCallback()
+{
+  if (!core)
+    return;
+  core->reserveBlk();
+
+  int mb = (int)apvts.getRawParameterValue(memoBudgetId)->load();
+  if (mb != memoBudgetMb) {
+    memoBudgetMb = mb;
+    core->setMemoBudget((size_t)mb << 20);
+  }
+
+  bool hop = apvts.getRawParameterValue(adaptiveHopId)->load() >= 0.5f;
+  if (hop != adaptiveHop) {
+    adaptiveHop = hop;
+    core->setAdaptiveHop(hop);
+  }
+
+  if (++costTicks >= COST_TICKS) {
+    core->getCallbackCost(lastCost, /*reset*/ true);
+    costTicks = 0;
+  }
+}
+
+void DtBlkFxAudioProcessor::getEngineStats(EngineStats& r, bool reset)
+{
+  r.cost = lastCost;
+  r.callback_secs = getSampleRate() > 0.0 ? (double)getBlockSize() / getSampleRate() : 0.0;
+  r.adaptive_hop = adaptiveHop;
+  core->getMemReport(r.mem);
+  r.memo = core->getMemoStats(reset);
+  r.diff = core->getDiffStats(reset);
+}
+
+void DtBlkFxAudioProcessor::updateTimeInfo()
+{
+  VstTimeInfo& ti = core->timeInfo;
+  ti.sampleRate = getSampleRate();
+  ti.flags = 0;
+
+  auto* playHead = getPlayHead();
+  if (playHead == nullptr)
+    return;
+  auto pos = playHead->getPosition();
+  if (!pos)
+    return;
+
+  if (auto bpm = pos->getBpm()) {
+    ti.tempo = *bpm;
+    ti.flags |= kVstTempoValid;
+  }
+  if (auto ppq = pos->getPpqPosition()) {
+    ti.ppqPos = *ppq;
+    ti.flags |= kVstPpqPosValid;
+  }
+  if (auto samples = pos->getTimeInSamples())
+    ti.samplePos = (double)*samples;
+  if (pos->getIsPlaying())
+    ti.flags |= kVstTransportPlaying;
+  if (pos->getIsLooping())
+    ti.flags |= kVstTransportCycleActive;
+  if (auto loop = pos->getLoopPoints()) {
+    ti.cycleStartPos = loop->ppqStart;
+    ti.cycleEndPos = loop->ppqEnd;
+    ti.flags |= kVstCyclePosValid;
+  }
+}
+
 const juce::String DtBlkFxAudioProcessor::getName() const
 {
   return JucePlugin_Name;
@@ -223,6 +321,7 @@ void DtBlkFxAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock
     core->setSampleRate(sampleRate);
     core->setBlockSize(samplesPerBlock);
     core->resume();
+    core->setNonRealtime(isNonRealtime());
   }
 
   juce::dsp::ProcessSpec spec;
@@ -241,6 +340,15 @@ void DtBlkFxAudioProcessor::releaseResources()
   }
 }
 
+void DtBlkFxAudioProcessor::setNonRealtime(bool isNonRealtime) noexcept
+{
+  // offline renders process the fft blks on worker threads
+  AudioProcessor::setNonRealtime(isNonRealtime);
+  if (core) {
+    core->setNonRealtime(isNonRealtime);
+  }
+}
+
 bool DtBlkFxAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
 {
 #if JucePlugin_IsMidiEffect
@@ -270,6 +378,7 @@ void DtBlkFxAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
 {
   juce::ignoreUnused(midiMessages);
 
+  RT_CHECK_SCOPE;
   juce::ScopedNoDenormals noDenormals;
   auto totalNumInputChannels = getTotalNumInputChannels();
   auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -284,6 +393,7 @@ void DtBlkFxAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer,
     buffer.clear(i, 0, buffer.getNumSamples());
 
   if (core) {
+    updateTimeInfo();
     core->processReplacing(
         buffer.getArrayOfWritePointers(), buffer.getArrayOfWritePointers(), buffer.getNumSamples());
   }
@@ -343,6 +453,7 @@ void DtBlkFxAudioProcessor::setStateInformation(const void* data, int sizeInByte
 
 void DtBlkFxAudioProcessor::pushInputSpectrogramData(const float* data, int numBins)
 {
+  RT_CHECK("lock");
   juce::ScopedLock lock(inputSpectrogramLock);
   if (inputSpectrogramData.size() != numBins)
     inputSpectrogramData.resize(numBins);
@@ -353,6 +464,7 @@ void DtBlkFxAudioProcessor::pushInputSpectrogramData(const float* data, int numB
 
 void DtBlkFxAudioProcessor::pushOutputSpectrogramData(const float* data, int numBins)
 {
+  RT_CHECK("lock");
   juce::ScopedLock lock(outputSpectrogramLock);
   if (outputSpectrogramData.size() != numBins)
     outputSpectrogramData.resize(numBins);
@@ -25,13 +25,15 @@
 
 class DtBlkFxAudioProcessor
     : public juce::AudioProcessor
-    , public juce::AudioProcessorValueTreeState::Listener {
+    , public juce::AudioProcessorValueTreeState::Listener
+    , private juce::Timer {
 public:
   DtBlkFxAudioProcessor();
   ~DtBlkFxAudioProcessor() override;
 
   void prepareToPlay(double sampleRate, int samplesPerBlock) override;
   void releaseResources() override;
+  void setNonRealtime(bool isNonRealtime) noexcept override;
 
   bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
 
@@ -91,6 +93,52 @@ public:
   static constexpr auto limiterReleaseId = "limiterRelease";
   static constexpr auto limiterEnabledId = "limiterEnabled";
 
+  // memo cache size in MB (0=off), applied to the core by the timer (it allocates)
+  static constexpr auto memoBudgetId = "memoBudget";
+
+  // lengthen the hop while the spectrum is steady (see DtBlkFx::setAdaptiveHop), applied to the
+  // core by the timer (it takes the core's lock)
+  static constexpr auto adaptiveHopId = "adaptiveHop";
+
+  // hit rate of the memo cache since the last reset
+  BlkMemo::Stats getMemoStats(bool reset = false) { return core->getMemoStats(reset); }
+
+  // blks per second of input over the last cost window (see timerCallback), this goes down while
+  // adaptive hop has lengthened the hop (message thread only)
+  double getBlkRate() const { return lastCost.blk_rate; }
+
+  // what the core is costing, for the editor's stats overlay: callback cost & blk rate over the
+  // last cost window, memory, memo cache hits & how differential resynthesis did the blks. The
+  // counts are since the last reset (message thread only)
+  struct EngineStats {
+    DtBlkFx::CallbackCost cost;
+    double callback_secs; // length of a host buffer (for the load)
+    bool adaptive_hop;
+    DtBlkFx::MemReport mem;
+    BlkMemo::Stats memo;
+    DtBlkFx::DiffStats diff;
+  };
+  void getEngineStats(EngineStats& /*out*/ r, bool reset = false);
+
 private:
+  // grows the core's buffers off the audio thread when a longer fft length has been asked for,
+  // applies the params that take the core's lock & reads the callback cost every COST_TICKS
+  void timerCallback() override;
+
+  // budget the core's memo cache was last sized for (MB)
+  int memoBudgetMb = 0;
+
+  // adaptive hop state last passed to the core
+  bool adaptiveHop = false;
+
+  // the timer is the only reader of the core's callback cost (it may only be read from one
+  // thread), this is the cost over the last COST_TICKS timer ticks
+  static constexpr int COST_TICKS = 5;
+  int costTicks = 0;
+  DtBlkFx::CallbackCost lastCost{};
+
+  // pass the host transport & loop to the core (see DtBlkFx::pollUpdate)
+  void updateTimeInfo();
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DtBlkFxAudioProcessor)
 };
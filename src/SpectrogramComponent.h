@@ -1,60 +1,76 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <juce_dsp/juce_dsp.h>
 #include <juce_gui_basics/juce_gui_basics.h>
+#include <vector>
 
-class SpectrogramComponent
-    : public juce::Component
-    , public juce::Timer {
+class SpectrogramComponent : public juce::Component {
 public:
+  // how the bins that fall within a single pixel row are combined
+  enum class BinReduce { max, mean };
+
   SpectrogramComponent(const juce::String& labelText)
       : label(labelText)
   {
     setOpaque(true);
-    startTimerHz(30); // Reduced from 60Hz
+    buildColourLut();
   }
 
-  ~SpectrogramComponent() override { stopTimer(); }
-
   void setLabel(const juce::String& newLabel)
   {
     label = newLabel;
     repaint();
   }
 
+  void setBinReduce(BinReduce newReduce) { reduce = newReduce; }
+
   void processPendingData(const float* data, int numBins)
   {
-    if (image.isNull())
+    if (image.isNull() || numBins < 2)
       return;
 
+    // rebuild the row->bin mapping when the fft length changes
+    if (numBins != mappedBins)
+      buildRowMap(numBins);
+
     // Write new column at currentX
     {
-      juce::Image::BitmapData bd(image, juce::Image::BitmapData::writeOnly);
-      int x = currentX;
+      juce::Image::BitmapData bd(image, currentX, 0, 1, image.getHeight(),
+                                 juce::Image::BitmapData::writeOnly);
 
+      const int* edge = rowEdges.data();
       for (int y = 0; y < bd.height; ++y) {
-        // Map y to frequency bin
-        int bin = juce::jmap(y, 0, bd.height, numBins - 1, 0);
-        float magnitude = data[bin];
-
-        // Map magnitude (energy) to color
-        // Data is now magnitude squared, so use 10*log10(x) or gainToDecibels(x)/2
-        float db = juce::Decibels::gainToDecibels(magnitude) * 0.5f;
-        float level = juce::jmap(db, -100.0f, 0.0f, 0.0f, 1.0f);
-        level = juce::jlimit(0.0f, 1.0f, level);
-
-        // Increase contrast: power curve to darken lows and brighten highs
-        level = std::pow(level, 3.0f);
-
-        juce::Colour c = juce::Colour::fromFloatRGBA(level, level, level, 1.0f);
-
-        bd.setPixelColour(x, y, c);
+        // rows run from the highest frequency at the top to the lowest at the bottom, rows finer
+        // than the bin spacing repeat the nearest bin
+        const float* bin = data + edge[y + 1];
+        const float* binEnd = data + juce::jmax(edge[y], edge[y + 1] + 1);
+
+        float pwr = *bin++;
+        if (reduce == BinReduce::max) {
+          for (; bin < binEnd; ++bin)
+            if (*bin > pwr)
+              pwr = *bin;
+        }
+        else {
+          int n = (int)(binEnd - bin) + 1;
+          for (; bin < binEnd; ++bin)
+            pwr += *bin;
+          pwr /= (float)n;
+        }
+
+        reinterpret_cast<juce::PixelARGB*>(bd.getLinePointer(y))->set(colourLut[lutIndex(pwr)]);
       }
     }
 
+    // only the column we just wrote needs repainting (this is a wiping display, not scrolling)
+    repaint(currentX, 0, 1, getHeight());
+
     // Advance and wrap
     currentX = (currentX + 1) % getWidth();
-    repaint();
   }
 
   void paint(juce::Graphics& g) override
@@ -65,35 +81,8 @@ public:
     int w = getWidth();
     int h = getHeight();
 
-    // Draw in two chunks to create scrolling effect from circular buffer
-    // Chunk 1: Oldest data (from currentX to end) drawn at left
-    int rightChunkWidth = w - currentX;
-    if (rightChunkWidth > 0) {
-      g.drawImage(image,
-                  0,
-                  0,
-                  rightChunkWidth,
-                  h, // Dest
-                  currentX,
-                  0,
-                  rightChunkWidth,
-                  h // Source
-      );
-    }
-
-    // Chunk 2: Newest data (from 0 to currentX) drawn at right
-    if (currentX > 0) {
-      g.drawImage(image,
-                  rightChunkWidth,
-                  0,
-                  currentX,
-                  h, // Dest
-                  0,
-                  0,
-                  currentX,
-                  h // Source
-      );
-    }
+    // image is laid out 1:1 with the component, the clip region limits this to the dirty strip
+    g.drawImageAt(image, 0, 0);
 
     // Draw Label
     g.setColour(juce::Colours::white);
@@ -108,17 +97,106 @@ public:
 
   void resized() override
   {
-    image = juce::Image(juce::Image::RGB, getWidth(), getHeight(), true);
+    image = juce::Image(juce::Image::ARGB, getWidth(), getHeight(), true);
     image.clear(getLocalBounds(), juce::Colours::black);
     currentX = 0;
-  }
 
-  void timerCallback() override {}
+    // row map depends on height
+    mappedBins = 0;
+  }
 
 private:
+  //-----------------------------------------------------------------------------------------------
+  // The colour LUT is indexed directly by the bits of the (positive) float power value: exponent
+  // plus the top LUT_MANT_BITS of the mantissa, giving 2^LUT_MANT_BITS steps per octave of power
+  // without calling log/pow per pixel.
+  enum { LUT_MANT_BITS = 3, LUT_SHIFT = 23 - LUT_MANT_BITS };
+
+  static uint32_t floatBits(float v)
+  {
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+  }
+
+  static float bitsFloat(uint32_t bits)
+  {
+    float v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+
+  int lutIndex(float pwr) const
+  {
+    // also catches 0, negative & NaN
+    if (!(pwr > lutMinPwr))
+      return 0;
+    int i = (int)(floatBits(pwr) >> LUT_SHIFT) - lutBase;
+    return i < lutSize ? i : lutSize - 1;
+  }
+
+  void buildColourLut()
+  {
+    // -100dB .. 0dB of power spans the colour range (as before)
+    lutMinPwr = juce::Decibels::decibelsToGain(-100.0f * 2.0f);
+    lutBase = (int)(floatBits(lutMinPwr) >> LUT_SHIFT);
+    lutSize = (int)(floatBits(1.0f) >> LUT_SHIFT) - lutBase + 1;
+
+    colourLut.resize((size_t)lutSize);
+    for (int i = 0; i < lutSize; ++i) {
+      // power at the centre of this LUT step
+      uint32_t bits = ((uint32_t)(i + lutBase) << LUT_SHIFT) | (1u << (LUT_SHIFT - 1));
+      float pwr = i == 0 ? 0.0f : bitsFloat(bits);
+
+      // Data is magnitude squared, so use gainToDecibels(x)/2
+      float db = juce::Decibels::gainToDecibels(pwr) * 0.5f;
+      float level = juce::jlimit(0.0f, 1.0f, juce::jmap(db, -100.0f, 0.0f, 0.0f, 1.0f));
+
+      // Increase contrast: power curve to darken lows and brighten highs
+      level = level * level * level;
+
+      colourLut[(size_t)i] = juce::Colour::fromFloatRGBA(level, level, level, 1.0f).getPixelARGB();
+    }
+  }
+
+  //-----------------------------------------------------------------------------------------------
+  void buildRowMap(int numBins)
+  // generate log-frequency row to bin-range mapping (like PixelFreqBin), rowEdges[y] is the
+  // first bin of row y counting from the bottom and rowEdges[y+1] is one past its last bin
+  // (rows narrower than a bin get an empty range which is widened to one bin when drawing)
+  {
+    int h = image.getHeight();
+    int maxBin = numBins - 1;
+    rowEdges.resize((size_t)h + 1);
+
+    // bottom row starts at bin 1 (skip DC), top row ends at nyquist
+    float octaves = std::log2((float)maxBin);
+    for (int y = 0; y <= h; ++y) {
+      int bin = juce::roundToInt(std::exp2(octaves * (float)y / (float)h));
+      rowEdges[(size_t)y] = juce::jlimit(1, maxBin, bin);
+    }
+    rowEdges[(size_t)h] = maxBin + 1;
+
+    // flip so that the column loop can walk y downwards from the top of the image
+    std::reverse(rowEdges.begin(), rowEdges.end());
+    mappedBins = numBins;
+  }
+
   juce::Image image;
   int currentX = 0;
   juce::String label;
 
+  BinReduce reduce = BinReduce::max;
+
+  // bin edges for each pixel row (top row first), rebuilt when numBins or height change
+  std::vector<int> rowEdges;
+  int mappedBins = 0;
+
+  // power to colour lookup
+  std::vector<juce::PixelARGB> colourLut;
+  float lutMinPwr = 0.0f;
+  int lutBase = 0;
+  int lutSize = 0;
+
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrogramComponent)
 };
@@ -47,7 +47,12 @@ typedef enum {
   NUM_FX_PARAMS,
 
   NUM_FX_SETS = 8,
-  TOTAL_NUM = NUM_GLOBAL_PARAMS + NUM_FX_PARAMS * NUM_FX_SETS,
+
+  // global params added since 1.0 go after the fx sets so that older chunks & presets line up
+  EXT_GLOBAL_PARAMS = NUM_GLOBAL_PARAMS + NUM_FX_PARAMS * NUM_FX_SETS,
+  WOLA = EXT_GLOBAL_PARAMS, // weighted overlap-add window (0=cross-faded blks)
+  FREEZE,                   // spectral freeze & the phase of the frozen bins (0=off)
+  TOTAL_NUM,
 
   // number of ticks per beat
   TICKS_PER_BEAT = 16,
@@ -86,7 +91,7 @@ struct SplitParamNum {
 
     ok = true;
     fx_set = param_num - NUM_GLOBAL_PARAMS;
-    if (fx_set < 0) {
+    if (fx_set < 0 || param_num >= EXT_GLOBAL_PARAMS) {
       // global param
       fx_set = -1;
       glob_param = param_num;
@@ -214,6 +219,65 @@ inline float /*0..1*/ getOverlapParam(float /*0..1*/ overlap_part, bool sync)
               : limit_range(overlap_part * 0.5f, 0.0f, 0.499f);
 }
 
+// --- WOLA
+// ---------------------------------------------------------------------------------------------
+// the param picks the window & the hop of weighted overlap-add blks (the window only overlap-adds
+// to a constant at these), in order: off (cross-faded blks), hann at a hop of 1/2 & 1/4 of the
+// blk, kaiser at 1/2 & 1/4
+enum { NUM_WOLA_WDW = 3, NUM_WOLA_MODES = 1 + 2 * (NUM_WOLA_WDW - 1) };
+
+inline int /*0..NUM_WOLA_MODES-1*/ getWolaMode(float /*0..1*/ wola_param)
+{
+  return limit_range((int)(wola_param * (float)NUM_WOLA_MODES), 0, NUM_WOLA_MODES - 1);
+}
+
+inline int /*0=off, 1=hann, 2=kaiser*/ getWolaWdw(float /*0..1*/ wola_param)
+// window type from the wola param (same order as DtBlkFx::WOLA_*)
+{
+  int mode = getWolaMode(wola_param);
+  return mode ? 1 + (mode - 1) / 2 : 0;
+}
+
+inline int /*2 or 4*/ getWolaHopDiv(float /*0..1*/ wola_param)
+// hop is the blk length divided by this
+{
+  int mode = getWolaMode(wola_param);
+  return mode && (mode - 1) % 2 == 0 ? 2 : 4;
+}
+
+inline long getWolaHop(float /*0..1*/ wola_param, long blk_len)
+// return the hop between weighted overlap-add blks
+{
+  return blk_len / getWolaHopDiv(wola_param);
+}
+
+inline float /*0..1*/ getWolaParam(int wdw, int hop_div = 4)
+// param value in the middle of window type "wdw" (0 for off) at a hop of blk/"hop_div" (2 or 4)
+{
+  if (wdw <= 0)
+    return 0.0f;
+  int mode = 1 + 2 * (limit_range(wdw, 1, NUM_WOLA_WDW - 1) - 1) + (hop_div <= 2 ? 0 : 1);
+  return ((float)mode + 0.5f) / (float)NUM_WOLA_MODES;
+}
+
+// --- FREEZE
+// ---------------------------------------------------------------------------------------------
+enum { NUM_FREEZE_MODES = 4 };
+
+inline int /*0=off, 1=hold, 2=advance, 3=random*/ getFreezeMode(float /*0..1*/ freeze_param)
+// freeze mode from the param (1 + DtBlkFx::FREEZE_PHASE_* when on)
+{
+  return limit_range((int)(freeze_param * (float)NUM_FREEZE_MODES), 0, NUM_FREEZE_MODES - 1);
+}
+
+inline float /*0..1*/ getFreezeParam(int mode)
+// param value in the middle of "mode" (0 for off)
+{
+  if (mode <= 0)
+    return 0.0f;
+  return ((float)limit_range(mode, 1, NUM_FREEZE_MODES - 1) + 0.5f) / (float)NUM_FREEZE_MODES;
+}
+
 // --- FX_FREQ_A/FX_FREQ_B --------------------------------------------------------------------
 // freq params correspond to exponential frequency which means that octaves are
 // linear and the param is actually a note offset from c0
@@ -0,0 +1,191 @@
+#ifndef _DT_BLK_MEMO_H_
+#define _DT_BLK_MEMO_H_
+/**************************************************************************************************
+Bounded cache of processed fft blks keyed by a hash of everything that went into them
+
+Entries are packed into one arena that is used as a ring so the oldest entries are overwritten
+first. Nothing is allocated after setBudget() so lookups & inserts are safe in the audio thread.
+An index entry is only valid while the arena data it points to hasn't been overwritten (the arena
+position is a running count so this is a single compare).
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+//-------------------------------------------------------------------------------------------------
+struct BlkHash
+// 64 bit hash built up from words (multiply-xorshift, not cryptographic)
+{
+  uint64_t h;
+  BlkHash() { h = 0x9e3779b97f4a7c15ULL; }
+
+  void add(uint64_t v)
+  {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+  }
+  void add(float v)
+  {
+    uint32_t w;
+    memcpy(&w, &v, sizeof(w));
+    add((uint64_t)w);
+  }
+
+  // add "n" floats (two at a time)
+  void add(const float* x, long n)
+  {
+    long i = 0;
+    for (; i + 1 < n; i += 2) {
+      uint64_t w;
+      memcpy(&w, x + i, sizeof(w));
+      add(w);
+    }
+    if (i < n)
+      add(x[i]);
+  }
+};
+
+//*************************************************************************************************
+class BlkMemo {
+public:
+  struct Stats {
+    long lookups, hits;
+    long inserts; // including ones that have since been overwritten
+    size_t budget_bytes;
+  };
+
+  BlkMemo()
+  {
+    _write_total = 0;
+    _stats.lookups = _stats.hits = _stats.inserts = 0;
+    _stats.budget_bytes = 0;
+  }
+
+  // size the cache to about "bytes" (0 turns it off) & empty it, allocates so don't call from the
+  // audio thread
+  void setBudget(size_t bytes)
+  {
+    size_t n_floats = bytes / sizeof(float);
+    _arena.assign(n_floats, 0.0f);
+
+    // an index slot per 4k floats (a typical stereo blk is much bigger than this)
+    size_t n_slots = 64;
+    while (n_slots < n_floats / 4096)
+      n_slots <<= 1;
+    _index.assign(n_floats ? n_slots : 0, Slot());
+    _write_total = 0;
+    _stats.budget_bytes = n_floats * sizeof(float);
+  }
+
+  bool on() const { return !_arena.empty(); }
+
+  // return the data stored with "key" (of "n" floats) or NULL if it's not there
+  const float* find(uint64_t key, long n)
+  {
+    _stats.lookups++;
+    Slot* s = findSlot(key);
+    if (!s || s->n != n || !valid(*s))
+      return NULL;
+    _stats.hits++;
+    return &_arena[s->offs];
+  }
+
+  // make space for "n" floats for "key" (overwriting the oldest entries), the caller fills the
+  // returned data. Returns NULL if "n" is more than the whole arena
+  float* insert(uint64_t key, long n)
+  {
+    if (n <= 0 || (size_t)n > _arena.size() || _index.empty())
+      return NULL;
+
+    // entries are contiguous, skip the end of the arena if it doesn't fit
+    size_t offs = (size_t)(_write_total % _arena.size());
+    if (offs + n > _arena.size())
+      _write_total += _arena.size() - offs;
+
+    // slot to use: the one with this key, an invalid one or the oldest in the probe range
+    Slot* s = findSlot(key);
+    if (!s) {
+      s = &_index[key & (_index.size() - 1)];
+      for (int i = 0; i < PROBE_N; i++) {
+        Slot* t = &_index[(key + i) & (_index.size() - 1)];
+        if (!valid(*t)) {
+          s = t;
+          break;
+        }
+        if (t->start < s->start)
+          s = t;
+      }
+    }
+    s->key = key;
+    s->n = n;
+    s->start = _write_total;
+    s->offs = (size_t)(_write_total % _arena.size());
+    _write_total += n;
+    _stats.inserts++;
+    return &_arena[s->offs];
+  }
+
+  // forget "key" (data inserted for a blk that wasn't finished)
+  void remove(uint64_t key)
+  {
+    Slot* s = findSlot(key);
+    if (s)
+      s->n = 0;
+  }
+
+  // hit rate & budget, optionally starting the counts again
+  Stats getStats(bool reset = false)
+  {
+    Stats r = _stats;
+    if (reset)
+      _stats.lookups = _stats.hits = _stats.inserts = 0;
+    return r;
+  }
+
+protected:
+  enum { PROBE_N = 8 };
+
+  struct Slot {
+    uint64_t key;
+    uint64_t start; // _write_total when the entry was written
+    size_t offs;    // position in _arena
+    long n;         // 0 = empty
+    Slot() { key = start = offs = n = 0; }
+  };
+
+  // data in the arena is only valid until it has been written over
+  bool valid(const Slot& s) const { return s.n > 0 && _write_total - s.start <= _arena.size(); }
+
+  Slot* findSlot(uint64_t key)
+  {
+    if (_index.empty())
+      return NULL;
+    for (int i = 0; i < PROBE_N; i++) {
+      Slot* s = &_index[(key + i) & (_index.size() - 1)];
+      if (s->n > 0 && s->key == key)
+        return s;
+    }
+    return NULL;
+  }
+
+  std::vector<float> _arena;
+  std::vector<Slot> _index;
+
+  // total floats written to the arena (including skipped ends)
+  uint64_t _write_total;
+
+  Stats _stats;
+};
+
+#endif
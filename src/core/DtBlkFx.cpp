@@ -10,7 +10,7 @@ General algorithm is:
 3. run an effect from FFTFx()
 4. IFFT data from _x1 to _x2
 5. mix data from _x2 into _x3 (output buffer), doing a cross fade with any overlap of data
-   already in there
+   already in there (or adding to it for weighted overlap-add blks)
 
 History
   Date		Version Programmer		Comments
@@ -29,12 +29,26 @@ General Public License for more details.
 ***************************************************************************************************/
 // // #include <StdAfx.h>
 
+#include <chrono>
 #include <stdio.h>
 #include <string.h>
+#include <vector>
+
+#ifdef _WIN32
+#elif defined(__APPLE__)
+#  include <mach/mach.h>
+#  include <mach/mach_time.h>
+#  include <mach/thread_policy.h>
+#  include <pthread.h>
+#else
+#  include <pthread.h>
+#  include <sched.h>
+#endif
 
 #include "WrapProcessFloatVec.h"
 
 #include "DtBlkFx.hpp"
+#include "StftCache.h"
 // #include "Gui.h"
 #include "rfftw_float.h"
 
@@ -106,6 +120,15 @@ enum {
 // from BlkFxMain.cpp
 extern bool GlobalInitOk();
 
+// from FxRun1_0.cpp, random state used by some of the effects
+extern thread_local long g_rand_i;
+
+// count of instances sharing the blk scratch (see BlkScratchPool)
+static void BlkScratchInstances(int add);
+
+// free an instance's own scratch (see DtBlkFx::_own_scratch)
+static void BlkScratchFree(BlkScratch* s);
+
 //-------------------------------------------------------------------------------------------------
 DtBlkFx::DtBlkFx(audioMasterCallback audioMaster)
     : AudioEffectX(audioMaster,
@@ -132,22 +155,33 @@ DtBlkFx::DtBlkFx(audioMasterCallback audioMaster)
   //
   configParams1_0();
 
-  // get buffer space
-  _x0_sz = X0_INDEX_ROUNDING_MASK & (8 * 44100); // length of buffer is arbitrary
-  _x0_force_out_sz = _x0_sz - MAX_FFT_SZ;        // force output when x0 contains this much data
-  _x3_sz = 5 * 44100;
-  for (i = 0; i < AUDIO_CHANNELS; i++) {
-    _chan[i].x0.resize(
-        _x0_sz + MAX_FFT_SZ); // input buffer with extra space at end to unwrap data for processing
-    _chan[i].x1.resize(MAX_FFT_SZ / 2 +
-                       32 * 2); // FFT'd complex data with space either side for shift overflow
-    _chan[i].x2.resize(
-        MAX_FFT_SZ +
-        32 * 2); // inverse FFT & temporary buffer with space either side for shift overflow
-    _chan[i].x3.resize(
-        _x3_sz); // output buffer (length is arbitrary, as long as > MAX_FFT_SZ plus a few)
-  }
-  _max_delay_n = _x3_sz - MAX_FFT_SZ - 2048;
+  // x0 & x3 are sized for the sample rate by sizeBufs() (from resume)
+  _x0_sz = _x0_force_out_sz = _x3_sz = 0;
+  _bufs_sample_rate = 0.0f;
+  _max_buf_n = 2048;
+  _bufs_buf_n = 0;
+  for (i = 0; i < AUDIO_CHANNELS; i++)
+    _chan[i].fft = NULL;
+
+  // x1 is sized by reserveBlk() according to the fft length in use, x2 is shared scratch
+  _blk_alloc_n = 0;
+  _blk_alloc_plan = -1;
+  _blk_req_plan = 0;
+  _scratch_set = -1;
+  _scratch = NULL;
+  _own_scratch = NULL;
+  _scratch_misses = 0;
+  BlkScratchInstances(+1);
+
+  // not frozen, xf isn't allocated until freeze is used
+  _freeze = false;
+  _freeze_phase = FREEZE_PHASE_HOLD;
+  _freeze_fft_n = _freeze_abs = 0;
+  _freeze_alloc_n = 0;
+  _freeze_rand_i = 1;
+  for (int i = 0; i < AUDIO_CHANNELS; i++)
+    _chan[i].freeze_pwr = 0.0f;
+  _max_delay_n = 0;
 
   // copy presets into the program
   _program.reserve(/*AudioEffect::*/ numPrograms);
@@ -171,6 +205,98 @@ DtBlkFx::DtBlkFx(audioMasterCallback audioMaster)
   _initial_delay = 0;
   setInitialDelay(_initial_delay);
 
+  // rendering from the start of the signal
+  _samp_abs_origin = 0;
+
+  // per-channel ffts by default
+  _stereo_pack = false;
+
+  // full rate processing by default
+  _decim = false;
+  _decim_n = 1;
+  _decim_plan = 0;
+  _decim_alloc_n = 0;
+  for (int i = 0; i < AUDIO_CHANNELS; i++)
+    _chan[i].hi_pwr = 0.0f;
+
+  // full inverse ffts by default
+  _diff_resynth = false;
+  _diff_blk = false;
+  _diff_alloc_n = 0;
+  _diff_stats.full = _diff_stats.resonator = _diff_stats.pruned = 0;
+
+  // hop from the overlap param only by default
+  _adapt_hop = false;
+  _adapt_hop_flux = 0.15f;
+  _adapt_hop_min_overlap = 0.1f;
+  _adapt_hop_fft_n = 0;
+  _adapt_hop_stable = false;
+  _adapt_hop_n = 0;
+  Clear(_adapt_hop_band, ADAPT_HOP_BANDS);
+
+  // fft length from the FFT_LEN param only by default
+  _adapt_len = false;
+  _adapt_plan_reduce = 12;
+  _adapt_thresh = powf(10.0f, 0.9f); // 9 dB, as setAdaptiveLen
+
+  // cross-faded blks by default, _wola_wdw isn't allocated until wola is used
+  _wola = WOLA_OFF;
+  _wola_hop_div = 4;
+  _wola_blk = false;
+  _wola_fft_n = _wola_hop_n = 0;
+  _wola_wdw_type = WOLA_OFF;
+  _wola_scale = 1.0f;
+  _wola_alloc_n = 0;
+  _wola_run_start = false;
+  _mix_keep_n = _mix_tail_n = _mix_tail_j = 0;
+
+  // no offline analysis cache until the offline renderer sets one
+  _stft_cache = NULL;
+
+  // no memo cache by default
+  _memo_key = 0;
+  _memo_n = _memo_time_n = 0;
+  _memo_hit = NULL;
+  _memo_store = NULL;
+
+  // identical channels are only transformed once
+  _dual_mono = false;
+
+  // multi-res mode is off by default
+  _multires = false;
+  _multires_xover_hz = 800.0f;
+  _multires_plan_reduce = 8;
+
+  // amortized processing is off by default
+  _amortize = false;
+  _callback_max_secs = 0.0;
+  _callback_sum_secs = 0.0;
+  _callback_n = 0;
+  _callback_max_reset = false;
+  _callback_blk_n = 0;
+  _callback_samp_n = 0.0;
+  _callback_sum_base = _callback_samp_base = 0.0;
+  _callback_n_base = _callback_blk_base = 0;
+
+  // asynchronous processing is off by default
+  _async = false;
+  _async_delay_n = 0;
+  _async_pub_abs = 0;
+  _async_skip = 0;
+  _async_xruns = 0;
+  _async_quit = false;
+  _async_rt_priority = false;
+  _async_params.init(1024);
+  _async_host_abs = 0;
+  _async_idle = false;
+
+  // blks are processed here until the host renders offline
+  _nonrealtime = false;
+  _nrt_head = _nrt_n = 0;
+  _nrt_state = NRT_FREE;
+  _nrt_out_n = 0;
+  _nrt_quit = false;
+
   // these were registered from steinberg
   if (AUDIO_CHANNELS == 2)
     setUniqueID('h526');
@@ -184,12 +310,17 @@ DtBlkFx::DtBlkFx(audioMasterCallback audioMaster)
   _params.put(/*samp abs*/ 0, BlkFxParam::FFT_LEN, BlkFxParam::getFFTLenParam(16));
   _params.put(/*samp abs*/ 0, BlkFxParam::OVERLAP, 0.35f);
 
-  resume(); // flush buffer
+  resume(); // size & flush buffers
 }
 
 //-------------------------------------------------------------------------------------------------
 DtBlkFx::~DtBlkFx()
 {
+  nrtStop();
+  asyncStop();
+  BlkScratchInstances(-1);
+  BlkScratchFree(_own_scratch);
+
   // make sure gui is closed, probably don't need to
   // TODO: check whether we need to do this
   // if (gui())
@@ -285,9 +416,14 @@ void DtBlkFx::init()
 
   _x3_o = 0;       // output FIFO output index
   _x3_end_abs = 0; // no data in _x3
-
-  // clear the output buffers
-  for (i = 0; i < AUDIO_CHANNELS; i++)
+  _x3_tail_abs = 0;
+  _out_final_abs = 0;
+  _stereo_diff_abs = 0; // x0 is cleared so the channels are the same
+  _dual_mono_blk = false;
+  _dual_mono_fx = false;
+
+  // clear the output buffers (not sized until the first resume)
+  for (i = 0; i < AUDIO_CHANNELS && _x3_sz; i++)
     Clear(_chan[i].x3);
 
   _x3_is_clear = true;
@@ -296,6 +432,7 @@ void DtBlkFx::init()
   _prev_poll_abs = 0;
   _samps_per_poll = 0;
   _beat_start_abs = 0;
+  _loop_start_abs = _loop_n = 0;
 
   _params_state = PARAMS_CHK_SYNC;
   _params_need_processing = true;
@@ -303,6 +440,207 @@ void DtBlkFx::init()
   // these variables will be updated on first paramsChk()
   _dst_fft_abs = 0;
   _freq_fft_n = 4096;
+
+  _multires_blk = false;
+  _decim_n = 1;
+  _blk_stage = BLK_IDLE;
+
+  // a blk that was being stored isn't complete
+  if (_memo_store)
+    _memo.remove(_memo_key);
+  _memo_store = NULL;
+  _memo_hit = NULL;
+
+  // blks in flight are for the old input
+  nrtDrop();
+
+  // forget pitches tracked by the effects
+  for (i = 0; i < BlkFxParam::NUM_FX_SETS; i++)
+    _fx1_0[i].resetTracking();
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setMultiRes(bool on, float xover_hz, long plan_reduce)
+// turn multi-resolution processing on or off, "xover_hz" is the split between the long & short
+// fft bands and "plan_reduce" is how many plans shorter the high band fft is (4 plans per octave),
+// turning it on may allocate
+{
+  {
+    ScopeCriticalSection scs(_protect);
+    _multires = on;
+    _multires_xover_hz = max(xover_hz, 1.0f);
+    _multires_plan_reduce = limit_range(plan_reduce, 1L, (long)NUM_FFT_SZ - 1);
+  }
+  if (on)
+    reserveBlk();
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setStereoPack(bool on)
+// turning it on may allocate
+{
+  {
+    ScopeCriticalSection scs(_protect);
+    _stereo_pack = on && AUDIO_CHANNELS == 2;
+  }
+  if (on)
+    reserveBlk();
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setDecimate(bool on)
+// turning it on may allocate
+{
+  {
+    ScopeCriticalSection scs(_protect);
+    _decim = on;
+  }
+  if (on)
+    reserveBlk();
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setDiffResynth(bool on)
+// turning it on may allocate
+{
+  {
+    ScopeCriticalSection scs(_protect);
+    _diff_resynth = on;
+  }
+  if (on)
+    reserveBlk();
+}
+
+//-------------------------------------------------------------------------------------------------
+DtBlkFx::DiffStats DtBlkFx::getDiffStats(bool reset)
+{
+  ScopeCriticalSection scs(_protect);
+  DiffStats r = _diff_stats;
+  if (reset)
+    _diff_stats.full = _diff_stats.resonator = _diff_stats.pruned = 0;
+  return r;
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setFreeze(bool on, int phase)
+// turning freeze on captures the next blk
+{
+  setParameter(BlkFxParam::FREEZE, BlkFxParam::getFreezeParam(on ? phase + 1 : 0));
+  if (on)
+    reserveBlk();
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setWola(int wdw, int hop_div)
+// turning it on may allocate
+{
+  setParameter(BlkFxParam::WOLA, BlkFxParam::getWolaParam(wdw, hop_div));
+  if (wdw > WOLA_OFF)
+    reserveBlk();
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setAdaptiveLen(bool on, long plan_reduce, float thresh_db)
+{
+  ScopeCriticalSection scs(_protect);
+  _adapt_len = on;
+  _adapt_plan_reduce = limit_range(plan_reduce, 1L, (long)NUM_FFT_SZ - 1);
+  _adapt_thresh = powf(10.0f, max(thresh_db, 0.0f) / 10.0f);
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setAdaptiveHop(bool on, float flux, float min_overlap)
+{
+  ScopeCriticalSection scs(_protect);
+  _adapt_hop = on;
+  _adapt_hop_flux = max(flux, 0.0f);
+  _adapt_hop_min_overlap = limit_range(min_overlap, 0.0f, 1.0f);
+  _adapt_hop_fft_n = 0;
+  _adapt_hop_stable = false;
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setMemoBudget(size_t bytes)
+{
+  // allocate outside of the lock
+  BlkMemo memo;
+  memo.setBudget(bytes);
+
+  ScopeCriticalSection scs(_protect);
+  std::swap(_memo, memo);
+  _memo_store = NULL;
+  _memo_hit = NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+BlkMemo::Stats DtBlkFx::getMemoStats(bool reset)
+{
+  ScopeCriticalSection scs(_protect);
+  return _memo.getStats(reset);
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setDualMono(bool on)
+{
+  ScopeCriticalSection scs(_protect);
+
+  // the input wasn't compared while off, treat the channels as different up to now
+  if (on && !_dual_mono)
+    _stereo_diff_abs = _curr_samp_abs;
+  _dual_mono = on;
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setAmortize(bool on)
+// turn amortized blk processing on or off, a blk already in progress is finished off as normal
+{
+  ScopeCriticalSection scs(_protect);
+  _amortize = on;
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setAsync(bool on, long extra_delay_n)
+// turn asynchronous processing on or off (see _async), restarts the output so there's a dropout
+// if this is done while playing
+{
+  asyncStop();
+  _async = on;
+  _async_delay_n = max(extra_delay_n, 0L);
+  if (_async)
+    asyncStart();
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::getCallbackCost(CallbackCost& /*out*/ r, bool reset)
+// return the time spent per callback since the last reset & optionally start measuring again
+// (call from one thread only)
+{
+  long n = _callback_n.load() - _callback_n_base;
+  double sum_secs = _callback_sum_secs.load() - _callback_sum_base;
+  long blk_n = _callback_blk_n.load() - _callback_blk_base;
+  double samp_n = _callback_samp_n.load() - _callback_samp_base;
+
+  r.max_secs = _callback_max_reset.load() ? 0.0 : _callback_max_secs.load();
+  r.avg_secs = n ? sum_secs / (double)n : 0.0;
+  r.callbacks = n;
+  r.blk_rate = samp_n > 0.0 ? (double)blk_n * sampleRate / samp_n : 0.0;
+  if (reset) {
+    _callback_n_base += n;
+    _callback_sum_base += sum_secs;
+    _callback_blk_base += blk_n;
+    _callback_samp_base += samp_n;
+    _callback_max_reset = true;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::addCallbackCost(double secs)
+// internal method
+{
+  double max_secs = _callback_max_reset.exchange(false) ? 0.0 : _callback_max_secs.load();
+  _callback_max_secs.store(max(max_secs, secs), std::memory_order_relaxed);
+  _callback_sum_secs.store(_callback_sum_secs.load() + secs, std::memory_order_relaxed);
+  _callback_n.store(_callback_n.load() + 1, std::memory_order_relaxed);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -321,7 +659,7 @@ VstInt32 DtBlkFx::getChunk(void** vdata, bool is_preset)
   int payload_bytes =
       PackedBytesPerVstProgram(BlkFxParam::TOTAL_NUM) * (num_programs + 1 /*curr params*/);
   _chunk_data.resize(/*tag field*/ 4 + /*vers field*/ 4 + /*n programs field*/ 4 +
-                     /*curr program field*/ 4 + payload_bytes);
+                     /*curr program field*/ 4 + /*n params field*/ 4 + payload_bytes);
 
   // cast to what we need
   LittleEndianMemStr le_data(_chunk_data);
@@ -330,7 +668,7 @@ VstInt32 DtBlkFx::getChunk(void** vdata, bool is_preset)
   le_data.put32((int)CHUNK_TAG);
 
   // version
-  le_data.put32(101);
+  le_data.put32(102);
 
   // number of programs
   le_data.put32(num_programs);
@@ -338,6 +676,9 @@ VstInt32 DtBlkFx::getChunk(void** vdata, bool is_preset)
   // current program
   le_data.put32(is_preset ? 0 : currProgramNum());
 
+  // number of params in each program (params are only ever added to the end)
+  le_data.put32((int)BlkFxParam::TOTAL_NUM);
+
   // grab current settings & save
   VstProgram<BlkFxParam::TOTAL_NUM> curr_program;
   curr_program.name = currProgram().name;
@@ -350,7 +691,7 @@ VstInt32 DtBlkFx::getChunk(void** vdata, bool is_preset)
     // save all presets
     LOG("", "DtBlkFx::getChunk saving" << VAR(chunk_data->num_programs));
     for (i = 0; i < num_programs; i++)
-      _program[i].saveLittleEndian(&le_data, 4 + 5 * 8);
+      _program[i].saveLittleEndian(&le_data, BlkFxParam::TOTAL_NUM);
   }
 
   *vdata = &_chunk_data[0];
@@ -388,19 +729,26 @@ VstInt32 /*1=success*/ DtBlkFx::setChunk(void* vdata, VstInt32 n_bytes, bool isP
   }
 
   // these versions are nearly the same
-  if (vers == 100 || vers == 101) {
+  if (vers == 100 || vers == 101 || vers == 102) {
     int32_t num_programs;
     if (!le_data.get32(&num_programs))
       return 0;
 
     int32_t curr_program;
-    if (vers == 101)
+    if (vers >= 101)
       if (!le_data.get32(&curr_program))
         return 0;
 
     int num_params = 4 + 5 * 4; // vers 100 num params: 4 effects
     if (vers == 101)
       num_params = 4 + 5 * 8; // 8 effects
+    if (vers == 102) {
+      // 8 effects & the global params after them, as many as there were when it was saved
+      int32_t n;
+      if (!le_data.get32(&n) || n < 4 + 5 * 8)
+        return 0;
+      num_params = n;
+    }
 
     //
     if (isPreset) {
@@ -424,7 +772,7 @@ VstInt32 /*1=success*/ DtBlkFx::setChunk(void* vdata, VstInt32 n_bytes, bool isP
 
       // calculate the number of programs based on the number of bytes
       num_programs =
-          min((int32_t)(le_data.n / PackedBytesPerVstProgram(num_programs)), num_programs);
+          min((int32_t)(le_data.n / PackedBytesPerVstProgram(num_params)), num_programs);
 
       // don't load more than what we have space for
       num_programs = min(max_num_programs, num_programs);
@@ -439,7 +787,7 @@ VstInt32 /*1=success*/ DtBlkFx::setChunk(void* vdata, VstInt32 n_bytes, bool isP
         _program[i - 1].setName("unnamed");
 
       // determine current program
-      if (vers == 101)
+      if (vers >= 101)
         AudioEffect::curProgram = curr_program;
       else
         // current program number is stored as the name of the "curr" params
@@ -502,7 +850,13 @@ void DtBlkFx::resume()
   LOG("", "DtBlkFx::resume");
   AudioEffectX::resume();
 
-  ScopeCriticalSection scs(_protect);
+  // everything the audio thread needs is allocated here
+  sizeBufs();
+  reserveBlk();
+
+  if (_async)
+    asyncStart();
+
   // if (gui())
   //   gui()->resume();
 }
@@ -515,6 +869,9 @@ void DtBlkFx::suspend()
   LOG("", "DtBlkFx::suspend");
   AudioEffectX::suspend();
 
+  // worker takes _protect so has to be stopped first
+  asyncStop();
+
   ScopeCriticalSection scs(_protect);
 
   // roll back params to just contain most recent and reset sample position
@@ -533,7 +890,11 @@ void DtBlkFx::setBlockSize(VstInt32 sz)
 // called by vst-host to indicate max number of samples that will be passed to process
 {
   AudioEffectX::setBlockSize(sz);
-  _max_delay_n = _x3_sz - MAX_FFT_SZ - sz;
+
+  // buffers are sized for it on resume(), until then keep the delay inside x3
+  _max_buf_n = max((long)sz, 1L);
+  if (_x3_sz)
+    _max_delay_n = min(_max_delay_n, _x3_sz - MAX_FFT_SZ - _max_buf_n);
 }
 
 struct MyInfo : public VstTimeInfo {
@@ -546,6 +907,17 @@ struct MyInfo : public VstTimeInfo {
                       << VAR(smpteFrameRate) << VAR(samplesToNextClock) << VAR(flags));
   }
 };
+//-------------------------------------------------------------------------------------------------
+long /*samples*/ DtBlkFx::getSettleSamps()
+// rough number of input samples needed before output stops depending on what came before it
+// (with the current params): the delay plus a few blks for the overlap & the effects that track
+// between blks
+{
+  long delay_n = getDelaySamps(get(&GetInput, _delay_param));
+  int plan = BlkFxParam::getPlan(get(&GetInput, _fft_len_param));
+  return delay_n + 4 * g_fft_sz[plan];
+}
+
 //-------------------------------------------------------------------------------------------------
 void DtBlkFx::guessFFTLen(int& /*return*/ freq_fft_n, int& /*return*/ time_fft_n)
 //
@@ -604,7 +976,8 @@ inline void DtBlkFx::pollUpdate(bool force)
     return;
 
   // ask host for tempo
-  VstTimeInfo* ti = getTimeInfo(kVstTempoValid | kVstPpqPosValid);
+  VstTimeInfo* ti = getTimeInfo(kVstTempoValid | kVstPpqPosValid | kVstCyclePosValid);
+  _loop_n = 0;
   if (ti) {
     //((MyInfo*)ti)->dbgprint();
     if (ti->flags & kVstTempoValid)
@@ -616,6 +989,14 @@ inline void DtBlkFx::pollUpdate(bool force)
     // work out sample position of the start of the current beat
     if (ti->flags & kVstPpqPosValid)
       _beat_start_abs = _curr_samp_abs - (long)(ppq_frac * _samps_per_beat);
+
+    // host loop, the start of the pass the current sample is in
+    const VstInt32 loop_flags = kVstTransportCycleActive | kVstCyclePosValid | kVstPpqPosValid;
+    if ((ti->flags & loop_flags) == loop_flags && ti->cycleEndPos > ti->cycleStartPos) {
+      _loop_n = (long)floor((ti->cycleEndPos - ti->cycleStartPos) * _samps_per_beat + 0.5);
+      _loop_start_abs =
+          _curr_samp_abs - (long)floor((ti->ppqPos - ti->cycleStartPos) * _samps_per_beat + 0.5);
+    }
   }
 
   // calculate samples per tick (based on tempo)
@@ -647,9 +1028,25 @@ void DtBlkFx::setParameter(VstInt32 index, float value)
   // safety
   value = limit_range(value, 0.0f, 1.0f);
 
-  //
+  // processing asynchronously: the worker holds _protect while it processes, it applies the
+  // change when it gets to the input that has been passed to it so far
+  if (_async) {
+    currProgram().params[index] = value;
+    AsyncParam p = {_async_host_abs.load(), (int)index, value};
+    if (!_async_params.push(p))
+      _async_xruns++;
+    return;
+  }
+
   ScopeCriticalSection scs(_protect);
+  setParameterNow(index, value);
+}
 
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setParameterNow(int index, float value)
+// internal method
+// caller holds _protect
+{
   // copy change into the current program
   currProgram().params[index] = value;
 
@@ -669,6 +1066,11 @@ void DtBlkFx::setParameter(VstInt32 index, float value)
       _params_need_processing = true;
   }
 
+  // buffers for a new fft length are allocated by the next reserveBlk() (this may be called from
+  // the audio thread)
+  if (_fft_len_param.vstParamIdx() == index)
+    requestPlan(BlkFxParam::getPlan(get(&GetInput, _fft_len_param)));
+
   // if (gui())
   //   gui()->setParameter(index, value);
 }
@@ -681,6 +1083,9 @@ float DtBlkFx::getParameter(VstInt32 index)
   using namespace BlkFxParam;
   if (index < 0 || index >= TOTAL_NUM)
     return 0.0f;
+  // changes queued for the worker are only in the program so far
+  if (_async)
+    return currProgram().params[index];
   // use most recently input value
   return _params.getInputNoForced(index);
 }
@@ -711,6 +1116,12 @@ void DtBlkFx::getParameterName(VstInt32 index, char* label)
     case OVERLAP:
       str << "Ovrlp";
       return;
+    case WOLA:
+      str << "Wola";
+      return;
+    case FREEZE:
+      str << "Frz";
+      return;
   }
   // try fx set
   switch (p.fx_param) {
@@ -800,6 +1211,11 @@ DtBlkFx::getParamDisplayGlobal(BlkFxParam::SplitParamNum& p, float v, CharRng te
         int fft_len, time_len;
         guessFFTLen(/*return*/ fft_len, /*return*/ time_len);
         long fwd_n = getBlkShiftFwd(_overlap_param(v), time_len);
+        if (getWolaWdw(_params.getInput(WOLA)) != WOLA_OFF) {
+          // wola blks are the whole fft blk
+          time_len = fft_len;
+          fwd_n = getWolaHop(_params.getInput(WOLA), fft_len);
+        }
         float overlap = 1.0f - ((float)fwd_n / (float)time_len);
 
         text << (printed ? " " : "") << spr_percent(overlap);
@@ -807,6 +1223,20 @@ DtBlkFx::getParamDisplayGlobal(BlkFxParam::SplitParamNum& p, float v, CharRng te
       }
       return printed;
     }
+
+    case WOLA: {
+      static const char* wdw_name[] = {"xfade", "hann", "kaiser"};
+      text << wdw_name[getWolaWdw(v)];
+      if (getWolaWdw(v) != WOLA_OFF)
+        text << " 1/" << getWolaHopDiv(v);
+      return true;
+    }
+
+    case FREEZE: {
+      static const char* mode_name[] = {"off", "hold", "advance", "random"};
+      text << mode_name[getFreezeMode(v)];
+      return true;
+    }
   }
   return false; // param not printed
 }
@@ -878,127 +1308,703 @@ bool DtBlkFx::getVendorString(char* text)
 }
 
 //-------------------------------------------------------------------------------------------------
-inline void DtBlkFx::copyInBuf(float** in_buf_, long buf_n)
-// internal method
-// copy input data into the pre-fft buffer
-// note that we are allowed to copy data beyond the end of our normal wrap position. The x0 buffer
-// contains extra memory corresponding to the length of largest fft blk.
+struct BlkScratch
+//
+// buffers that are only used while a blk is being processed, shared by all instances (see
+// BlkScratchPool)
 //
-// assume that we don't get blocks bigger than our buffer size (several seconds worth of data)
 {
-  long in_buf_offs = 0;
-  while (buf_n) {
-    // how many samples to copy
-    long n = buf_n;
+  ScopeFFTWfMalloc<float> x2[AUDIO_CHANNELS];
+  ScopeFFTWfMalloc<float> pwr[AUDIO_CHANNELS];
+  ScopeFFTWfMalloc<double> pwr_sum[AUDIO_CHANNELS];
+  ScopeFFTWfMalloc<cplxf> xh[AUDIO_CHANNELS];
+  ScopeFFTWfMalloc<float> xh_out[AUDIO_CHANNELS];
+  ScopeFFTWfMalloc<float> wdw;
+  ScopeFFTWfMalloc<cplxf> xc;
 
-    // offset into buffer at which to write data
-    long t = _x0_i + _x0_n;
+  // fft blk length that each is allocated for (x2_n also covers pwr & pwr_sum)
+  long x2_n, xh_n, wdw_n, xc_n;
 
-    // wrap to the start of the buffer if need be
-    if (t >= _x0_sz)
-      t -= _x0_sz;
+  // fft length the window was generated for
+  long wdw_fft_n;
 
-    // find how much the copy will overflow past _x0_sz
-    long overflow = t + buf_n - _x0_sz;
+  BlkScratch() { x2_n = xh_n = wdw_n = wdw_fft_n = xc_n = 0; }
 
-    // don't overflow at all if there's too much data - I don't expect this to ever happen
-    // (this is the only way that the loop could run more than once)
-    if (overflow > MAX_FFT_SZ) {
-      n -= overflow;
-      overflow = 0;
+  // grow to at least these blk lengths (0=not needed), not from the audio thread
+  void reserve(long x2_n_, long xh_n_, long xc_n_)
+  {
+    int i;
+    if (x2_n < x2_n_) {
+      for (i = 0; i < AUDIO_CHANNELS; i++) {
+        x2[i].resize(X2Len(x2_n_));
+        pwr[i].resize(PwrLen(x2_n_));
+        pwr_sum[i].resize(PwrLen(x2_n_) + 1);
+      }
+      x2_n = x2_n_;
     }
-    if (overflow >= 0)
-      _x0_n_past_end = overflow;
-
-    // copy all data into buffer (note that this may be past _x0_sz, which is fine)
-    for (int i = 0; i < AUDIO_CHANNELS; i++) {
-      float* x0_dat = _chan[i].x0;
-      Copy(x0_dat + t, in_buf_[i] + in_buf_offs, n);
+    if (xh_n < xh_n_) {
+      for (i = 0; i < AUDIO_CHANNELS; i++) {
+        xh[i].resize(X1Len(xh_n_));
+        xh_out[i].resize(xh_n_);
+      }
+      xh_n = xh_n_;
 
-      // copy any overflowed data to start of buffer
-      if (overflow > 0)
-        Copy(x0_dat, x0_dat + _x0_sz, overflow);
+      // the high band window is shorter than the blk
+      wdw.resize(xh_n_);
+      wdw_n = xh_n_;
+      wdw_fft_n = 0;
+    }
+    if (xc_n < xc_n_) {
+      xc.resize(xc_n_);
+      xc_n = xc_n_;
     }
+  }
 
-    buf_n -= n;
-    in_buf_offs += n;
-    _x0_n += n;
+  // return the sqrt hann window (as WOLA_HANN) of length "n" (up to wdw_n)
+  float* sqrtHannWdw(long n)
+  {
+    if (n == wdw_fft_n)
+      return wdw;
+    ASSERTX(n <= wdw_n, VAR(n) << VAR(wdw_n));
+    for (long j = 0; j < n; j++)
+      wdw[j] = (float)sin(3.14159265358979 * (double)j / (double)n);
+    wdw_fft_n = n;
+    return wdw;
   }
-}
+
+  size_t bytes() const
+  {
+    return AUDIO_CHANNELS * ((X2Len(x2_n) + PwrLen(x2_n)) * sizeof(float) +
+                             (PwrLen(x2_n) + 1) * sizeof(double) + X1Len(xh_n) * sizeof(cplxf) +
+                             xh_n * sizeof(float)) +
+           wdw_n * sizeof(float) + xc_n * sizeof(cplxf);
+  }
+
+  // "x1" style fft data: n/2+1 bins with 32 bins either side for shift overflow
+  static long X1Len(long n) { return n ? n / 2 + 1 + 32 * 2 : 0; }
+
+  // "x2" time-domain data that is also used as fft temporary data by the effects (at cplxf offset
+  // 32 with space for shift overflow)
+  static long X2Len(long n) { return n ? n + 32 * 2 * 3 : 0; }
+
+  // power plane: one value per bin (no overflow region)
+  static long PwrLen(long n) { return n ? n / 2 + 1 : 0; }
+};
 
 //-------------------------------------------------------------------------------------------------
-inline void DtBlkFx::paramsChkSync()
-// internal method
+struct BlkScratchPool
+//
+// the sets of BlkScratch that all instances share: a set is claimed for the blk stages of a
+// callback (the lowest free one, so instances that process one after the other on a thread keep
+// the same one in cache). There are as many sets as instances can process at once (the number of
+// instances up to the number of cpus), they're only allocated by reserve() which isn't called
+// from the audio thread
 //
-// check params for "next_blk_fwd_n" samples from _blk_samp_abs to see whether we need to sync to
-// any of them
 {
-  // see whether we can skip the param sync stage because param syncing is off and not
-  // automated (so that it can't be turned on)
-  if (_param_sync_param == MorphParam::MODE_FIXED && _param_sync_param(/*ignored*/ 0.0f) < 0.5f) {
-    _params_state = PARAMS_NONINTERP;
-    return;
+  enum { MAX_SETS = 16 };
+  BlkScratch set[MAX_SETS];
+  std::atomic<bool> busy[MAX_SETS];
+
+  // number of sets that can be claimed
+  std::atomic<int> set_n;
+
+  // blk lengths that every set is allocated for (only grow)
+  long x2_n, xh_n, xc_n;
+
+  // live instances
+  int instances;
+
+  // protects everything except claiming & releasing sets
+  std::mutex m;
+
+  BlkScratchPool()
+  {
+    for (int i = 0; i < MAX_SETS; i++)
+      busy[i] = false;
+    set_n = 0;
+    x2_n = xh_n = xc_n = 0;
+    instances = 0;
   }
 
-  // chk each param set in the fifo to see whether we need to sync to it until we reach the
-  // next blk position
-  while (1) {
-    // how far forward is the next param from the previous output blk
-    long param_fwd = _params.getOutSampAbs(/*next*/ true) - _blk_samp_abs;
+  static BlkScratchPool& get()
+  {
+    static BlkScratchPool p;
+    return p;
+  }
 
-    // done for this state if the next param exceeds next blk position
-    if (param_fwd >= _next_blk_fwd_n) {
-      _params_state = PARAMS_NONINTERP;
-      return;
+  // claim a set (-1 if they're all in use), doesn't block
+  int claim()
+  {
+    int n = set_n.load(std::memory_order_acquire);
+    for (int i = 0; i < n; i++) {
+      bool was_busy = false;
+      if (!busy[i].load(std::memory_order_relaxed) &&
+          busy[i].compare_exchange_strong(was_busy, true, std::memory_order_acquire))
+        return i;
     }
+    return -1;
+  }
+  void release(int i) { busy[i].store(false, std::memory_order_release); }
 
-    // see if this param is a candidate for syncing to
-    if (param_fwd > _min_blk_fwd_samps && _params.isAnyExplicitSet(/*next*/ true)) {
-
-      // should we sync the fft blk with param?
-      if (get(&GetInterp, _param_sync_param) > 0.5f) {
-        _next_blk_fwd_n = param_fwd;
-        _params_state = PARAMS_NONINTERP;
-        LOG(0xfff800, "Param sync, abs_pos=" << _blk_samp_abs + param_fwd);
-        return;
+  // make sure there are enough sets & that they're all allocated for at least these blk lengths
+  void reserve(long x2_n_, long xh_n_, long xc_n_)
+  {
+    std::lock_guard<std::mutex> lock(m);
+    x2_n = max(x2_n, x2_n_);
+    xh_n = max(xh_n, xh_n_);
+    xc_n = max(xc_n, xc_n_);
+
+    int cpus = max(1, (int)std::thread::hardware_concurrency());
+    int n = limit_range(min(instances, cpus), 1, (int)MAX_SETS);
+    for (int i = 0; i < n; i++) {
+      BlkScratch& s = set[i];
+      if (s.x2_n >= x2_n && s.xh_n >= xh_n && s.xc_n >= xc_n)
+        continue;
+
+      // wait for the set to be released (it's only held for a callback)
+      bool was_busy = false;
+      while (!busy[i].compare_exchange_weak(was_busy, true, std::memory_order_acquire)) {
+        was_busy = false;
+        std::this_thread::yield();
       }
+      s.reserve(x2_n, xh_n, xc_n);
+      release(i);
     }
+    if (n > set_n.load())
+      set_n.store(n, std::memory_order_release);
+  }
 
-    // if we can, go to the next param
-    if (!_params.nextOutParam())
-      return;
+  size_t bytes()
+  {
+    std::lock_guard<std::mutex> lock(m);
+    size_t r = 0;
+    for (int i = 0; i < set_n.load(); i++)
+      r += set[i].bytes();
+    return r;
   }
+};
+
+//-------------------------------------------------------------------------------------------------
+static void BlkScratchInstances(int add)
+{
+  BlkScratchPool& p = BlkScratchPool::get();
+  std::lock_guard<std::mutex> lock(p.m);
+  p.instances += add;
 }
 
 //-------------------------------------------------------------------------------------------------
-inline void DtBlkFx::paramsChk()
+static void BlkScratchFree(BlkScratch* s)
+{
+  delete s;
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::sizeBufs()
 // internal method
-//
-// check whether params need processing & update variables used in processing loop
-//
+// size x0 & x3 for the sample rate & the most input the host passes at once: up to
+// MAX_DELAY_SECS of delay plus the longest fft blk, everything is cleared if they change. Allocates
+// outside of _protect (not from the audio thread)
 {
-  if (!_params_need_processing)
+  float rate = sampleRate > 0.0f ? sampleRate : 44100.0f;
+  if (rate == _bufs_sample_rate && _max_buf_n <= _bufs_buf_n)
     return;
-  _params_need_processing = false;
-
-  // check whether we should sync with a param
-  if (_params_state == PARAMS_CHK_SYNC)
-    paramsChkSync();
 
-  // find src position of fft blk
-  long src_fft_abs = _blk_samp_abs + _next_blk_fwd_n;
+  // the worker would be processing into the old buffers
+  bool restart_async = _async_thread.joinable();
+  asyncStop();
 
-  // see if we can interpolate
-  if (_params_state == PARAMS_NONINTERP && _params.setOutPos(src_fft_abs))
-    _params_state = PARAMS_INTERP_OK;
+  long buf_n = max(_max_buf_n, (long)ASYNC_CHUNK_N);
+  long x3_sz = (long)(MAX_DELAY_SECS * rate) + MAX_FFT_SZ + buf_n;
 
-  // number of samples to do fft blk
-  _plan = BlkFxParam::getPlan(get(&GetInterp, _fft_len_param));
-  _freq_fft_n = g_fft_sz[_plan];
+  // output is forced before x0 holds more input than the delay & a blk need
+  long x0_sz = X0_INDEX_ROUNDING_MASK & (x3_sz + MAX_FFT_SZ + FFTW_ALIGNMENT - 1);
 
-  // this is how much of the blk we want to process
-  _time_fft_n =
+  ScopeFFTWfMalloc<float> x0[AUDIO_CHANNELS];
+  std::valarray<float> x3[AUDIO_CHANNELS];
+  int i;
+  for (i = 0; i < AUDIO_CHANNELS; i++) {
+    // input buffer with extra space at end to unwrap data for processing
+    x0[i].resize(x0_sz + MAX_FFT_SZ);
+    Clear(x0[i].ptr, x0_sz + MAX_FFT_SZ);
+    x3[i].resize(x3_sz);
+  }
+
+  {
+    ScopeCriticalSection scs(_protect);
+    for (i = 0; i < AUDIO_CHANNELS; i++) {
+      std::swap(x0[i].ptr, _chan[i].x0.ptr);
+      _chan[i].x3.swap(x3[i]);
+    }
+    _x0_sz = x0_sz;
+    _x0_force_out_sz = x0_sz - MAX_FFT_SZ;
+    _x3_sz = x3_sz;
+    _max_delay_n = x3_sz - MAX_FFT_SZ - buf_n;
+    _bufs_sample_rate = rate;
+    _bufs_buf_n = _max_buf_n;
+    init();
+  }
+  nrtSizeBufs();
+
+  if (restart_async)
+    asyncStart();
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::requestPlan(long plan)
+// ask for buffers for "plan" on the next reserveBlk() (safe from any thread, doesn't block)
+{
+  long r = _blk_req_plan.load();
+  while (plan > r && !_blk_req_plan.compare_exchange_weak(r, plan)) {
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::reserveBlk()
+// make sure per-instance buffers & the shared scratch are big enough for the largest plan asked
+// for & the modes that are on. Buffers only grow so this returns quickly when there's nothing to
+// do. Allocates outside of _protect & swaps the new buffers in under it (not from the audio
+// thread)
+{
+  std::lock_guard<std::mutex> alloc_lock(_alloc_mutex);
+
+  // what's needed & what there is
+  long plan;
+  bool freeze, decim, diff, wola, multires, stereo_pack;
+  long blk_alloc_n, freeze_alloc_n, decim_alloc_n, diff_alloc_n, wola_alloc_n;
+  {
+    ScopeCriticalSection scs(_protect);
+    plan = max(_blk_req_plan.load(), (long)BlkFxParam::getPlan(get(&GetInput, _fft_len_param)));
+    plan = max(plan, _blk_alloc_plan);
+    freeze = _freeze || BlkFxParam::getFreezeMode(currProgram().params[BlkFxParam::FREEZE]) != 0;
+    decim = _decim;
+    diff = _diff_resynth;
+    // (the param may only be queued for the async worker so far)
+    wola = _wola != WOLA_OFF ||
+           BlkFxParam::getWolaWdw(currProgram().params[BlkFxParam::WOLA]) != WOLA_OFF;
+    multires = _multires;
+    stereo_pack = _stereo_pack;
+    blk_alloc_n = _blk_alloc_n;
+    freeze_alloc_n = _freeze_alloc_n;
+    decim_alloc_n = _decim_alloc_n;
+    diff_alloc_n = _diff_alloc_n;
+    wola_alloc_n = _wola_alloc_n;
+  }
+  long n = g_fft_sz[plan];
+
+  // the shared scratch has to be big enough before a blk of this length can be processed
+  long xh_n = multires ? n : 0, xc_n = stereo_pack ? n : 0;
+  BlkScratchPool::get().reserve(n, xh_n, xc_n);
+
+  // & the instance's own for when every shared set is in use (only changed here, under
+  // _alloc_mutex, so the sizes can be read without _protect)
+  BlkScratch* own = _own_scratch;
+  bool grow_own = !own || own->x2_n < n || own->xh_n < xh_n || own->xc_n < xc_n;
+
+  bool grow_blk = n > blk_alloc_n;
+  bool grow_freeze = freeze && n > freeze_alloc_n;
+  bool grow_decim = (decim || multires) && n > decim_alloc_n;
+  bool grow_diff = diff && n > diff_alloc_n;
+  bool grow_wola = wola && n > wola_alloc_n;
+
+  // lanes process the same blks
+  nrtReserve(plan, decim, diff, stereo_pack);
+
+  if (!grow_blk && !grow_freeze && !grow_decim && !grow_diff && !grow_wola && !grow_own)
+    return;
+
+  // the replaced buffers are freed when these go out of scope (after _protect is released)
+  ScopeFFTWfMalloc<cplxf> x1[AUDIO_CHANNELS], xf[AUDIO_CHANNELS], xd[AUDIO_CHANNELS];
+  ScopeFFTWfMalloc<float> xl[AUDIO_CHANNELS], wola_wdw, wola_past;
+  int i;
+  for (i = 0; i < AUDIO_CHANNELS; i++) {
+    if (grow_blk)
+      x1[i].resize(BlkScratch::X1Len(n));
+    if (grow_freeze)
+      xf[i].resize(BlkScratch::X1Len(n));
+    if (grow_decim)
+      xl[i].resize(n / 2); // a decimated blk is at most half length
+    if (grow_diff)
+      xd[i].resize(BlkScratch::PwrLen(n));
+  }
+  ScopeFFTWfMalloc<cplxf> diff_u;
+  if (grow_diff)
+    diff_u.resize(n);
+  if (grow_wola) {
+    wola_wdw.resize(n);
+    wola_past.resize(n);
+  }
+  std::unique_ptr<BlkScratch> own_scratch;
+  if (grow_own) {
+    // (nothing in the scratch lasts beyond a callback so there's nothing to copy)
+    own_scratch.reset(new BlkScratch);
+    own_scratch->reserve(n, xh_n, xc_n);
+  }
+
+  ScopeCriticalSection scs(_protect);
+  if (grow_own) {
+    own = own_scratch.release();
+    std::swap(own, _own_scratch);
+    own_scratch.reset(own);
+  }
+  if (grow_blk) {
+    for (i = 0; i < AUDIO_CHANNELS; i++) {
+      // keep the fft data of a blk that is part way through being processed
+      if (_blk_stage != BLK_IDLE)
+        Copy(x1[i].ptr, _chan[i].x1.ptr, BlkScratch::X1Len(_blk_alloc_n));
+      std::swap(x1[i].ptr, _chan[i].x1.ptr);
+      _chan[i].fft = _chan[i].x1 + 32;
+    }
+    _blk_alloc_n = n;
+    _blk_alloc_plan = plan;
+  }
+  if (grow_freeze) {
+    // a longer fft length means capturing again anyway
+    for (i = 0; i < AUDIO_CHANNELS; i++)
+      std::swap(xf[i].ptr, _chan[i].xf.ptr);
+    _freeze_alloc_n = n;
+    _freeze_fft_n = 0;
+  }
+  if (grow_decim) {
+    // only used within a stage
+    for (i = 0; i < AUDIO_CHANNELS; i++)
+      std::swap(xl[i].ptr, _chan[i].xl.ptr);
+    _decim_alloc_n = n;
+  }
+  if (grow_diff) {
+    // nothing to keep, a blk in progress isn't resynthesized differentially
+    for (i = 0; i < AUDIO_CHANNELS; i++)
+      std::swap(xd[i].ptr, _chan[i].xd.ptr);
+    std::swap(diff_u.ptr, _diff_u.ptr);
+    _diff_alloc_n = n;
+    _diff_blk = false;
+  }
+  if (grow_wola) {
+    // a blk in progress & the tail of a run keep the window they were made with (they aren't any
+    // longer than before)
+    if (_wola_alloc_n) {
+      Copy(wola_wdw.ptr, _wola_wdw.ptr, _wola_alloc_n);
+      Copy(wola_past.ptr, _wola_past.ptr, _wola_alloc_n);
+    }
+    std::swap(wola_wdw.ptr, _wola_wdw.ptr);
+    std::swap(wola_past.ptr, _wola_past.ptr);
+    _wola_alloc_n = n;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline bool /*true=ok*/ DtBlkFx::attachScratch()
+// internal method
+// claim a set of the shared scratch for this callback, or if every set is in use take the
+// instance's own, & point x2 (& the multi-res & stereo packed buffers if they're allocated) at it.
+// False only if reserveBlk hasn't allocated any scratch yet
+{
+  _scratch_set = BlkScratchPool::get().claim();
+  if (_scratch_set >= 0)
+    _scratch = &BlkScratchPool::get().set[_scratch_set];
+  else if (_own_scratch && _own_scratch->x2_n >= _blk_alloc_n) {
+    _scratch = _own_scratch;
+    _scratch_misses++;
+  }
+  else
+    return false;
+
+  BlkScratch& s = *_scratch;
+  long n = _blk_alloc_n;
+  bool xh = s.xh_n >= n;
+  _xc.ptr = s.xc_n >= n ? s.xc.ptr : NULL;
+  for (int i = 0; i < AUDIO_CHANNELS; i++) {
+    _chan[i].x2.ptr = s.x2[i];
+    _chan[i].pwr.ptr = s.pwr[i];
+    _chan[i].pwr_sum.ptr = s.pwr_sum[i];
+    _chan[i].xh.ptr = xh ? s.xh[i].ptr : NULL;
+    _chan[i].xh_out.ptr = xh ? s.xh_out[i].ptr : NULL;
+  }
+
+  // another instance may have used the power plane
+  binPwrReset();
+  return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::detachScratch()
+// internal method
+{
+  if (_scratch_set >= 0)
+    BlkScratchPool::get().release(_scratch_set);
+  _scratch_set = -1;
+  _scratch = NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+static inline void NormBins(const cplxf* x, float* /*out*/ pwr, long b0, long b1)
+// pwr[b] = norm(x[b]) for b0..b1 inclusive
+{
+  for (long b = b0; b <= b1; b++)
+    pwr[b] = norm(x[b]);
+}
+
+//-------------------------------------------------------------------------------------------------
+const float* DtBlkFx::binPwr(int ch, long b0, long b1)
+// return the power plane of "ch" with b0..b1 valid
+{
+  Chan& c = _chan[ch];
+  if (b0 >= c.pwr_b0 && b1 <= c.pwr_b1)
+    return c.pwr;
+
+  if (c.pwr_b0 <= c.pwr_b1 && b0 <= c.pwr_b1 + 1 && b1 >= c.pwr_b0 - 1) {
+    // request touches the valid range, only calculate the bins either side of it
+    NormBins(c.fft, c.pwr, b0, c.pwr_b0 - 1);
+    NormBins(c.fft, c.pwr, c.pwr_b1 + 1, b1);
+    c.pwr_b0 = min(b0, c.pwr_b0);
+    c.pwr_b1 = max(b1, c.pwr_b1);
+  }
+  else {
+    // disjoint, start a new valid range
+    NormBins(c.fft, c.pwr, b0, b1);
+    c.pwr_b0 = b0;
+    c.pwr_b1 = b1;
+  }
+  return c.pwr;
+}
+
+//-------------------------------------------------------------------------------------------------
+const double* DtBlkFx::cumPwr(int ch)
+// (re)build the cumulative power of "ch" if any of it is out of date
+{
+  Chan& c = _chan[ch];
+  long max_bin = _freq_fft_n / 2;
+  if (c.sum_b0 == 0 && c.sum_b1 == max_bin)
+    return c.pwr_sum;
+
+  // double so that differences near the top of the spectrum keep their precision
+  const float* pwr = binPwr(ch, 0, max_bin);
+  double* sum = c.pwr_sum;
+  double acc = 0.0;
+  for (long b = 0; b <= max_bin; b++) {
+    sum[b] = acc;
+    acc += pwr[b];
+  }
+  sum[max_bin + 1] = acc;
+
+  c.sum_b0 = 0;
+  c.sum_b1 = max_bin;
+  return sum;
+}
+
+//-------------------------------------------------------------------------------------------------
+static inline void ShrinkValid(long& /*in-out*/ v0, long& /*in-out*/ v1, long b0, long b1)
+// remove b0..b1 from the valid range v0..v1, it is kept as a single range so keep the bigger side
+{
+  if (b1 < v0 || b0 > v1)
+    return;
+
+  if (b0 - v0 >= v1 - b1)
+    v1 = b0 - 1;
+  else
+    v0 = b1 + 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::binPwrWritten(int ch, long b0, long b1)
+// bins b0..b1 of "ch" have changed
+{
+  Chan& c = _chan[ch];
+  ShrinkValid(c.pwr_b0, c.pwr_b1, b0, b1);
+  ShrinkValid(c.sum_b0, c.sum_b1, b0, b1);
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::getMemReport(MemReport& /*out*/ r)
+// return bytes allocated by this instance & by the scratch shared by all instances
+{
+  r.scratch = BlkScratchPool::get().bytes();
+
+  ScopeCriticalSection scs(_protect);
+  r.x0 = AUDIO_CHANNELS * (_x0_sz + MAX_FFT_SZ) * sizeof(float);
+  r.x1 = AUDIO_CHANNELS *
+         (BlkScratch::X1Len(_blk_alloc_n) + BlkScratch::X1Len(_freeze_alloc_n) +
+          BlkScratch::PwrLen(_diff_alloc_n)) *
+             sizeof(cplxf) +
+         _diff_alloc_n * sizeof(cplxf) +
+         AUDIO_CHANNELS * (_decim_alloc_n / 2) * sizeof(float);
+  r.x3 = AUDIO_CHANNELS * _chan[0].x3.size() * sizeof(float);
+  r.other = sizeof(*this) + _program.capacity() * sizeof(BlkFxProgram) + _chunk_data.size();
+  if (_own_scratch)
+    r.other += _own_scratch->bytes();
+
+  // lanes for non-realtime processing (the shared scratch isn't counted again)
+  for (size_t k = 0; k < _nrt_lane.size(); k++) {
+    MemReport lr;
+    _nrt_lane[k]->getMemReport(lr);
+    r.x0 += lr.x0;
+    r.x1 += lr.x1;
+    r.x3 += lr.x3;
+    r.other += lr.other + (AUDIO_CHANNELS * _nrt_lane[k]->_nrt_out_n +
+                           2 * (_nrt_lane[k]->_nrt_out_n / 2 + 1)) * sizeof(float);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::copyInBuf(float** in_buf_, long buf_n)
+// internal method
+// copy input data into the pre-fft buffer
+// note that we are allowed to copy data beyond the end of our normal wrap position. The x0 buffer
+// contains extra memory corresponding to the length of largest fft blk.
+//
+// assume that we don't get blocks bigger than our buffer size (several seconds worth of data)
+{
+  // remember where the channels last differed (searching back from the end is quick for stereo)
+  if (AUDIO_CHANNELS == 2 && _dual_mono) {
+    const float* l = in_buf_[0];
+    const float* r = in_buf_[AUDIO_CHANNELS - 1];
+    for (long j = buf_n - 1; j >= 0; j--) {
+      if (l[j] != r[j]) {
+        _stereo_diff_abs = _curr_samp_abs + j + 1;
+        break;
+      }
+    }
+  }
+
+  long in_buf_offs = 0;
+  while (buf_n) {
+    // how many samples to copy
+    long n = buf_n;
+
+    // offset into buffer at which to write data
+    long t = _x0_i + _x0_n;
+
+    // wrap to the start of the buffer if need be
+    if (t >= _x0_sz)
+      t -= _x0_sz;
+
+    // find how much the copy will overflow past _x0_sz
+    long overflow = t + buf_n - _x0_sz;
+
+    // don't overflow at all if there's too much data - I don't expect this to ever happen
+    // (this is the only way that the loop could run more than once)
+    if (overflow > MAX_FFT_SZ) {
+      n -= overflow;
+      overflow = 0;
+    }
+    if (overflow >= 0)
+      _x0_n_past_end = overflow;
+
+    // copy all data into buffer (note that this may be past _x0_sz, which is fine)
+    for (int i = 0; i < AUDIO_CHANNELS; i++) {
+      float* x0_dat = _chan[i].x0;
+      Copy(x0_dat + t, in_buf_[i] + in_buf_offs, n);
+
+      // copy any overflowed data to start of buffer
+      if (overflow > 0)
+        Copy(x0_dat, x0_dat + _x0_sz, overflow);
+    }
+
+    buf_n -= n;
+    in_buf_offs += n;
+    _x0_n += n;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::paramsChkSync()
+// internal method
+//
+// check params for "next_blk_fwd_n" samples from _blk_samp_abs to see whether we need to sync to
+// any of them
+{
+  // see whether we can skip the param sync stage because param syncing is off and not
+  // automated (so that it can't be turned on)
+  if (_param_sync_param == MorphParam::MODE_FIXED && _param_sync_param(/*ignored*/ 0.0f) < 0.5f) {
+    _params_state = PARAMS_NONINTERP;
+    return;
+  }
+
+  // wola blks need a regular hop
+  if (_wola) {
+    _params_state = PARAMS_NONINTERP;
+    return;
+  }
+
+  // chk each param set in the fifo to see whether we need to sync to it until we reach the
+  // next blk position
+  while (1) {
+    // how far forward is the next param from the previous output blk
+    long param_fwd = _params.getOutSampAbs(/*next*/ true) - _blk_samp_abs;
+
+    // done for this state if the next param exceeds next blk position
+    if (param_fwd >= _next_blk_fwd_n) {
+      _params_state = PARAMS_NONINTERP;
+      return;
+    }
+
+    // see if this param is a candidate for syncing to
+    if (param_fwd > _min_blk_fwd_samps && _params.isAnyExplicitSet(/*next*/ true)) {
+
+      // should we sync the fft blk with param?
+      if (get(&GetInterp, _param_sync_param) > 0.5f) {
+        _next_blk_fwd_n = param_fwd;
+        _params_state = PARAMS_NONINTERP;
+        LOG(0xfff800, "Param sync, abs_pos=" << _blk_samp_abs + param_fwd);
+        return;
+      }
+    }
+
+    // if we can, go to the next param
+    if (!_params.nextOutParam())
+      return;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::paramsChk()
+// internal method
+//
+// check whether params need processing & update variables used in processing loop
+//
+{
+  if (!_params_need_processing)
+    return;
+  _params_need_processing = false;
+
+  // check whether we should sync with a param
+  if (_params_state == PARAMS_CHK_SYNC)
+    paramsChkSync();
+
+  // find src position of fft blk
+  long src_fft_abs = _blk_samp_abs + _next_blk_fwd_n;
+
+  // see if we can interpolate
+  if (_params_state == PARAMS_NONINTERP && _params.setOutPos(src_fft_abs))
+    _params_state = PARAMS_INTERP_OK;
+
+  // number of samples to do fft blk
+  _plan = BlkFxParam::getPlan(get(&GetInterp, _fft_len_param));
+  if (_plan > _blk_alloc_plan) {
+    // buffers aren't allocated for it yet, use the longest that they are until reserveBlk() has
+    // been called
+    requestPlan(_plan);
+    _plan = _blk_alloc_plan;
+  }
+  _freq_fft_n = g_fft_sz[_plan];
+
+  // window & hop for weighted overlap-add blks (off for cross-faded)
+  float wola_param = getVstParamVal(&GetInterp, BlkFxParam::WOLA);
+  _wola = BlkFxParam::getWolaWdw(wola_param);
+  _wola_hop_div = BlkFxParam::getWolaHopDiv(wola_param);
+
+  // freeze, turning it on captures the next blk
+  int freeze = BlkFxParam::getFreezeMode(getVstParamVal(&GetInterp, BlkFxParam::FREEZE));
+  if (freeze && !_freeze)
+    _freeze_fft_n = 0;
+  _freeze = freeze != 0;
+  if (_freeze)
+    _freeze_phase = freeze - 1;
+
+  // this is how much of the blk we want to process (all of it for wola)
+  _time_fft_n =
       (int)((float)_freq_fft_n * lin_interp(get(&GetInterp, _blk_shoulder_frac_param), 1.0f, .25f));
+  if (_wola)
+    _time_fft_n = _freq_fft_n;
 
   // center the data to be processed (this will be adjusted if there isn't enough data to fill
   // the blk)
@@ -1009,11 +2015,11 @@ inline void DtBlkFx::paramsChk()
   _dst_fft_abs = src_fft_abs + _delay_n;
 
   // make sure dest position isn't in data that we've already output (i.e. behind current sample
-  // pos) by increasing the delay
-  long behind_n = _curr_samp_abs - _dst_fft_abs;
+  // pos or passed on early by async processing) by increasing the delay
+  long behind_n = _out_final_abs - _dst_fft_abs;
   if (behind_n > 0) {
     _delay_n += behind_n;
-    _dst_fft_abs = _curr_samp_abs;
+    _dst_fft_abs = _out_final_abs;
   }
 }
 
@@ -1038,7 +2044,9 @@ inline void DtBlkFx::findBlkInPos()
 
   // chk whether we have enough data to do blk size & windowing requested
   if (_extra_data >= 0) {
-    // all good, enough data to process
+    // all good, enough data to process (a transient may make the blk shorter)
+    if (_adapt_len && !_freeze)
+      adaptBlkLen();
   }
   else if (_time_fft_n <= _x0_n) {
     // there's enough data if we don't honour exact spectrum windowing requested
@@ -1066,7 +2074,200 @@ inline void DtBlkFx::findBlkInPos()
       _extra_data = 0;
     }
   }
+
+  // wola needs the whole fft blk
+  _wola_blk = _wola && _time_fft_n == _freq_fft_n && _data_pre_x0_n == 0 &&
+              _freq_fft_n <= _wola_alloc_n;
+  if (!_wola_blk)
+    return;
+
+  // it also has to keep the sum constant: either continue the run in x3 (same window, length &
+  // hop, starting a hop after the last blk) or start one on complete data that covers where the
+  // blks before it would have been (not on a cleared x3 or past the end of the data). Otherwise
+  // it's cross-faded which completes the run or the data for the next blk to start one on
+  long hop_n = _freq_fft_n / _wola_hop_div;
+  if (_x3_tail_abs < _x3_end_abs) {
+    _wola_run_start = false;
+    _wola_blk = _wola_fft_n == _freq_fft_n && _wola_hop_n == hop_n && _wola_wdw_type == _wola &&
+                _dst_fft_abs == _x3_tail_abs;
+  }
+  else {
+    long have_n = _x3_end_abs - _dst_fft_abs;
+    _wola_run_start = true;
+    _wola_blk = !_x3_is_clear && have_n >= _freq_fft_n - hop_n && have_n <= _freq_fft_n;
+  }
+  if (_wola_blk)
+    wolaWindow(hop_n);
 }
+
+//-------------------------------------------------------------------------------------------------
+struct PSubBlkPwr
+// sum x^2 into consecutive sub-blks of "sub_n" samples
+{
+  float* e;
+  long sub_n, left;
+  PSubBlkPwr(float* e_, long sub_n_)
+  {
+    e = e_;
+    sub_n = left = sub_n_;
+  }
+  void setLen(long /*n*/) {}
+  void process(float* x, long n)
+  {
+    for (long i = 0; i < n; i++) {
+      *e += x[i] * x[i];
+      if (--left == 0) {
+        e++;
+        left = sub_n;
+      }
+    }
+  }
+};
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::adaptBlkLen()
+// internal method
+// adaptive blk length: shorten the blk (in the same way as when there isn't enough data) if there
+// is a transient in the part of the input that it outputs (the _time_fft_n samples at its centre)
+{
+  long short_plan = max(0L, _plan - _adapt_plan_reduce);
+  if (short_plan == _plan)
+    return;
+
+  long x0_xform_i = _x0_i - _data_pre_x0_n;
+  if (x0_xform_i < 0)
+    x0_xform_i += _x0_sz;
+
+  // power of up to SUB_MAX sub-blks across the blk, all channels together
+  enum { SUB_MAX = 64 };
+  long sub_n = max(64L, (_freq_fft_n + SUB_MAX - 1) / SUB_MAX);
+  long k_n = _freq_fft_n / sub_n;
+  float e[SUB_MAX + 1];
+  Clear(e, SUB_MAX + 1);
+  for (int i = 0; i < AUDIO_CHANNELS; i++) {
+    PSubBlkPwr p(e, sub_n);
+    wrapProcess(p, Rng<float>(_chan[i].x0, _x0_sz), x0_xform_i, _freq_fft_n);
+  }
+
+  // sub-blks of the output region, the ones before it in the blk are only part of the mean
+  long k0 = max(1L, _data_pre_x0_n / sub_n);
+  long k1 = min(k_n, (_data_pre_x0_n + _time_fft_n + sub_n - 1) / sub_n);
+  float sum = 0.0f;
+  for (long k = 0; k < k0; k++)
+    sum += e[k];
+
+  // a sub-blk well above the mean of the ones before it (& above about -60dB)
+  float min_e = 1e-6f * (float)(sub_n * AUDIO_CHANNELS);
+  long k = k0;
+  for (; k < k1; k++) {
+    if (e[k] > _adapt_thresh * sum / (float)k + min_e)
+      break;
+    sum += e[k];
+  }
+  if (k >= k1)
+    return;
+
+  _plan = short_plan;
+  _freq_fft_n = g_fft_sz[_plan];
+  _time_fft_n =
+      (int)((float)_freq_fft_n * lin_interp(get(&GetInterp, _blk_shoulder_frac_param), 1.0f, .25f));
+  if (_wola)
+    _time_fft_n = _freq_fft_n;
+  _data_pre_x0_n = (_freq_fft_n - _time_fft_n) / 2;
+  _extra_data = _x0_n + _data_pre_x0_n - _freq_fft_n;
+}
+
+//-------------------------------------------------------------------------------------------------
+static inline double BesselI0(double x)
+// modified bessel function of the first kind, order 0 (power series)
+{
+  double r = 1.0, t = 1.0, q = 0.25 * x * x;
+  for (int k = 1; k < 50 && t > r * 1e-12; k++) {
+    t *= q / ((double)k * (double)k);
+    r += t;
+  }
+  return r;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::wolaWindow(long hop_n)
+// internal method
+// work out _wola_wdw & _wola_scale for the current fft length & "hop_n" (if they've changed)
+{
+  long n = _freq_fft_n;
+  if (_wola_fft_n == n && _wola_hop_n == hop_n && _wola_wdw_type == _wola)
+    return;
+  _wola_fft_n = n;
+  _wola_hop_n = hop_n;
+  _wola_wdw_type = _wola;
+
+  float* w = _wola_wdw;
+  double sum = 0.0;
+  if (_wola == WOLA_HANN) {
+    // sqrt of 0.5-0.5*cos
+    for (long i = 0; i < n; i++)
+      w[i] = (float)sin(3.14159265358979 * (double)i / (double)n);
+    sum = 0.5 * (double)n;
+  }
+  else {
+    // kaiser kernel of n-hop_n+1 samples placed hop_n-1 on so that the sum of the hop_n samples
+    // from i on is the kernel convolved with the box at i
+    long k_n = n - hop_n + 1;
+    double i0_beta = BesselI0(WOLA_KAISER_BETA), total = 0.0;
+    Clear(w, hop_n - 1);
+    for (long j = 0; j < k_n; j++) {
+      double x = 2.0 * (double)j / (double)(k_n - 1) - 1.0;
+      double k = BesselI0(WOLA_KAISER_BETA * sqrt(max(0.0, 1.0 - x * x))) / i0_beta;
+      w[hop_n - 1 + j] = (float)k;
+      total += k;
+    }
+
+    // running sum of the box, w[i] is only overwritten after it has left the box
+    double box = w[hop_n - 1];
+    for (long i = 0; i < n; i++) {
+      double k = w[i];
+      double p = max(0.0, box / total);
+      box += (i + hop_n < n ? w[i + hop_n] : 0.0) - k;
+      w[i] = (float)sqrt(p);
+      sum += p;
+    }
+  }
+
+  // the products of "n/hop_n" windows overlap any sample, all of them sum to "sum"
+  _wola_scale = (float)((double)hop_n / sum);
+
+  // weight of a blk & the blks before it in the run, from the end back
+  float* past = _wola_past;
+  for (long j = n - 1; j >= 0; j--)
+    past[j] = _wola_scale * w[j] * w[j] + (j + hop_n < n ? past[j + hop_n] : 0.0f);
+}
+//-------------------------------------------------------------------------------------------------
+inline int /*samples*/ DtBlkFx::blkShoulderN()
+// internal method
+// amount of shoulder data either side of the current blk that a window function can be applied to
+{
+  return min(/*right*/ _data_pre_x0_n, /*left*/ _freq_fft_n - _time_fft_n - _data_pre_x0_n);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline long /*samples*/ DtBlkFx::alignBlkIn(long& /*in,out*/ x0_xform_i)
+// internal method
+// move the start of an unwindowed transform (x0_xform_i) down to keep fftw aligned, taking the
+// extra samples as pre-data, returns how far it moved (0 once aligned)
+{
+  long round_down = x0_xform_i & ~X0_INDEX_ROUNDING_MASK;
+  x0_xform_i -= round_down;
+  _extra_data += round_down;
+  _data_pre_x0_n += round_down;
+  _time_fft_n -= round_down;
+
+  // shouldn't happen
+  ASSERTX(_time_fft_n >= 0, VAR(_time_fft_n));
+  if (_time_fft_n < 0)
+    _time_fft_n = 0;
+  return round_down;
+}
+
 //-------------------------------------------------------------------------------------------------
 inline void DtBlkFx::doFFT()
 // internal method
@@ -1076,111 +2277,547 @@ inline void DtBlkFx::doFFT()
 {
   int i;
 
+  // only decimated blks have power outside of the spectrum
+  for (i = 0; i < AUDIO_CHANNELS; i++)
+    _chan[i].hi_pwr = 0.0f;
+
   // work out where we'll transform from
   long x0_xform_i = _x0_i - _data_pre_x0_n;
   if (x0_xform_i < 0)
     x0_xform_i += _x0_sz;
 
   // find the amount of shoulder data that we can apply a window function to (window is symmetrical)
-  int shoulder_n =
-      min(/*right*/ _data_pre_x0_n, /*left*/ _freq_fft_n - _time_fft_n - _data_pre_x0_n);
+  int shoulder_n = blkShoulderN();
+
+  // data to transform for each channel
+  float* src[AUDIO_CHANNELS];
+
+  // get the shoulder function to apply
+  Array<float, 48> shoulder_fn;
+  int shoulder_fn_n = 0;
+  if (shoulder_n > /*arbirary*/ 12)
+    shoulder_fn_n = get(&GetInterp, _blk_shoulder_wdw_param, shoulder_fn);
+
+  // offline renders may have the analysis of this blk from an earlier render (full rate blks only)
+  long n_bins = _freq_fft_n / 2 + 1;
+  const float* cached_pwr = NULL;
+  const cplxf* cached = NULL;
+  uint64_t stft_key = 0;
+  if (_stft_cache && _decim_n == 1) {
+    BlkHash h;
+    h.add((uint64_t)_freq_fft_n);
+    h.add((uint64_t)_time_fft_n);
+    h.add((uint64_t)_data_pre_x0_n);
+    h.add((uint64_t)(_blk_samp_abs + _samp_abs_origin));
+    h.add((uint64_t)(_stereo_pack && _xc));
+    h.add(shoulder_fn.data, shoulder_fn_n);
+    h.add((uint64_t)(_wola_blk ? _wola : WOLA_OFF));
+    h.add((uint64_t)(_wola_blk ? _wola_hop_n : 0));
+    stft_key = h.h;
+    if (!_stft_cache->next(stft_key, n_bins, cached_pwr, cached))
+      cached = NULL;
+  }
+
+  // wola analysis window is applied to the whole blk
+  if (_wola_blk) {
+    if (!cached) {
+      for (i = 0; i < AUDIO_CHANNELS; i++) {
+        PWdwCopyOut p(/*dst*/ src[i] = _chan[i].x2, _wola_wdw);
+        wrapProcess(p, Rng<float>(_chan[i].x0, _x0_sz), x0_xform_i, _freq_fft_n);
+      }
+    }
+  }
 
   // if the shoulder windowing needs to be applied then we'll copy input data to "x2", window and
   // then transform
-  if (shoulder_n > /*arbirary*/ 12) {
+  else if (shoulder_n > /*arbirary*/ 12) {
+    // nothing to window if the analysis is cached
+    if (!cached) {
+      for (i = 0; i < AUDIO_CHANNELS; i++) {
+        // position within x0
+        long x0_x = x0_xform_i;
+
+        // get x0 data range excluding overflow region
+        Rng<float> x0(_chan[i].x0, _x0_sz);
+
+        // apply window to left shoulder
+        PLinInterp<PScaleCopyOut> p0(shoulder_fn, shoulder_fn_n);
+        p0.proc.dst = src[i] = _chan[i].x2;
+        x0_x = wrapProcess(p0, x0, x0_x, shoulder_n);
+
+        // copy mid section directly
+        PCopyOut p1;
+        p1.dst = p0.proc.dst;
+        x0_x = wrapProcess(p1, x0, x0_x, _freq_fft_n - shoulder_n * 2);
+
+        // apply window to right shoulder
+        PLinInterp<PScaleCopyOut, /*reverse*/ 1> p2(shoulder_fn, shoulder_fn_n);
+        p2.proc.dst = p1.dst;
+        x0_x = wrapProcess(p2, x0, x0_x, shoulder_n);
+      }
+    }
+  }
+  else {
+    // do some data alignment to keep fftw happy
+    long round_down = alignBlkIn(x0_xform_i);
+    if (_memo_store)
+      _memo_store[memoRoundOffs()] = (float)round_down;
 
-    // get the shoulder function to apply
-    Array<float, 48> shoulder_fn;
-    int shoulder_fn_n = get(&GetInterp, _blk_shoulder_wdw_param, shoulder_fn);
+    // no windowing of data, make sure it is contiguous in x0 if it has wrapped past the end
+    long x0_sz_ext = _x0_sz + _x0_n_past_end;
+    long split_n = (x0_xform_i + _freq_fft_n) - x0_sz_ext;
+    if (split_n > 0) {
+      for (i = 0; i < AUDIO_CHANNELS; i++) {
+        float* x0_dat = _chan[i].x0;
+        Copy(x0_dat + x0_sz_ext, x0_dat + _x0_n_past_end, split_n);
+      }
+      _x0_n_past_end += split_n;
+    }
+
+    for (i = 0; i < AUDIO_CHANNELS; i++)
+      src[i] = _chan[i].x0 + x0_xform_i;
+  }
 
+  // remember where the transform started (for multi-res processing)
+  _x0_xform_i = x0_xform_i;
+
+  // the power plane is filled in as the effects need it
+  binPwrReset();
+  if (cached) {
+    // spectra are already scaled
     for (i = 0; i < AUDIO_CHANNELS; i++) {
-      // position within x0
-      long x0_x = x0_xform_i;
+      Copy(FFTdata(i), cached + i * n_bins, n_bins);
+      _chan[i].total_in_pwr = _chan[i].total_out_pwr = cached_pwr[i];
+    }
+    _dual_mono_blk = false;
+  }
+  else if (_decim_n > 1)
+    decimFFT(src);
+  else {
+    doFFTTransform(src);
+    if (_stft_cache && _stft_cache->writing()) {
+      float total_pwr[AUDIO_CHANNELS];
+      const cplxf* spectra[AUDIO_CHANNELS];
+      for (i = 0; i < AUDIO_CHANNELS; i++) {
+        total_pwr[i] = _chan[i].total_in_pwr;
+        spectra[i] = FFTdata(i);
+      }
+      _stft_cache->write(stft_key, n_bins, total_pwr, spectra);
+    }
+  }
+
+  // keep the spectrum from before the effects for differential resynthesis
+  _diff_blk = _diff_resynth && _decim_n == 1 && _diff_alloc_n >= _freq_fft_n;
+  if (_diff_blk) {
+    for (i = 0; i < AUDIO_CHANNELS; i++)
+      Copy(_chan[i].xd.ptr, FFTdata(i), n_bins);
+  }
+
+  // spectrogram data for channel 0 (magnitude squared), usually already up to date
+  if (inputSpectrogramCallback)
+    inputSpectrogramCallback(binPwr(/*ch*/ 0, 0, n_bins - 1), n_bins);
+  if (_memo_store)
+    Copy(_memo_store + memoInPwrOffs(), binPwr(/*ch*/ 0, 0, n_bins - 1), n_bins);
+}
+
+//-------------------------------------------------------------------------------------------------
+struct DecimKernel
+//
+// blackman windowed sinc interpolation kernels for each decimation factor (cutoff at the decimated
+// nyquist, 1 at the centre & 0 at other multiples of the factor), the decimation kernel is the
+// same divided by the factor. The interpolation kernel is also kept in polyphase form
+//
+{
+  enum {
+    Z = DtBlkFx::DECIM_ZEROS,
+    MAX_K = Z * DtBlkFx::DECIM_MAX, // largest half length
+    NUM = 3                         // factors 2, 4 & 8
+  };
+  float g[NUM][MAX_K * 2 + 1];
+
+  // polyphase taps, [i][r] for factor d at poly[j][i*d + r]: output sample m*d+r is the sum over i
+  // of decimated sample m-Z+1+i times that tap (for r=0 only sample m has a tap, of 1)
+  float poly[NUM][Z * 2 * DtBlkFx::DECIM_MAX];
+
+  DecimKernel()
+  {
+    for (int j = 0; j < NUM; j++) {
+      long d = 2L << j;
+      long k_n = Z * d;
+      for (long k = -k_n; k <= k_n; k++) {
+        double x = 3.14159265358979 * (double)k / (double)d;
+        double w = 3.14159265358979 * (double)k / (double)(k_n + 1);
+        g[j][MAX_K + k] =
+            (float)((k ? sin(x) / x : 1.0) * (0.42 + 0.5 * cos(w) + 0.08 * cos(2.0 * w)));
+      }
+      for (long i = 0; i < Z * 2; i++)
+        for (long r = 0; r < d; r++)
+          poly[j][i * d + r] = g[j][MAX_K + r + (Z - 1 - i) * d];
+    }
+  }
 
-      // get x0 data range excluding overflow region
-      Rng<float> x0(_chan[i].x0, _x0_sz);
+  static const DecimKernel& get()
+  {
+    static const DecimKernel k;
+    return k;
+  }
 
-      // apply window to left shoulder
-      PLinInterp<PScaleCopyOut> p0(shoulder_fn, shoulder_fn_n);
-      p0.proc.dst = _chan[0].x2; // always channel 0 to improve caching performance
-      x0_x = wrapProcess(p0, x0, x0_x, shoulder_n);
+  static int idx(long d) { return d == 2 ? 0 : d == 4 ? 1 : 2; }
 
-      // copy mid section directly
-      PCopyOut p1;
-      p1.dst = p0.proc.dst;
-      x0_x = wrapProcess(p1, x0, x0_x, _freq_fft_n - shoulder_n * 2);
+  // kernel for factor "d" (2, 4 or 8) indexed from -DECIM_ZEROS*d to DECIM_ZEROS*d
+  static const float* get(long d) { return get().g[idx(d)] + MAX_K; }
+
+  // polyphase taps for factor "d"
+  static const float* getPoly(long d) { return get().poly[idx(d)]; }
+};
+
+//-------------------------------------------------------------------------------------------------
+template <int D>
+static void DecimInterpBlks(const float* xl, long m0, long m1, const float* poly,
+                            const float* dry, float* /*out*/ out)
+// interpolate the output samples m0*D .. m1*D-1 from decimated samples "xl" with the polyphase
+// taps "poly" (see DecimKernel) added to "dry" (NULL for none), "dry" & "out" start at m0*D. Each
+// decimated sample gives D outputs from the 2*DECIM_ZEROS samples around it
+{
+  enum { Z = DtBlkFx::DECIM_ZEROS };
+  for (long m = m0; m < m1; m++) {
+    const float* xm = xl + m - (Z - 1);
+    float o[D];
+    for (int r = 0; r < D; r++)
+      o[r] = dry ? dry[r] : 0.0f;
+    for (int i = 0; i < Z * 2; i++)
+      for (int r = 0; r < D; r++)
+        o[r] += xm[i] * poly[i * D + r];
+    for (int r = 0; r < D; r++)
+      out[r] = o[r];
+    out += D;
+    if (dry)
+      dry += D;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::decimFFT(float* const* src)
+// internal method
+// in place of doFFTTransform for a decimated blk: low pass & decimate "src" of each channel by
+// _decim_n into xl, transform that into the bottom of FFTdata (bins above the decimated nyquist
+// are 0), scale & find the power
+{
+  long d = _decim_n;
+  long k_n = DECIM_ZEROS * d;
+  long m_n = _freq_fft_n / d;
+  long n_bins = _freq_fft_n / 2 + 1;
+  long m_bins = m_n / 2 + 1;
+  const float* g = DecimKernel::get(d);
+  float g_scale = 1.0f / (float)d;
+  float scale = 1.0f / (float)m_n;
+
+  for (int i = 0; i < AUDIO_CHANNELS; i++) {
+    const float* x = src[i];
+    float* xl = _chan[i].xl;
+
+    // full rate power of the blk (parseval, including the dc & nyquist bins counted once)
+    double sum2 = 0.0, dc = 0.0, nyq = 0.0;
+    for (long t = 0; t < _freq_fft_n; t += 2) {
+      double e = x[t], o = x[t + 1];
+      sum2 += e * e + o * o;
+      dc += e + o;
+      nyq += e - o;
+    }
+    dc /= _freq_fft_n;
+    nyq /= _freq_fft_n;
+    double full_pwr = 0.5 * (sum2 / _freq_fft_n + dc * dc + nyq * nyq);
+
+    // the blk wraps around at its ends as it does for the fft (treating the samples outside of it
+    // as 0 leaves an error at the ends of the blk only about 60dB down), away from the ends the
+    // symmetric kernel is used from its centre out in independent sums (k_n is a multiple of 4)
+    long m_lo = min(m_n, (k_n + d - 1) / d);
+    long m_hi = max(m_lo, (_freq_fft_n - 1 - k_n) / d + 1);
+    for (long m = 0; m < m_n; m++) {
+      long t = m * d;
+      float acc = 0.0f;
+      if (m >= m_lo && m < m_hi) {
+        const float* xt = x + t;
+        float a0 = 0.0f, a1 = 0.0f, a2 = 0.0f, a3 = 0.0f;
+        for (long k = 1; k <= k_n; k += 4) {
+          a0 += g[k] * (xt[k] + xt[-k]);
+          a1 += g[k + 1] * (xt[k + 1] + xt[-k - 1]);
+          a2 += g[k + 2] * (xt[k + 2] + xt[-k - 2]);
+          a3 += g[k + 3] * (xt[k + 3] + xt[-k - 3]);
+        }
+        acc = xt[0] + ((a0 + a1) + (a2 + a3));
+      }
+      else {
+        for (long k = -k_n; k <= k_n; k++)
+          acc += g[k] * x[(t + k + _freq_fft_n) % _freq_fft_n];
+      }
+      xl[m] = acc * g_scale;
+    }
+
+    cplxf* y = FFTdata(i);
+    FFTWf::execute_dft_r2c(g_fft_plan[_decim_plan], xl, to_fftwf_complex(y));
+
+    double acc = 0.0;
+    long b;
+    for (b = 0; b < m_bins; b++) {
+      y[b] = y[b] * scale;
+      acc += norm(y[b]);
+    }
+    for (; b < n_bins; b++)
+      y[b] = cplxf(0.0f, 0.0f);
+
+    _chan[i].hi_pwr = (float)max(0.0, full_pwr - acc);
+    _chan[i].total_in_pwr = _chan[i].total_out_pwr = (float)acc + _chan[i].hi_pwr;
+  }
+  _dual_mono_blk = false;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::doFFTTransform(float* const* src)
+// internal method
+// transform "src" of each channel to FFTdata, scale & find the power for power matching
+{
+  int i;
+
+  // do the fft, only once if the channels have been the same over the whole blk
+  long n_bins = _freq_fft_n / 2 + 1;
+  _dual_mono_blk = _dual_mono && AUDIO_CHANNELS == 2 &&
+                   _stereo_diff_abs - (_blk_samp_abs - _data_pre_x0_n) <= 0;
+  if (_dual_mono_blk) {
+    FFTWf::execute_dft_r2c(g_fft_plan[_plan], src[0], to_fftwf_complex(FFTdata(0)));
+    for (i = 1; i < AUDIO_CHANNELS; i++)
+      Copy(FFTdata(i), FFTdata(0), n_bins);
+  }
+  else if (_stereo_pack && _xc)
+    fftStereoPacked(src);
+  else {
+    for (i = 0; i < AUDIO_CHANNELS; i++)
+      FFTWf::execute_dft_r2c(g_fft_plan[_plan], src[i], to_fftwf_complex(FFTdata(i)));
+  }
+
+  // scale spectrum and find power for power matching, the power plane & its cumulative sum are
+  // only built when something queries them (binPwr, cumPwr)
+  float scale = 1.0f / (float)_freq_fft_n;
+  for (i = 0; i < AUDIO_CHANNELS; i++) {
+    // find power of spectrum (so that we can match to this afterwards)
+    double acc = 0.0;
+
+    cplxf* x = FFTdata(i);
+    for (long b = 0; b < n_bins; b++) {
+      x[b] = x[b] * scale;
+      acc += norm(x[b]);
+    }
+
+    _chan[i].total_out_pwr = (float)acc;
+    _chan[i].total_in_pwr = (float)acc;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::freezeCapture()
+// internal method
+// keep the fft data of the blk just transformed for freeze mode
+{
+  if (_freeze_fft_n == _freq_fft_n || _freeze_alloc_n < _freq_fft_n)
+    return;
+
+  long n_bins = _freq_fft_n / 2 + 1;
+  for (int i = 0; i < AUDIO_CHANNELS; i++) {
+    Copy(_chan[i].xf + 32, FFTdata(i), n_bins);
+    _chan[i].freeze_pwr = _chan[i].total_in_pwr;
+  }
+  _freeze_fft_n = _freq_fft_n;
+  _freeze_abs = _blk_samp_abs;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline bool /*true=frozen*/ DtBlkFx::freezeFFT()
+// internal method
+// in place of doFFT: fill FFTdata from the captured fft data (if there is any for this fft length)
+{
+  if (!_freeze || _freeze_fft_n != _freq_fft_n)
+    return false;
+
+  long n_bins = _freq_fft_n / 2 + 1;
+  int i;
+
+  for (i = 0; i < AUDIO_CHANNELS; i++)
+    Copy(FFTdata(i), _chan[i].xf + 32, n_bins);
+
+  if (_freeze_phase == FREEZE_PHASE_ADVANCE) {
+    // bin "b" turns b*d/n cycles in "d" samples, d is only needed modulo n
+    long d = (_blk_samp_abs - _freeze_abs) % _freq_fft_n;
+    if (d < 0)
+      d += _freq_fft_n;
+    long rot = 0;
+    for (long b = 0; b < n_bins; b++) {
+      cplxf r = g_sincos_table[rot * g_sincos_table.size() / _freq_fft_n];
+      for (i = 0; i < AUDIO_CHANNELS; i++)
+        FFTdata(i)[b] = FFTdata(i)[b] * r;
+      rot += d;
+      if (rot >= _freq_fft_n)
+        rot -= _freq_fft_n;
+    }
+  }
+  else if (_freeze_phase == FREEZE_PHASE_RANDOM) {
+    long rand_i = _freeze_rand_i;
+    for (long b = 0; b < n_bins; b++) {
+      cplxf r = g_sincos_table[rand_i];
+      for (i = 0; i < AUDIO_CHANNELS; i++)
+        FFTdata(i)[b] = FFTdata(i)[b] * r;
+      rand_i = prbs32(rand_i);
+    }
+    _freeze_rand_i = rand_i;
+  }
+
+  // phase changes don't change the power so there's no need to scan the bins, the power plane is
+  // filled in as the effects need it
+  binPwrReset();
+  for (i = 0; i < AUDIO_CHANNELS; i++) {
+    _chan[i].total_in_pwr = _chan[i].total_out_pwr = _chan[i].freeze_pwr;
+    _chan[i].hi_pwr = 0.0f;
+  }
+  _dual_mono_blk = false;
+  _diff_blk = false;
+
+  if (inputSpectrogramCallback)
+    inputSpectrogramCallback(binPwr(/*ch*/ 0, 0, n_bins - 1), n_bins);
+  return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline bool /*true=found*/ DtBlkFx::memoLookup()
+// internal method
+// look for the current blk in the memo cache (before doFFT), if it isn't there make an entry for
+// it to be stored in as it's processed
+{
+  _memo_hit = NULL;
+  _memo_store = NULL;
+  if (!_memo.on() || _multires || _freeze)
+    return false;
+
+  long x0_xform_i = _x0_i - _data_pre_x0_n;
+  if (x0_xform_i < 0)
+    x0_xform_i += _x0_sz;
+
+  // blk layout (including the fftw alignment rounding that doFFT may do) & phase reference
+  BlkHash h;
+  h.add((uint64_t)_plan);
+  h.add((uint64_t)_freq_fft_n);
+  h.add((uint64_t)_time_fft_n);
+  h.add((uint64_t)_data_pre_x0_n);
+  h.add((uint64_t)(x0_xform_i & ~X0_INDEX_ROUNDING_MASK));
+  h.add((uint64_t)(_stereo_pack && _xc));
+  h.add((uint64_t)_decim);
+  h.add((uint64_t)(_wola_blk ? _wola : WOLA_OFF));
+  h.add((uint64_t)(_wola_blk ? _wola_hop_n : 0));
+  h.add(getSampleRate());
+  h.add(_samps_per_beat);
+
+  // params at the blk
+  for (int i = 0; i < BlkFxParam::TOTAL_NUM; i++)
+    h.add(_params.getInterp(i));
+
+  // phase state of the effects that correct the phase of shifted bins, their output only repeats
+  // when the blk position does modulo their period (the params are collected again later)
+  long long pos_abs = (long long)_blk_samp_abs + _samp_abs_origin;
+  for (int i = 0; i < BlkFxParam::NUM_FX_SETS; i++) {
+    _fx1_0[i].prepare();
+    long long period = _fx1_0[i].temp.fft_fx->phasePeriod(_freq_fft_n);
+    if (period > 0) {
+      long long phase = pos_abs % period;
+      h.add((uint64_t)(phase < 0 ? phase + period : phase));
+    }
+  }
 
-      // apply window to right shoulder
-      PLinInterp<PScaleCopyOut, /*reverse*/ 1> p2(shoulder_fn, shoulder_fn_n);
-      p2.proc.dst = p1.dst;
-      x0_x = wrapProcess(p2, x0, x0_x, shoulder_n);
+  // position in the host loop pass
+  if (_loop_n > 0) {
+    long loop_pos = (_blk_samp_abs - _loop_start_abs) % _loop_n;
+    h.add((uint64_t)(loop_pos < 0 ? loop_pos + _loop_n : loop_pos));
+  }
 
-      // and do the fft
-      FFTWf::execute_dft_r2c(g_fft_plan[_plan], _chan[0].x2, to_fftwf_complex(FFTdata(i)));
-    }
+  // input data (x0 wraps)
+  long n0 = min((long)_freq_fft_n, _x0_sz - x0_xform_i);
+  for (int i = 0; i < AUDIO_CHANNELS; i++) {
+    h.add(_chan[i].x0 + x0_xform_i, n0);
+    h.add(_chan[i].x0.ptr, _freq_fft_n - n0);
   }
-  else {
-    // do some data alignment to keep fftw happy
 
-    // adjust pre-data to do the rounding
-    int round_down = x0_xform_i & ~X0_INDEX_ROUNDING_MASK;
-    x0_xform_i -= round_down;
+  _memo_key = h.h;
+  _memo_time_n = _time_fft_n;
+  _memo_n = memoOutPwrOffs() + _freq_fft_n / 2 + 1;
+
+  _memo_hit = _memo.find(_memo_key, _memo_n);
+  if (_memo_hit) {
+    // redo the alignment rounding
+    long round_down = (long)_memo_hit[memoRoundOffs()];
     _extra_data += round_down;
     _data_pre_x0_n += round_down;
     _time_fft_n -= round_down;
 
-    // shouldn't happen
-    ASSERTX(_time_fft_n >= 0, VAR(_time_fft_n));
-    if (_time_fft_n < 0)
-      _time_fft_n = 0;
-
-    // no windowing of data, make sure it is contiguous in x0 if it has wrapped past the end
-    long x0_sz_ext = _x0_sz + _x0_n_past_end;
-    long split_n = (x0_xform_i + _freq_fft_n) - x0_sz_ext;
-    if (split_n > 0) {
-      for (i = 0; i < AUDIO_CHANNELS; i++) {
-        float* x0_dat = _chan[i].x0;
-        Copy(x0_dat + x0_sz_ext, x0_dat + _x0_n_past_end, split_n);
-      }
-      _x0_n_past_end += split_n;
-    }
-
-    // do the fft
-    for (i = 0; i < AUDIO_CHANNELS; i++) {
-      float* x0_dat = _chan[i].x0;
-      FFTWf::execute_dft_r2c(g_fft_plan[_plan], x0_dat + x0_xform_i, to_fftwf_complex(FFTdata(i)));
-    }
+    _multires_blk = false;
+    if (inputSpectrogramCallback)
+      inputSpectrogramCallback(_memo_hit + memoInPwrOffs(), _freq_fft_n / 2 + 1);
+    return true;
   }
 
-  // scale spectrum and find power for power matching
-  float scale = 1.0f / (float)_freq_fft_n;
-  for (i = 0; i < AUDIO_CHANNELS; i++) {
-    // find power of spectrum (so that we can match to this afterwards)
-    float acc = 0.0f;
+  _memo_store = _memo.insert(_memo_key, _memo_n);
+  if (_memo_store)
+    _memo_store[memoRoundOffs()] = 0.0f;
+  return false;
+}
 
-    CplxfPtrPair in(FFTdata(i), _freq_fft_n / 2 + 1);
+//-------------------------------------------------------------------------------------------------
+struct PWgtNorm
+// divide by the weight that the data has (not by less than "min_wgt")
+{
+  const float* wgt;
+  float min_wgt;
+  void setLen(long /*n*/) {}
+  void process(float* x, long n)
+  {
+    for (long i = 0; i < n; i++)
+      x[i] /= max(wgt[i], min_wgt);
+    wgt += n;
+  }
+};
 
-    // Extract spectrogram data for channel 0
-    // Extract spectrogram data for channel 0
-    if (i == 0 && inputSpectrogramCallback) {
-      if (_spectrogram_buffer.size() != _freq_fft_n / 2 + 1)
-        _spectrogram_buffer.resize(_freq_fft_n / 2 + 1);
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::prepWolaTail()
+// internal method
+// work out how the current (cross-faded) blk completes the tail of a wola run in x3 (_mix_keep_n,
+// _mix_tail_n & _mix_tail_j), the part of the tail that it doesn't cover is normalised
+{
+  _mix_keep_n = _mix_tail_n = _mix_tail_j = 0;
+  if (_x3_tail_abs >= _x3_end_abs || _wola_blk)
+    return;
 
-      float* spec_out = _spectrogram_buffer.data();
-      CplxfPtrPair spec_in(FFTdata(i), _freq_fft_n / 2 + 1);
-      for (; !spec_in.equal(); spec_in.a++, spec_out++) {
-        *spec_out = norm(*spec_in.a * scale); // Pass magnitude squared
-      }
-      inputSpectrogramCallback(_spectrogram_buffer.data(), _freq_fft_n / 2 + 1);
+  // start of the last blk of the run, _wola_past[] is from there
+  long run_abs = _x3_tail_abs - _wola_hop_n;
+  long dst_end_abs = _dst_fft_abs + _time_fft_n;
+
+  // complete data before the tail is kept, the blk adds the weight missing from the tail
+  _mix_keep_n = limit_range(_x3_tail_abs - _dst_fft_abs, 0L, _time_fft_n);
+  long t0_abs = max(_dst_fft_abs, _x3_tail_abs);
+  _mix_tail_n = max(0L, min(_x3_end_abs, dst_end_abs) - t0_abs);
+  _mix_tail_j = t0_abs - run_abs;
+
+  // the blk doesn't reach the start (the delay went up) or the end (short blk) of the tail,
+  // that part can only be scaled up to the weight that it should have
+  long n0_abs = max(_x3_tail_abs, _out_final_abs);
+  long n1_abs = min(_x3_end_abs, _dst_fft_abs);
+  long m0_abs = max(dst_end_abs, _x3_tail_abs);
+  for (int i = 0; i < AUDIO_CHANNELS; i++) {
+    PWgtNorm p;
+    p.min_wgt = 0.05f; // arbitrary (-26dB)
+    if (n1_abs > n0_abs) {
+      p.wgt = _wola_past + (n0_abs - run_abs);
+      wrapProcess(p, _chan[i].x3, n0_abs - _curr_samp_abs + _x3_o, n1_abs - n0_abs);
     }
-
-    for (; !in.equal(); in.a++) {
-      in() = in() * scale;
-      acc += norm(*in.a);
+    if (_x3_end_abs > m0_abs) {
+      p.wgt = _wola_past + (m0_abs - run_abs);
+      wrapProcess(p, _chan[i].x3, m0_abs - _curr_samp_abs + _x3_o, _x3_end_abs - m0_abs);
     }
-
-    _chan[i].total_out_pwr = acc;
-    _chan[i].total_in_pwr = acc;
   }
 }
 
@@ -1192,6 +2829,9 @@ inline void DtBlkFx::prepMixOut()
 // with the previous blk (_fadein_n & _fadeout_n)
 //
 {
+  // complete a wola run that this blk doesn't continue
+  prepWolaTail();
+
   // the amount of xfade-in corresponds to the overlap of this fft blk with existing data
   _fadein_n = _x3_end_abs - _dst_fft_abs;
 
@@ -1247,9 +2887,10 @@ inline void DtBlkFx::prepMixOut()
     long prev_fade_o = zero_o - prev_fade_n;
 
     // don't fade data that has already been output
-    if (prev_fade_o < 0) {
-      prev_fade_n += prev_fade_o;
-      prev_fade_o = 0;
+    long final_o = _out_final_abs - _curr_samp_abs;
+    if (prev_fade_o < final_o) {
+      prev_fade_n -= final_o - prev_fade_o;
+      prev_fade_o = final_o;
     }
     if (prev_fade_n > 0) {
       for (int i = 0; i < AUDIO_CHANNELS; i++) {
@@ -1267,45 +2908,369 @@ inline void DtBlkFx::prepMixOut()
   if (extend_x3 > 0)
     _x3_end_abs = dst_fft_end_abs;
 
+  // a wola blk leaves x3 incomplete from a hop on, anything else leaves it complete
+  _x3_tail_abs = _wola_blk ? _dst_fft_abs + _wola_hop_n : _x3_end_abs;
+
   // ensure fade in is not too big
   if (_fadein_n > _time_fft_n)
     _fadein_n = _time_fft_n;
 }
 
 //-------------------------------------------------------------------------------------------------
-inline void DtBlkFx::procFFT()
-// internal method
-// process the FFT'd data (x1) using the fx_params
+static inline float /*pwr scale*/ PwrMatchScale(double in_pwr, double out_pwr, float pwr_match)
+// return output power scaling for "pwr_match" amount (0=filter mode, 1=match output to input)
 {
-  int i;
+  double pwr_scale = 1.0f;
+  if (out_pwr > 1e-30)
+    pwr_scale *= in_pwr / out_pwr;
 
-  // run all of the 1.0 effects (collect params first & then process)
-  for (i = 0; i < BlkFxParam::NUM_FX_SETS; i++)
+  if (pwr_scale > 1e30)
+    pwr_scale = 1.0f; // too big
+  if (pwr_scale < 1e-30)
+    pwr_scale = 0.0f; // too small (or worse, negative)
+
+  return lin_interp(pwr_match, 1.0f, (float)pwr_scale);
+}
+
+//-------------------------------------------------------------------------------------------------
+static void XoverBand(cplxf* fft, long n_bins, float xover, float ramp_n, bool keep_high)
+// split fft data at bin "xover" with a linear ramp "ramp_n" bins wide, keeping the high or low
+// side (the two sides sum to the original data)
+{
+  float ramp_start = xover - 0.5f * ramp_n;
+  long b0 = limit_range((long)ceilf(ramp_start), 0L, n_bins);
+  long b1 = limit_range((long)ceilf(xover + 0.5f * ramp_n), b0, n_bins);
+
+  // gain of the high side across the ramp
+  ValStp<float> g;
+  g.stp = 1.0f / ramp_n;
+  g.val = ((float)b0 - ramp_start) * g.stp;
+  for (long b = b0; b < b1; b++, g.next())
+    fft[b] = fft[b] * (keep_high ? (float)g : 1.0f - g);
+
+  if (keep_high)
+    Clear(fft, b0);
+  else
+    Clear(fft + b1, n_bins - b1);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::procFFTPrepare()
+// internal method
+// collect params for all of the 1.0 effects before any of them process the FFT'd data (x1)
+{
+  for (int i = 0; i < BlkFxParam::NUM_FX_SETS; i++)
     _fx1_0[i].prepare();
-  for (i = 0; i < BlkFxParam::NUM_FX_SETS; i++)
-    _fx1_0[i].process();
 
+  _multires_blk = multiResOk();
+
+  // dual mono blk: effects that do the same to each channel only have to run on channel 0
+  _dual_mono_fx = _dual_mono_blk && !_multires_blk && !_freeze;
+  for (int i = 0; _dual_mono_fx && i < BlkFxParam::NUM_FX_SETS; i++)
+    _dual_mono_fx = _fx1_0[i].temp.fft_fx->chanSymmetric();
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::procFFTDone()
+// internal method
+// work out the output power scaling after all of the effects have run (not multi-res)
+{
   // power match amount
   float pwr_match = get(&GetInterp, _pwr_match_param);
 
   // post process, work pwr out scaling
-  for (i = 0; i < AUDIO_CHANNELS; i++) {
+  long n_bins = _freq_fft_n / 2 + 1;
+  int n_ch = fxChannels();
+  for (int i = 0; i < n_ch; i++) {
 
-    float out_pwr = GetPwr(FFTdata(i), _freq_fft_n / 2 + 1);
+    // bins no effect has written are still valid from the fft
+    float out_pwr = rngPwr(i, 0, n_bins - 1) + _chan[i].hi_pwr;
 
     // match the output to the input power
     // power match mode, scale output to match input power
-    double pwr_scale = 1.0f;
-    if (out_pwr > 1e-30)
-      pwr_scale *= _chan[i].total_in_pwr / out_pwr;
+    _chan[i].out_pwr_scale = PwrMatchScale(_chan[i].total_in_pwr, out_pwr, pwr_match);
+    _chan[i].out_scale = sqrtf(_chan[i].out_pwr_scale);
+  }
 
-    if (pwr_scale > 1e30)
-      pwr_scale = 1.0f; // too big
-    if (pwr_scale < 1e-30)
-      pwr_scale = 0.0f; // too small (or worse, negative)
+  // the effects only ran on channel 0 (see procFFTPrepare)
+  for (int i = n_ch; i < AUDIO_CHANNELS; i++) {
+    Copy(FFTdata(i), FFTdata(0), n_bins);
+    binPwrWritten(i, 0, n_bins - 1);
+    _chan[i].out_pwr_scale = _chan[0].out_pwr_scale;
+    _chan[i].out_scale = _chan[0].out_scale;
+  }
+}
 
-    _chan[i].out_pwr_scale = lin_interp(pwr_match, 1.0f, (float)pwr_scale);
-    _chan[i].out_scale = sqrtf(_chan[i].out_pwr_scale);
+//-------------------------------------------------------------------------------------------------
+inline long /*factor*/ DtBlkFx::decimFactor()
+// internal method
+// return the factor that the current blk can be decimated by (1=not at all), see _decim
+{
+  if (_freeze || _wola_blk || _decim_alloc_n < _freq_fft_n)
+    return 1;
+
+  // multi-res: only the low band has to fit in the decimated spectrum
+  bool multires = multiResOk();
+  if (!_decim && !multires)
+    return 1;
+  float xover_hi = 0.0f;
+  if (multires) {
+    long short_n = g_fft_sz[_plan - _multires_plan_reduce];
+    float blk_per_short = (float)_freq_fft_n / (float)short_n;
+    float blk_xover = _multires_xover_hz * (float)_freq_fft_n / sampleRate;
+    xover_hi = blk_xover + 0.5f * MULTIRES_RAMP_BINS * blk_per_short;
+  }
+
+  // highest bin written by any of the fx sets (the params are collected again by procFFTPrepare)
+  float top_bin = 0.0f;
+  for (int i = 0; i < BlkFxParam::NUM_FX_SETS; i++) {
+    FxState1_0& fx_set = _fx1_0[i];
+    fx_set.prepare();
+    FxRun1_0* fx = fx_set.temp.fft_fx;
+    if (fx->isMask())
+      continue;
+
+    // effects without params are off
+    bool on = false;
+    for (int p = 0; p < BlkFxParam::NUM_FX_PARAMS; p++)
+      on |= fx->paramUsed(p);
+    if (!on)
+      continue;
+
+    // the high band slots of a multi-res blk don't see the blk fft
+    float b0 = min(fx_set.temp.fbin[0], fx_set.temp.fbin[1]);
+    float b1 = max(fx_set.temp.fbin[0], fx_set.temp.fbin[1]);
+    if (multires && b0 >= xover_hi)
+      continue;
+
+    // effects that aren't in place may write anywhere
+    if (!fx->inPlace())
+      return 1;
+    top_bin = max(top_bin, b1);
+  }
+
+  // the low band of a multi-res blk is cut at the crossover whatever the slots write
+  if (multires)
+    top_bin = xover_hi;
+  return decimFactorFor(top_bin);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline long /*factor*/ DtBlkFx::decimFactorFor(float top_bin)
+// internal method
+// return the largest decimation factor that keeps bin "top_bin" in the pass band & has an fft
+// length (sets _decim_plan), 1 if none
+{
+  for (long d = DECIM_MAX; d >= 2; d /= 2) {
+    if (_freq_fft_n % d != 0 || top_bin + 1.0f > DECIM_PASS * (float)(_freq_fft_n / d / 2))
+      continue;
+    for (long p = 0; p < NUM_FFT_SZ; p++) {
+      if (g_fft_sz[p] * d == _freq_fft_n) {
+        _decim_plan = p;
+        return d;
+      }
+    }
+  }
+  return 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::adaptHopMeasure()
+// internal method
+// adaptive hop: compare the band magnitudes of the input spectrum (all channels) with the last
+// measured blk & keep them for the next one
+{
+  long n_bins = _freq_fft_n / 2 + 1;
+  double band_lg = log((double)n_bins) / (double)ADAPT_HOP_BANDS;
+  float band[ADAPT_HOP_BANDS];
+  float diff = 0.0f, total = 0.0f;
+  long b0 = 0;
+  for (int k = 0; k < ADAPT_HOP_BANDS; k++) {
+    long b1 = k == ADAPT_HOP_BANDS - 1 ? n_bins : max(b0, (long)exp(band_lg * (double)(k + 1)));
+    float pwr = 0.0f;
+    for (int i = 0; i < AUDIO_CHANNELS; i++) {
+      if (b1 > b0)
+        pwr += rngPwr(i, b0, b1 - 1);
+
+      // decimated blks: the top band has the power above the decimated spectrum
+      if (k == ADAPT_HOP_BANDS - 1)
+        pwr += _chan[i].hi_pwr;
+    }
+    band[k] = sqrtf(pwr);
+    diff += fabsf(band[k] - _adapt_hop_band[k]);
+    total += max(band[k], _adapt_hop_band[k]);
+    b0 = b1;
+  }
+
+  _adapt_hop_stable = _adapt_hop_fft_n == _freq_fft_n && diff <= _adapt_hop_flux * total;
+  Copy(_adapt_hop_band, band, ADAPT_HOP_BANDS);
+  _adapt_hop_fft_n = _freq_fft_n;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline bool DtBlkFx::multiResOk()
+// internal method
+// return whether the current blk can be processed in multi-res mode
+{
+  if (!_multires || _wola_blk || !_chan[0].xh)
+    return false;
+
+  // need a short plan for the high band & enough blk to make it worthwhile
+  long short_plan = _plan - _multires_plan_reduce;
+  if (short_plan < 0)
+    return false;
+
+  // crossover must be inside the spectrum of both ffts
+  float xover_bin = _multires_xover_hz * (float)g_fft_sz[short_plan] / sampleRate;
+  return xover_bin >= 2.0f && xover_bin < (float)(g_fft_sz[short_plan] / 2 - 2);
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::procFFTMultiRes()
+// internal method
+//
+// multi-resolution version of the fx stages, the blk is split into 2 bands at _multires_xover_hz:
+//
+// low band: fx sets with any part of their bin range below the crossover are run on the blk fft
+// (x1) as normal and then everything above the crossover is removed, when the blk was decimated
+// (see decimFactor) x1 only holds the low part of the spectrum & the low band is interpolated back
+// to the full rate by decimResynth
+//
+// high band: the whole blk is covered by short ffts with sqrt hann analysis & synthesis windows
+// (as WOLA_HANN, 50% overlap so that the products of the windows sum to 1), fx sets with any part
+// of their bin range above the crossover are run on each of these (xh), everything below the
+// crossover is removed and the result is windowed again & overlap-added into xh_out so that the
+// changes the effects make fade out at the frame edges
+//
+// the bands are power matched separately and summed in ifftAndMixOut
+//
+{
+  int i, ch;
+
+  float pwr_match = get(&GetInterp, _pwr_match_param);
+
+  long blk_plan = _plan;
+  long blk_n = _freq_fft_n;
+  long blk_samp_abs = _blk_samp_abs;
+  long short_plan = _plan - _multires_plan_reduce;
+  long short_n = g_fft_sz[short_plan];
+  long hop_n = short_n / 2;
+
+  // crossover in bins for both fft lengths
+  float xover = _multires_xover_hz * (float)short_n / sampleRate;
+  float blk_per_short = (float)blk_n / (float)short_n;
+  float blk_xover = xover * blk_per_short;
+
+  // route each fx set to the band(s) covering its bin range
+  bool in_lo[BlkFxParam::NUM_FX_SETS], in_hi[BlkFxParam::NUM_FX_SETS];
+  for (i = 0; i < BlkFxParam::NUM_FX_SETS; i++) {
+    float b0 = min(_fx1_0[i].temp.fbin[0], _fx1_0[i].temp.fbin[1]);
+    float b1 = max(_fx1_0[i].temp.fbin[0], _fx1_0[i].temp.fbin[1]);
+    in_lo[i] = b0 < blk_xover;
+    in_hi[i] = b1 >= blk_xover;
+  }
+
+  //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  // low band
+  float lo_in_pwr[AUDIO_CHANNELS];
+  for (ch = 0; ch < AUDIO_CHANNELS; ch++)
+    lo_in_pwr[ch] = rngPwr(ch, 0, (long)blk_xover - 1);
+
+  for (i = 0; i < BlkFxParam::NUM_FX_SETS; i++)
+    if (in_lo[i])
+      _fx1_0[i].process();
+
+  for (ch = 0; ch < AUDIO_CHANNELS; ch++) {
+    XoverBand(FFTdata(ch), blk_n / 2 + 1, blk_xover, MULTIRES_RAMP_BINS * blk_per_short,
+              /*keep high*/ false);
+    _chan[ch].out_pwr_scale =
+        PwrMatchScale(lo_in_pwr[ch], GetPwr(FFTdata(ch), blk_n / 2 + 1), pwr_match);
+    _chan[ch].out_scale = sqrtf(_chan[ch].out_pwr_scale);
+  }
+
+  //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+  // high band, effects see a short fft blk
+  _plan = short_plan;
+  _freq_fft_n = short_n;
+  for (i = 0; i < BlkFxParam::NUM_FX_SETS; i++)
+    if (in_hi[i])
+      _fx1_0[i].prepare();
+
+  // fft scaling (as doFFTTransform) & the overlap-add weight (as wolaWindow, the products of the
+  // windows overlapping any sample sum to short_n/2)
+  float* wdw = _scratch->sqrtHannWdw(short_n);
+  float fft_scale = 1.0f / (float)short_n;
+  float ola_scale = (float)hop_n / (0.5f * (float)short_n);
+
+  double hi_in_pwr[AUDIO_CHANNELS], hi_out_pwr[AUDIO_CHANNELS];
+  float total_in_pwr[AUDIO_CHANNELS];
+  for (ch = 0; ch < AUDIO_CHANNELS; ch++) {
+    Chan& chan = _chan[ch];
+    Clear((float*)chan.xh_out, blk_n);
+    chan.fft = chan.xh + 32;
+    hi_in_pwr[ch] = hi_out_pwr[ch] = 0.0;
+    total_in_pwr[ch] = chan.total_in_pwr;
+  }
+
+  // first frame starts half a frame before the blk so that the windows sum to 1 across the blk,
+  // samples outside of the blk are treated as 0
+  float* x2 = _chan[0].x2; // always ch0 to help cache performance
+  for (long o = -hop_n; o < blk_n; o += hop_n) {
+    long j0 = max(0L, -o);
+    long j1 = min(short_n, blk_n - o);
+
+    // this is the blk position the effects see (used for phase correction)
+    _blk_samp_abs = blk_samp_abs + o;
+
+    for (ch = 0; ch < AUDIO_CHANNELS; ch++) {
+      Chan& chan = _chan[ch];
+
+      // window the frame out of x0
+      Clear(x2, j0);
+      PCopyOut p(x2 + j0);
+      wrapProcess(p, Rng<float>(chan.x0, _x0_sz), _x0_xform_i + o + j0, j1 - j0);
+      for (long j = j0; j < j1; j++)
+        x2[j] *= wdw[j] * fft_scale;
+      Clear(x2 + j1, short_n - j1);
+
+      FFTWf::execute_dft_r2c(g_fft_plan[short_plan], x2, to_fftwf_complex(chan.fft));
+    }
+
+    // new frame in xh, the power plane now refers to it
+    binPwrReset();
+    for (ch = 0; ch < AUDIO_CHANNELS; ch++) {
+      Chan& chan = _chan[ch];
+      chan.total_in_pwr = chan.total_out_pwr = (float)cumPwr(ch)[short_n / 2 + 1];
+      hi_in_pwr[ch] += rngPwr(ch, (long)xover, short_n / 2);
+    }
+
+    for (i = 0; i < BlkFxParam::NUM_FX_SETS; i++)
+      if (in_hi[i])
+        _fx1_0[i].process();
+
+    for (ch = 0; ch < AUDIO_CHANNELS; ch++) {
+      Chan& chan = _chan[ch];
+      XoverBand(chan.fft, short_n / 2 + 1, xover, MULTIRES_RAMP_BINS, /*keep high*/ true);
+      hi_out_pwr[ch] += GetPwr(chan.fft, short_n / 2 + 1);
+
+      // overlap-add the part of the frame that is inside the blk
+      FFTWf::execute_dft_c2r(g_ifft_plan[short_plan], to_fftwf_complex(chan.fft), x2);
+      float* dst = chan.xh_out + o;
+      for (long j = j0; j < j1; j++)
+        dst[j] += x2[j] * wdw[j] * ola_scale;
+    }
+  }
+
+  // restore blk state
+  _plan = blk_plan;
+  _freq_fft_n = blk_n;
+  _blk_samp_abs = blk_samp_abs;
+  binPwrReset();
+  for (ch = 0; ch < AUDIO_CHANNELS; ch++) {
+    Chan& chan = _chan[ch];
+    chan.fft = chan.x1 + 32;
+    chan.total_in_pwr = total_in_pwr[ch];
+    chan.xh_scale = sqrtf(PwrMatchScale(hi_in_pwr[ch], hi_out_pwr[ch], pwr_match));
   }
 }
 
@@ -1317,6 +3282,53 @@ template <class SRC> inline void DtBlkFx::mixToX3(SRC src, int ch)
   // position to start fade-in
   long x3_o = _dst_fft_abs - _curr_samp_abs + _x3_o;
 
+  // wola: add to the run the blk continues or scale the data that a run starts on by the weight
+  // of the blks that would have been before it, copy the rest
+  if (_wola_blk) {
+    long add_n = min(_fadein_n, _time_fft_n - _wola_hop_n);
+    if (add_n > 0 && _wola_run_start) {
+      PSrcDstWrap<SRC, PWgtDst> p;
+      p.src = src;
+      p.dst.wgt = _wola_past + _wola_hop_n;
+      x3_o = wrapProcess(p, _chan[ch].x3, x3_o, add_n);
+      src = p.src;
+    }
+    else if (add_n > 0) {
+      PSrcDstWrap<SRC, PScaleDst> p;
+      p.src = src;
+      p.dst.scale = 1.0f;
+      x3_o = wrapProcess(p, _chan[ch].x3, x3_o, add_n);
+      src = p.src;
+    }
+    if (_time_fft_n > add_n) {
+      PSrcDstWrap<SRC, PBlatDst> p;
+      p.src = src;
+      wrapProcess(p, _chan[ch].x3, x3_o, _time_fft_n - add_n);
+    }
+    return;
+  }
+
+  // the end of a wola run: keep the complete data before the tail, add the weight that's
+  // missing from the tail, copy the rest
+  if (_mix_keep_n + _mix_tail_n > 0) {
+    x3_o += _mix_keep_n;
+    src.advance(_mix_keep_n);
+    if (_mix_tail_n > 0) {
+      PSrcDstWrap<SRC, PCompDst> p;
+      p.src = src;
+      p.dst.wgt = _wola_past + _mix_tail_j;
+      x3_o = wrapProcess(p, _chan[ch].x3, x3_o, _mix_tail_n);
+      src = p.src;
+    }
+    long cp_n = _time_fft_n - _mix_keep_n - _mix_tail_n;
+    if (cp_n > 0) {
+      PSrcDstWrap<SRC, PBlatDst> p;
+      p.src = src;
+      wrapProcess(p, _chan[ch].x3, x3_o, cp_n);
+    }
+    return;
+  }
+
   // use lerp'd mix function for fade in
   if (_fadein_n > 0) {
     PLinInterp<PMix<SRC>> p(_blk_mix_fn, _blk_mix_fn_n);
@@ -1474,20 +3486,377 @@ void LineMix(float* data_0,   // in data array
 }
 
 //-------------------------------------------------------------------------------------------------
-inline void DtBlkFx::ifftAndMixOut()
+inline void DtBlkFx::fftStereoPacked(float* const* src)
 // internal method
-// perform ifft & mix to output
+// fft of src[0] & src[1] to FFTdata(0) & FFTdata(1) with one complex fft
 {
-  // do iFFT, then fade-in, direct copy and fade-out to output buffer
-  for (int i = 0; i < AUDIO_CHANNELS; i++) {
-    Chan& chan = _chan[i];
-    float* x2 = _chan[0].x2; // always use x2 from ch0 to help cache performance
+  const int R = AUDIO_CHANNELS - 1; // right channel (only called for stereo)
+  long n = _freq_fft_n;
+  cplxf* xc = _xc;
+  for (long j = 0; j < n; j++)
+    xc[j] = cplxf(src[0][j], src[R][j]);
+
+  FFTWf::execute_dft(g_cfft_plan[_plan], to_fftwf_complex(xc), to_fftwf_complex(xc));
+
+  // z = x + i*y with x & y real so X[k] = (Z[k] + conj(Z[n-k]))/2 & Y[k] = (Z[k] - conj(Z[n-k]))/2i
+  cplxf* x = FFTdata(0);
+  cplxf* y = FFTdata(R);
+  for (long k = 0; k <= n / 2; k++) {
+    cplxf a = xc[k];
+    cplxf b = conj(xc[k ? n - k : 0]);
+    x[k] = (a + b) * 0.5f;
+    y[k] = (a - b) * cplxf(0.0f, -0.5f);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::ifftStereoPacked()
+// internal method
+// inverse fft of FFTdata(0) & FFTdata(1) to the x2 of each channel with one complex fft
+{
+  const int R = AUDIO_CHANNELS - 1; // right channel (only called for stereo)
+  long n = _freq_fft_n;
+  cplxf* xc = _xc;
+  const cplxf* x = FFTdata(0);
+  const cplxf* y = FFTdata(R);
+
+  // Z = X + i*Y, filling in the negative frequencies from the conjugate symmetry. The imaginary
+  // parts of dc & nyquist are dropped as they are by the real inverse
+  xc[0] = cplxf(x[0].real(), y[0].real());
+  for (long k = 1; k < n / 2; k++) {
+    xc[k] = x[k] + cplxf(-y[k].imag(), y[k].real());
+    xc[n - k] = conj(x[k]) + cplxf(y[k].imag(), y[k].real());
+  }
+  xc[n / 2] = cplxf(x[n / 2].real(), y[n / 2].real());
+
+  FFTWf::execute_dft(g_icfft_plan[_plan], to_fftwf_complex(xc), to_fftwf_complex(xc));
+
+  float* x2_0 = _chan[0].x2;
+  float* x2_1 = _chan[R].x2;
+  for (long j = 0; j < n; j++) {
+    x2_0[j] = xc[j].real();
+    x2_1[j] = xc[j].imag();
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::decimResynth(int ch, float* x2)
+// internal method
+// decimated blk: fill x2 from _data_pre_x0_n for _time_fft_n samples with the input plus the
+// change the effects made to the decimated blk, interpolated back to the full rate (multi-res: the
+// low band on its own, the high band is in xh_out)
+{
+  long d = _decim_n;
+  long k_n = DECIM_ZEROS * d;
+  long m_n = _freq_fft_n / d;
+  const float* g = DecimKernel::get(d);
+
+  // change at the decimated rate, x2 is free until the output is written
+  float* xl = _chan[ch].xl;
+  FFTWf::execute_dft_c2r(g_ifft_plan[_decim_plan], to_fftwf_complex(FFTdata(ch)), x2);
+  if (_multires_blk)
+    Copy(xl, x2, m_n);
+  else {
+    for (long m = 0; m < m_n; m++)
+      xl[m] = x2[m] - xl[m];
+  }
+
+  // polyphase in blocks of d output samples where all of a block's taps are in the blk, one
+  // sample at a time at the ends (wrapping around the blk as the decimation does)
+  enum { Z = DECIM_ZEROS };
+  long t0 = _data_pre_x0_n;
+  long t1 = t0 + _time_fft_n;
+  long m_lo = max((t0 + d - 1) / d, (long)Z - 1);
+  long m_hi = max(m_lo, min(t1 / d, m_n - Z));
+  float* out = x2 + t0;
+  const float* dry = _multires_blk ? NULL : _chan[ch].x0 + _x0_i;
+  for (long t = t0; t < t1; t++) {
+    if (t == m_lo * d && m_lo < m_hi) {
+      const float* poly = DecimKernel::getPoly(d);
+      const float* dry_t = dry ? dry + t - t0 : NULL;
+      if (d == 2)
+        DecimInterpBlks<2>(xl, m_lo, m_hi, poly, dry_t, out + t - t0);
+      else if (d == 4)
+        DecimInterpBlks<4>(xl, m_lo, m_hi, poly, dry_t, out + t - t0);
+      else
+        DecimInterpBlks<8>(xl, m_lo, m_hi, poly, dry_t, out + t - t0);
+      t = m_hi * d - 1;
+      continue;
+    }
+    long m0 = (t + d - 1) / d - Z; // first decimated sample within k_n of t
+    long m1 = (t + k_n) / d;
+    float acc = dry ? dry[t - t0] : 0.0f;
+    for (long m = m0; m <= m1; m++)
+      acc += xl[(m + m_n) % m_n] * g[t - m * d];
+    out[t - t0] = acc;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline int /*DIFF_**/ DtBlkFx::diffRange(int ch, DiffBand& /*out*/ band)
+// internal method
+// find the band of bins that the effects changed on channel "ch" & the cheapest way to
+// resynthesize it
+{
+  const cplxf* y = FFTdata(ch);
+  const cplxf* x = _chan[ch].xd;
+  long n_bins = _freq_fft_n / 2 + 1;
+  long& b0 = band.b0;
+  long& b1 = band.b1;
+
+  for (b0 = 0; b0 < n_bins && !memcmp(y + b0, x + b0, sizeof(cplxf)); b0++) {
+  }
+  for (b1 = n_bins - 1; b1 >= b0 && !memcmp(y + b1, x + b1, sizeof(cplxf)); b1--) {
+  }
+  long w = max(0L, b1 - b0 + 1);
+
+  // rough flop counts: about 5/2*n*log2(n) for the inverse fft, 4 per changed bin per output
+  // sample for the resonators
+  double full = 2.5 * (double)_freq_fft_n * log2((double)_freq_fft_n);
+  double cost = 4.0 * (double)w * (double)_time_fft_n;
+  band.method = cost < full ? DIFF_RESONATOR : DIFF_FULL;
+  full = min(full, cost);
+
+  // pruned: taylor_n complex inverse ffts of length m_n (5*m*log2(m) each) & a term per output
+  // sample for each (4) plus the modulation, the phase across half of the grid spacing is
+  // pi*w/(2*m_n) at the band edges & sets the terms needed
+  for (long p = 0; w > 0 && p < NUM_FFT_SZ; p++) {
+    long m_n = g_fft_sz[p];
+    if (m_n < w || m_n * 2 > _freq_fft_n)
+      continue;
+    double ph = 3.14159265358979 * (double)w / (double)(2 * m_n);
+    double term = ph;
+    long taylor_n = 1;
+    while (term > DIFF_TAYLOR_TOL && taylor_n < DIFF_TAYLOR_MAX) {
+      taylor_n++;
+      term *= ph / (double)taylor_n;
+    }
+    if (term > DIFF_TAYLOR_TOL || taylor_n * m_n > _freq_fft_n)
+      continue;
+
+    cost = 5.0 * (double)(taylor_n * m_n) * log2((double)m_n) +
+           (double)(4 * taylor_n + 8) * (double)_time_fft_n;
+    if (cost < full) {
+      full = cost;
+      band.method = DIFF_PRUNED;
+      band.plan = p;
+      band.taylor_n = taylor_n;
+    }
+  }
+  return band.method;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::diffResynth(int ch, const DiffBand& band, float* /*out*/ out)
+// internal method
+// _time_fft_n samples of the blk from _data_pre_x0_n on: the input plus the inverse of the change
+// to the band, which is what the inverse fft would give (to within float rounding for the
+// resonators & DIFF_TAYLOR_TOL of the change for the pruned inverse)
+{
+  // the inverse fft of a wola blk is the windowed input
+  const float* dry = _chan[ch].x0 + _x0_i;
+  if (_wola_blk) {
+    for (long j = 0; j < _time_fft_n; j++)
+      out[j] = dry[j] * _wola_wdw[j];
+  }
+  else
+    Copy(out, dry, _time_fft_n);
 
-    // inverse fft, always ifft into channel-0 x2 to improve cache hits
+  if (band.method == DIFF_PRUNED) {
+    diffPruned(ch, band, out);
+    return;
+  }
+
+  const cplxf* y = FFTdata(ch);
+  const cplxf* x = _chan[ch].xd;
+  double w0 = 2.0 * 3.14159265358979 / (double)_freq_fft_n;
+
+  for (long b = band.b0; b <= band.b1; b++) {
+    double re = (double)y[b].real() - (double)x[b].real();
+    double im = (double)y[b].imag() - (double)x[b].imag();
+    if (re == 0.0 && im == 0.0)
+      continue;
+
+    // bins other than dc & nyquist stand for their conjugate too (the inverse ignores the
+    // imaginary part of those)
+    double g = b == 0 || 2 * b == _freq_fft_n ? 1.0 : 2.0;
+
+    // g*Re(d*exp(i*w*t)) as a resonator starting at t = _data_pre_x0_n
+    double w = w0 * (double)b;
+    double c = 2.0 * cos(w);
+    double a0 = w0 * (double)(((long long)b * _data_pre_x0_n) % _freq_fft_n);
+    double s0 = g * (re * cos(a0) - im * sin(a0));
+    double s1 = g * (re * cos(a0 - w) - im * sin(a0 - w));
+    for (long j = 0; j < _time_fft_n; j++) {
+      out[j] += (float)s0;
+      double s = c * s0 - s1;
+      s1 = s0;
+      s0 = s;
+    }
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::diffPruned(int ch, const DiffBand& band, float* /*in,out*/ out)
+// internal method
+//
+// add the inverse of the change to the band to "out" (as diffResynth) with short inverse ffts:
+//
+// with the band centred on bin c & k = b-c, the change at sample t of the n long blk is
+// Re(exp(i*2*pi*c*t/n) * z(t)) where z(t) = sum over k of d[k]*exp(i*2*pi*k*t/n) only has the
+// band's bandwidth. At t = (m + r)*n/m_n (m on a grid of m_n points, |r| <= 1/2):
+//
+//   z(t) = sum over p of r^p * u_p[m],  u_p = inverse fft of d[k]*(i*2*pi*k/m_n)^p/p!
+//
+// (taylor series of exp(i*2*pi*k*r/m_n)) so each output sample is a polynomial in r of the
+// taylor_n short inverse ffts at the nearest grid point, modulated up to the band
+//
+{
+  const cplxf* y = FFTdata(ch);
+  const cplxf* x = _chan[ch].xd;
+  long n = _freq_fft_n;
+  long m_n = g_fft_sz[band.plan];
+  long taylor_n = band.taylor_n;
+  long c = (band.b0 + band.b1 + 1) / 2;
+  cplxf* u = _diff_u;
+
+  Clear(u, taylor_n * m_n);
+  float w_m = 2.0f * 3.1415926f / (float)m_n;
+  for (long b = band.b0; b <= band.b1; b++) {
+    cplxf d = y[b] - x[b];
+    if (d.real() == 0.0f && d.imag() == 0.0f)
+      continue;
+
+    // bins other than dc & nyquist stand for their conjugate too (see diffResynth)
+    if (b != 0 && 2 * b != n)
+      d = d * 2.0f;
+
+    long k = b - c;
+    cplxf* u_k = u + (k < 0 ? k + m_n : k);
+    cplxf step(0.0f, w_m * (float)k);
+    for (long p = 0; p < taylor_n; p++, u_k += m_n) {
+      *u_k = d;
+      d = d * step * (1.0f / (float)(p + 1));
+    }
+  }
+  for (long p = 0; p < taylor_n; p++)
+    FFTWf::execute_dft(g_icfft_plan[band.plan], to_fftwf_complex(u + p * m_n),
+                       to_fftwf_complex(u + p * m_n));
+
+  // grid point & offset from it of t = _data_pre_x0_n: t*m_n = m*n + rem with |rem| <= n/2
+  long long t_m = (long long)_data_pre_x0_n * m_n;
+  long m = (long)((t_m + n / 2) / n);
+  long rem = (long)(t_m - (long long)m * n);
+  m %= m_n;
+  float r_scale = 1.0f / (float)n;
+
+  // modulation by the centre bin from t = _data_pre_x0_n
+  double w0 = 2.0 * 3.14159265358979 / (double)n;
+  double a0 = w0 * (double)(((long long)c * _data_pre_x0_n) % n);
+  double mod_re = cos(a0), mod_im = sin(a0);
+  double rot_re = cos(w0 * (double)c), rot_im = sin(w0 * (double)c);
+
+  for (long j = 0; j < _time_fft_n; j++) {
+    float r = (float)rem * r_scale;
+    const cplxf* u_m = u + (taylor_n - 1) * m_n + m;
+    cplxf z = *u_m;
+    for (long p = taylor_n - 1; p > 0; p--) {
+      u_m -= m_n;
+      z = z * r + *u_m;
+    }
+    out[j] += (float)(mod_re * z.real() - mod_im * z.imag());
+
+    double re = mod_re * rot_re - mod_im * rot_im;
+    mod_im = mod_re * rot_im + mod_im * rot_re;
+    mod_re = re;
+
+    rem += m_n;
+    if (2 * rem > n) {
+      rem -= n;
+      if (++m == m_n)
+        m = 0;
+    }
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::resynthPrepare(Resynth& /*out*/ r)
+// internal method
+// work out how each channel of the current blk is resynthesized & do the inverse ffts that are
+// done for all of the channels at once
+{
+  // differential resynthesis if the effects changed a narrow enough band on every channel
+  r.diff = !_memo_hit && _diff_blk && !_multires_blk;
+  r.decim = !_memo_hit && _decim_n > 1;
+  r.pack = _stereo_pack && _xc;
+  for (int i = 0; r.diff && i < AUDIO_CHANNELS; i++)
+    r.diff = diffRange(i, r.diff_band[i]) != DIFF_FULL;
+  if (r.diff) {
+    for (int i = 0; i < AUDIO_CHANNELS; i++)
+      (r.diff_band[i].method == DIFF_PRUNED ? _diff_stats.pruned : _diff_stats.resonator)++;
+  }
+  else if (!_memo_hit && _diff_blk && !_multires_blk)
+    _diff_stats.full += AUDIO_CHANNELS;
+
+  // dual mono blk where the effects have left both channels the same: one inverse for both
+  r.same = !_memo_hit && !r.diff && !r.decim && _dual_mono_blk &&
+           (_dual_mono_fx || !memcmp(FFTdata(0),
+                                     FFTdata(AUDIO_CHANNELS - 1),
+                                     (_freq_fft_n / 2 + 1) * sizeof(cplxf)));
+  if (_memo_hit || r.diff || r.decim) {
+    // time data is already in the cache or made per channel
+  }
+  else if (r.same)
+    FFTWf::execute_dft_c2r(g_ifft_plan[_plan], to_fftwf_complex(FFTdata(0)), _chan[0].x2);
+
+  // stereo packed: both channels are transformed at once to their own x2
+  else if (r.pack)
+    ifftStereoPacked();
+}
+
+//-------------------------------------------------------------------------------------------------
+inline float* /*time data*/ DtBlkFx::resynthChan(const Resynth& r, int i)
+// internal method
+// inverse of channel "i" of the current blk (after resynthPrepare): returns _time_fft_n samples
+// of time data from the start of the blk (in channel-0 x2 unless stereo packed, so only until the
+// next channel is done), memo hits also set the channel's out_scale
+{
+  Chan& chan = _chan[i];
+  float* x2;
+  if (_memo_hit) {
+    x2 = (float*)_memo_hit + i * _memo_time_n;
+    chan.out_scale = _memo_hit[memoScaleOffs() + i];
+    return x2;
+  }
+  bool pack = r.pack && !r.same && !r.diff && !r.decim;
+  x2 = _chan[pack ? i : 0].x2;
+
+  // inverse fft, always ifft into channel-0 x2 to improve cache hits
+  if (r.decim)
+    decimResynth(i, x2);
+  else if (!r.pack && !r.same && !r.diff)
     FFTWf::execute_dft_c2r(g_ifft_plan[_plan], /*in*/ to_fftwf_complex(FFTdata(i)), /*out*/ x2);
 
-    // skip pre data
-    x2 += _data_pre_x0_n;
+  // skip pre data
+  x2 += _data_pre_x0_n;
+
+  if (r.diff)
+    diffResynth(i, r.diff_band[i], x2);
+
+  if (_memo_store) {
+    Copy(_memo_store + i * _memo_time_n, x2, _time_fft_n);
+    _memo_store[memoScaleOffs() + i] = chan.out_scale;
+  }
+  return x2;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::mixOutChan(int i, float* x2, float out_scale, float* x0_dat)
+// internal method
+// mix time data "x2" of channel "i" of the current blk to x3 scaled by "out_scale", the input for
+// the mixback is from "x0_dat" (a copy of x0 for blks processed by a lane)
+{
+  Chan& chan = _chan[i];
 
 #if 0
     // scale data
@@ -1499,20 +3868,59 @@ inline void DtBlkFx::ifftAndMixOut()
     mixToX3(P1Src(x1, /*scale*/1), i);
 #endif
 
-    // output data is completely fft blk
-    float x2_scale = (1.0f - _mixback) * chan.out_scale;
-    if (_mixback <= 0.0f)
-      mixToX3(P1Src(x2, x2_scale), i);
+  // output data is completely fft blk, scaling is applied as the data is mixed to x3
+  float x2_scale = (1.0f - _mixback) * out_scale;
 
+  if (_wola_blk) {
+    // synthesis window, the input is windowed by both to match
+    P1WdwSrc<> wet(x2, _wola_wdw, x2_scale * _wola_scale);
+    if (_mixback <= 0.0f)
+      mixToX3(wet, i);
     else {
-      // output data is a mix of original and processed
+      PSumSrc<P1WdwSrc<>, P1WdwSrc<2>> src;
+      src.a = wet;
+      src.b = P1WdwSrc<2>(x0_dat + _x0_i, _wola_wdw, _mixback * _wola_scale);
+      mixToX3(src, i);
+    }
+  }
+  else if (_multires_blk) {
+    // multi-res: sum the high band into the blk as it is mixed out
+    P1Src xh(chan.xh_out + _data_pre_x0_n, (1.0f - _mixback) * chan.xh_scale);
+    if (_mixback <= 0.0f) {
       P2Src src;
-      float* x0_dat = chan.x0;
+      src.a = P1Src(x2, x2_scale);
+      src.b = xh;
+      mixToX3(src, i);
+    }
+    else {
+      P3Src src;
       src.a = P1Src(x0_dat + _x0_i, _mixback);
       src.b = P1Src(x2, x2_scale);
+      src.c = xh;
       mixToX3(src, i);
     }
   }
+  else if (_mixback <= 0.0f)
+    mixToX3(P1Src(x2, x2_scale), i);
+
+  else {
+    // output data is a mix of original and processed
+    P2Src src;
+    src.a = P1Src(x0_dat + _x0_i, _mixback);
+    src.b = P1Src(x2, x2_scale);
+    mixToX3(src, i);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::ifftAndMixOut()
+// internal method
+// perform ifft & mix to output
+{
+  Resynth r;
+  resynthPrepare(r);
+  for (int i = 0; i < AUDIO_CHANNELS; i++)
+    mixOutChan(i, resynthChan(r, i), _chan[i].out_scale, _chan[i].x0);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -1521,9 +3929,37 @@ inline void DtBlkFx::nextBlk()
 // update everything ready for the next block
 //
 {
+  // wola blks overlap-add to a constant at the hop their window was made for (no sync)
+  if (_wola_blk) {
+    _next_blk_fwd_n = _wola_hop_n;
+    _params_state = PARAMS_CHK_SYNC;
+    _params_need_processing = true;
+    return;
+  }
+
   // get next blk forward
   _next_blk_fwd_n = BlkFxParam::getBlkShiftFwd(get(&GetInterp, _overlap_param), _time_fft_n);
 
+  // adaptive hop: longer (down to the floor overlap but no longer than overlap=0 would be) while
+  // the spectrum is stable
+  if (_adapt_hop) {
+    long max_n = min(BlkFxParam::getBlkShiftFwd(0.0f, _time_fft_n),
+                     (long)((float)_time_fft_n * (1.0f - _adapt_hop_min_overlap)));
+    if (_adapt_hop_stable)
+      _adapt_hop_n = min(_adapt_hop_n + _adapt_hop_n / 2, max_n);
+    else
+      _adapt_hop_n = 0;
+    _next_blk_fwd_n = max(_next_blk_fwd_n, _adapt_hop_n);
+    _adapt_hop_n = _next_blk_fwd_n;
+    _adapt_hop_stable = false;
+  }
+
+  // a cross-faded blk between wola runs has no more than the wola hop so that the next run can
+  // start on the data it leaves
+  if (_wola) {
+    _next_blk_fwd_n = min(_next_blk_fwd_n, _time_fft_n / _wola_hop_div);
+  }
+
   // get the next overlap param to see if blksync is on
 
   // synchronize next blk to start-of-beat position if beat_sync
@@ -1543,10 +3979,35 @@ inline void DtBlkFx::nextBlk()
       _next_blk_fwd_n = sync_fwd;
   }
 
+  // memo cache: start a blk at the start of each host loop pass so that the blks of every pass
+  // see the same input (see _loop_n)
+  if (_loop_n > _min_blk_fwd_samps && _memo.on()) {
+    long next_blk_samp_abs = _blk_samp_abs + _next_blk_fwd_n;
+    long pass = (next_blk_samp_abs - _loop_start_abs) % _loop_n;
+    long sync_fwd = next_blk_samp_abs - (pass < 0 ? pass + _loop_n : pass) - _blk_samp_abs;
+    if (sync_fwd > _min_blk_fwd_samps && sync_fwd <= _next_blk_fwd_n)
+      _next_blk_fwd_n = sync_fwd;
+  }
+
   _params_state = PARAMS_CHK_SYNC;
   _params_need_processing = true;
 }
 
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::mixOutDry()
+// internal method
+// mix the input of the current blk to x3 without processing it (100% mixback)
+{
+  prepMixOut();
+  for (int i = 0; i < AUDIO_CHANNELS; i++) {
+    float* x0_dat = _chan[i].x0;
+    if (_wola_blk)
+      mixToX3(P1WdwSrc<2>(x0_dat + _x0_i, _wola_wdw, _wola_scale), i);
+    else
+      mixToX3(P1Src(x0_dat + _x0_i), i);
+  }
+}
+
 //-------------------------------------------------------------------------------------------------
 inline void DtBlkFx::zeroFillOutput()
 // zero fill x3 if it has no data to output for this blk - this will happen before the first
@@ -1570,9 +4031,10 @@ inline void DtBlkFx::zeroFillOutput()
   // fade out previous data (if there's any in this blk)
   long fade_n = 16; // arbitrary
   long fade_o = zero_o - fade_n;
-  if (fade_o < 0) {
-    fade_n = fade_o;
-    fade_o = 0;
+  long final_o = _out_final_abs - _curr_samp_abs;
+  if (fade_o < final_o) {
+    fade_n -= final_o - fade_o;
+    fade_o = final_o;
   }
   if (fade_n > 0) {
     for (i = 0; i < AUDIO_CHANNELS; i++) {
@@ -1583,6 +4045,114 @@ inline void DtBlkFx::zeroFillOutput()
   }
 
   _x3_end_abs = _buf_end_abs;
+  _x3_tail_abs = _x3_end_abs;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::runBlkStage()
+// internal method
+// run the next stage of the blk in progress (see _blk_stage)
+{
+  int stage = _blk_stage++;
+
+  if (stage == BLK_STAGE_FFT) {
+    _decim_n = 1;
+
+    // non-realtime: random state from the blk position (the same whichever thread runs it)
+    if (_nonrealtime)
+      blkRandSeed();
+
+    // looped input that has been processed before goes straight to the mix out
+    if (memoLookup()) {
+      _blk_stage = BLK_STAGE_MIX;
+      return;
+    }
+    // frozen blks don't need the forward fft
+    if (!freezeFFT()) {
+      _decim_n = decimFactor();
+      doFFT();
+      if (_adapt_hop)
+        adaptHopMeasure();
+      if (_freeze)
+        freezeCapture();
+    }
+    // if (gui())
+    //   gui()->FFTDataRdy(0 /*input*/);
+    procFFTPrepare();
+    if (_freeze)
+      _multires_blk = false;
+  }
+  else if (stage < BLK_STAGE_MIX) {
+    if (_multires_blk) {
+      // the high band frames need all of the fx sets at once
+      procFFTMultiRes();
+      _blk_stage = BLK_STAGE_MIX;
+    }
+    else
+      _fx1_0[stage - BLK_STAGE_FX].process();
+  }
+  else {
+    if (!_multires_blk && !_memo_hit)
+      procFFTDone();
+
+    // Output Spectrogram (Channel 0)
+    long n_bins = _freq_fft_n / 2 + 1;
+    if (_memo_store)
+      Copy(_memo_store + memoOutPwrOffs(), binPwr(/*ch*/ 0, 0, n_bins - 1), n_bins);
+    if (outputSpectrogramCallback) {
+      // usually already up to date from the power matching
+      if (_memo_hit)
+        outputSpectrogramCallback(_memo_hit + memoOutPwrOffs(), n_bins);
+      else
+        outputSpectrogramCallback(binPwr(/*ch*/ 0, 0, n_bins - 1), n_bins);
+    }
+    // if (gui())
+    //   gui()->FFTDataRdy(1 /*output*/);
+
+    prepMixOut();
+    ifftAndMixOut();
+    _memo_hit = NULL;
+    _memo_store = NULL;
+    _blk_stage = BLK_IDLE;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+inline bool /*true=blk finished*/ DtBlkFx::runBlkStages(bool force_out)
+// internal method
+// run the rest of the blk in progress, or when amortizing & its output isn't due yet, an even
+// share of the stages left over the callbacks before it is due
+{
+  long n = NUM_BLK_STAGES;
+  if (_amortize && !force_out) {
+    // callbacks (including this one) before the output is due, assuming the same buffer size
+    long buf_n = _buf_end_abs - _curr_samp_abs;
+    long calls = 1 + (buf_n > 0 ? (_dst_fft_abs - _buf_end_abs) / buf_n : 0);
+    n = (NUM_BLK_STAGES - _blk_stage + calls - 1) / calls;
+  }
+
+  // scratch is shared with other instances so it has to be claimed again for every callback (the
+  // instance's own is used if every shared set is in use)
+  if (!attachScratch()) {
+    // no scratch before the first reserveBlk(), try again on the next callback or if the output
+    // is due, output the input as it is
+    if (!force_out)
+      return false;
+    if (_memo_store)
+      _memo.remove(_memo_key);
+    _memo_store = NULL;
+    _memo_hit = NULL;
+    _multires_blk = false;
+    _blk_stage = BLK_IDLE;
+    mixOutDry();
+    return true;
+  }
+
+  for (; n > 0 && _blk_stage != BLK_IDLE; n--)
+    runBlkStage();
+  detachScratch();
+
+  return _blk_stage == BLK_IDLE;
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -1590,6 +4160,7 @@ inline void DtBlkFx::_process(float** in_buf, long buf_n)
 // internal method
 {
   ScopeCriticalSection scs(_protect);
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
 
   pollUpdate(/*force*/ false);
 
@@ -1600,65 +4171,51 @@ inline void DtBlkFx::_process(float** in_buf, long buf_n)
 
   // process fft-blks in a loop
   while (1) {
-    paramsChk();
+    bool force_out;
+    if (_blk_stage == BLK_IDLE) {
+      paramsChk();
 
-    // how much extra data is there over what we need to process the blk?
-    _extra_data = _x0_n + _data_pre_x0_n - _next_blk_fwd_n - _freq_fft_n;
+      // how much extra data is there over what we need to process the blk?
+      _extra_data = _x0_n + _data_pre_x0_n - _next_blk_fwd_n - _freq_fft_n;
 
-    // determine whether we are forced to output a blk because of the delay or
-    // we've run out of input buffer
-    bool force_out = (_buf_end_abs - _dst_fft_abs > 0 || _x0_n >= _x0_force_out_sz);
+      // determine whether we are forced to output a blk because of the delay or
+      // we've run out of input buffer
+      force_out = (_buf_end_abs - _dst_fft_abs > 0 || _x0_n >= _x0_force_out_sz);
 
-    // chk whether we should process the blk (forced to output or we have interpolate params
-    // and we have enough data for a blk)
-    bool should_proc = force_out || (_params_state == PARAMS_INTERP_OK && _extra_data >= 0);
-    if (!should_proc)
-      break;
+      // chk whether we should process the blk (forced to output or we have interpolate params
+      // and we have enough data for a blk)
+      bool should_proc = force_out || (_params_state == PARAMS_INTERP_OK && _extra_data >= 0);
+      if (!should_proc)
+        break;
 
-    findBlkInPos();
+      findBlkInPos();
 
-    _mixback = get(&GetInterp, _mixback_param);
+      _mixback = get(&GetInterp, _mixback_param);
 
-    // blk mix update
-    _blk_mix_fn_n = get(&GetInterp, _blk_mix_param, _blk_mix_fn);
+      // blk mix update
+      _blk_mix_fn_n = get(&GetInterp, _blk_mix_param, _blk_mix_fn);
 
-    if (_mixback >= 1.0f) {
-      prepMixOut();
-      // no ffts because 100% mixback
-      for (int i = 0; i < AUDIO_CHANNELS; i++) {
-        float* x0_dat = _chan[i].x0;
-        mixToX3(P1Src(x0_dat + _x0_i), i);
+      if (_mixback >= 1.0f) {
+        // no ffts because 100% mixback (after the blks in flight)
+        nrtMix(/*all*/ true);
+        mixOutDry();
+      }
+      else if (!nrtQueue()) {
+        // normal case, we need to do the FFTs
+        _blk_stage = BLK_STAGE_FFT;
       }
     }
     else {
-      // normal case, we need to do the FFTs
-      doFFT();
-      // if (gui())
-      //   gui()->FFTDataRdy(0 /*input*/);
-      prepMixOut();
-
-      procFFT();
-
-      // Output Spectrogram (Channel 0)
-      if (outputSpectrogramCallback) {
-        int i = 0;                               // Left channel
-        float scale = 1.0f / (float)_freq_fft_n; // Re-calculate scale as it's local in doFFT
+      // carrying on with a blk started by a previous callback, is its output due yet?
+      force_out = (_buf_end_abs - _dst_fft_abs > 0 || _x0_n >= _x0_force_out_sz);
+    }
 
-        if (_spectrogram_buffer.size() != _freq_fft_n / 2 + 1)
-          _spectrogram_buffer.resize(_freq_fft_n / 2 + 1);
+    // leave the rest of the blk for following callbacks if its output isn't due
+    if (_blk_stage != BLK_IDLE && !runBlkStages(force_out))
+      break;
 
-        float* spec_out = _spectrogram_buffer.data();
-        CplxfPtrPair spec_in(FFTdata(i), _freq_fft_n / 2 + 1);
-        for (; !spec_in.equal(); spec_in.a++, spec_out++) {
-          *spec_out = norm(*spec_in.a); // Pass magnitude squared (energy) to UI
-        }
-        outputSpectrogramCallback(_spectrogram_buffer.data(), _freq_fft_n / 2 + 1);
-      }
-      // if (gui())
-      //   gui()->FFTDataRdy(1 /*output*/);
-      ifftAndMixOut();
-    }
     nextBlk();
+    _callback_blk_n.store(_callback_blk_n.load() + 1, std::memory_order_relaxed);
 
     // ensure stop if we run out of data to process
     if (_extra_data <= 0)
@@ -1669,11 +4226,21 @@ inline void DtBlkFx::_process(float** in_buf, long buf_n)
   ASSERTX(_buf_end_abs == _curr_samp_abs + buf_n,
           VAR(_buf_end_abs) << VAR(_curr_samp_abs) << VAR(buf_n));
 
+  // blks in flight that output in this callback
+  nrtMix(/*all*/ false);
+
   //
   zeroFillOutput();
 
   // update absolute sample position
   _curr_samp_abs = _buf_end_abs;
+  _out_final_abs = max(_out_final_abs, _curr_samp_abs);
+
+  // callback cost (measured around the host side instead when processing asynchronously)
+  if (!_async)
+    addCallbackCost(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+  _callback_samp_n.store(_callback_samp_n.load() + (double)buf_n, std::memory_order_relaxed);
 }
 
 //-------------------------------------------------------------------------------------------------
@@ -1681,6 +4248,15 @@ void DtBlkFx::process(float** inputs, float** outputs, VstInt32 samps)
 // virtual, override AudioEffect
 // called by vst-host to process data from "inputs" and add to "outputs"
 {
+  RT_CHECK_SCOPE;
+  if (_async) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    asyncProcess(inputs, outputs, samps, /*add*/ true);
+    addCallbackCost(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    return;
+  }
+
   SCOPE_NO_FP_EXCEPTIONS_OR_DENORMALS;
 
   _process(inputs, samps);
@@ -1696,6 +4272,15 @@ void DtBlkFx::processReplacing(float** inputs, float** outputs, VstInt32 samps)
 // virtual, override AudioEffect
 // called by vst-host to process data from "inputs" and replace data in "outputs"
 {
+  RT_CHECK_SCOPE;
+  if (_async) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    asyncProcess(inputs, outputs, samps, /*add*/ false);
+    addCallbackCost(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    return;
+  }
+
   SCOPE_NO_FP_EXCEPTIONS_OR_DENORMALS;
 
   _process(inputs, samps);
@@ -1706,3 +4291,602 @@ void DtBlkFx::processReplacing(float** inputs, float** outputs, VstInt32 samps)
 
   _x3_o = wrap(samps + _x3_o, _chan[0].x3);
 }
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::asyncProcess(float** inputs, float** outputs, long samps, bool add)
+// internal method
+// host side of asynchronous processing, doesn't block: input goes to the worker & output is
+// whatever the worker has finished (zeros if it hasn't kept up)
+{
+  long in_n = _async_in.write(inputs, samps);
+  if (in_n < samps)
+    _async_xruns++;
+  _async_host_abs.store(_async_host_abs.load() + in_n, std::memory_order_release);
+
+  // only wake the worker when it is waiting (it also wakes every ms)
+  if (_async_idle.load()) {
+    RT_CHECK_KNOWN("wakes the idle async worker");
+    _async_wake.notify_one();
+  }
+
+  // stay aligned with the input if earlier callbacks were short of output
+  _async_skip -= _async_out.skip(_async_skip);
+
+  long got_n = _async_skip > 0 ? 0 : _async_out.read(outputs, samps, add);
+  if (got_n < samps) {
+    if (!add) {
+      for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+        Clear(outputs[ch] + got_n, samps - got_n);
+    }
+    _async_skip += samps - got_n;
+    _async_xruns++;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::asyncStart()
+// internal method
+// start the worker thread with empty fifos (output is primed with "_async_delay_n" zeros)
+{
+  if (_async_thread.joinable())
+    return;
+
+  {
+    ScopeCriticalSection scs(_protect);
+    _async_pub_abs = _curr_samp_abs;
+    _async_host_abs = _curr_samp_abs;
+
+    // anything queued while the worker wasn't running is applied now
+    while (const AsyncParam* p = _async_params.front()) {
+      setParameterNow(p->index, p->value);
+      _async_params.pop();
+    }
+  }
+  _async_in.init(1 << 17);
+  _async_out.init(1 << 17);
+  _async_out.write(NULL, min(_async_delay_n, _async_out.size() / 2));
+  _async_skip = 0;
+  _async_quit = false;
+  _async_thread = std::thread(&DtBlkFx::asyncWorker, this);
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::asyncStop()
+// internal method
+// stop the worker thread (must not be called with _protect held)
+{
+  if (!_async_thread.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(_async_mutex);
+    _async_quit = true;
+  }
+  _async_wake.notify_one();
+  _async_thread.join();
+}
+
+//-------------------------------------------------------------------------------------------------
+static bool /*true=ok*/ SetRealtimePriority(double period_secs)
+// give the calling thread real-time priority without putting it ahead of the host's audio threads,
+// "period_secs" is how often it has to produce output. Stays at normal priority if not allowed
+{
+#ifdef _WIN32
+  // hosts run audio at time critical (or in the mmcss "Pro Audio" class, which is higher still)
+  return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST) != 0;
+#elif defined(__APPLE__)
+  // time constraint policy (as core audio's io threads): the thread is promised up to half of
+  // each period & demoted if it tries to take more
+  mach_timebase_info_data_t tb;
+  mach_timebase_info(&tb);
+  double abs_per_sec = 1e9 * (double)tb.denom / (double)tb.numer;
+  thread_time_constraint_policy_data_t pol;
+  pol.period = (uint32_t)(limit_range(period_secs, 1e-3, 0.05) * abs_per_sec);
+  pol.computation = pol.period / 2;
+  pol.constraint = pol.period;
+  pol.preemptible = 1;
+  return thread_policy_set(pthread_mach_thread_np(pthread_self()),
+                           THREAD_TIME_CONSTRAINT_POLICY,
+                           (thread_policy_t)&pol,
+                           THREAD_TIME_CONSTRAINT_POLICY_COUNT) == KERN_SUCCESS;
+#else
+  // lowest fifo priority, hosts (& jack) run audio well above it. Needs rtprio permission
+  sched_param sp;
+  sp.sched_priority = sched_get_priority_min(SCHED_FIFO);
+  return pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) == 0;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::asyncWorker()
+// internal method
+// worker thread, runs _process() on input from the host as soon as it arrives
+// (at real-time priority where allowed, but below the host's audio threads so that it doesn't take
+// cpu time from them)
+{
+  SCOPE_NO_FP_EXCEPTIONS_OR_DENORMALS;
+
+  // output is wanted every host callback
+  _async_rt_priority = SetRealtimePriority((double)_max_buf_n / max(1.0, (double)sampleRate));
+
+  // limit the amount processed at once so that output is published regularly
+  std::vector<float> in_dat(AUDIO_CHANNELS * ASYNC_CHUNK_N);
+  float* in_buf[AUDIO_CHANNELS];
+  for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+    in_buf[ch] = &in_dat[ch * ASYNC_CHUNK_N];
+
+  while (!_async_quit) {
+    {
+      RT_CHECK_SCOPE;
+      long n = asyncParams(min(_async_in.readable(), (long)ASYNC_CHUNK_N));
+      if (n > 0) {
+        _async_in.read(in_buf, n);
+        _process(in_buf, n);
+        asyncPublish(n);
+        continue;
+      }
+    }
+
+    std::unique_lock<std::mutex> lock(_async_mutex);
+    _async_idle = true;
+    if (!_async_quit && _async_in.readable() == 0)
+      _async_wake.wait_for(lock, std::chrono::milliseconds(1));
+    _async_idle = false;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+long /*samples*/ DtBlkFx::asyncParams(long n)
+// internal method
+// worker: apply the queued params that are due at the next input sample & return how much of the
+// "n" samples of input can be processed before the next queued param is due
+{
+  ScopeCriticalSection scs(_protect);
+  while (const AsyncParam* p = _async_params.front()) {
+    long due = p->abs - _curr_samp_abs;
+    if (due > 0) {
+      n = min(n, due);
+      break;
+    }
+    setParameterNow(p->index, p->value);
+    _async_params.pop();
+  }
+
+  // don't process more than can be published (output fifo is full if the host has stopped)
+  if (_curr_samp_abs + n - _async_pub_abs > _async_out.writable())
+    n = 0;
+  return n;
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::asyncPublish(long n)
+// internal method
+// pass on x3 data that's final to _async_out & move on the x3 output index by "n" (the samples
+// just processed)
+{
+  ScopeCriticalSection scs(_protect);
+
+  // data up to where the next blk goes won't change, except for the fade at the end of x3 data
+  // (the next blk position is only known if the params have been checked for it)
+  long final_abs = _curr_samp_abs;
+  if (!_params_need_processing || _blk_stage != BLK_IDLE)
+    final_abs = max(final_abs, min(_dst_fft_abs, _x3_end_abs - 16));
+  _out_final_abs = max(_out_final_abs, final_abs);
+
+  // x3 index of _curr_samp_abs-n is _x3_o
+  _x3_o = wrap(n + _x3_o, _chan[0].x3);
+
+  long pub_n = min(final_abs - _async_pub_abs, _async_out.writable());
+  long i = wrap(_x3_o + (_async_pub_abs - _curr_samp_abs), _chan[0].x3);
+  while (pub_n > 0) {
+    long seg_n = min(pub_n, _x3_sz - i);
+    float* src[AUDIO_CHANNELS];
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+      src[ch] = &_chan[ch].x3[i];
+    _async_out.write(src, seg_n);
+    _async_pub_abs += seg_n;
+    pub_n -= seg_n;
+    i = 0;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::setNonRealtime(bool on, int threads)
+// turn non-realtime processing on or off (see _nonrealtime), blks in flight are mixed out first.
+// Allocates & starts/stops the workers so not from the audio thread
+{
+  if (threads <= 0)
+    threads = (int)std::thread::hardware_concurrency();
+
+  // the thread placing the blks needs a scratch set too
+  threads = limit_range(threads, 1, (int)BlkScratchPool::MAX_SETS - 1);
+  size_t lane_n = on && threads > 1 ? 2 * threads : 0;
+  if (on == _nonrealtime && lane_n == _nrt_lane.size())
+    return;
+
+  nrtStop();
+
+  std::vector<std::unique_ptr<DtBlkFx>> lanes(lane_n);
+  for (size_t k = 0; k < lane_n; k++) {
+    DtBlkFx* lane = new DtBlkFx(NULL);
+    lanes[k].reset(lane);
+    lane->_nonrealtime = true;
+
+    // kept for the thread that mixes the blk out
+    lane->inputSpectrogramCallback = [lane](const float* pwr, int n) {
+      Copy(lane->_nrt_out + AUDIO_CHANNELS * lane->_freq_fft_n, pwr, n);
+    };
+  }
+  {
+    std::lock_guard<std::mutex> alloc_lock(_alloc_mutex);
+    ScopeCriticalSection scs(_protect);
+    _nonrealtime = on;
+    _nrt_lane.swap(lanes);
+    _nrt_head = _nrt_n = 0;
+    _nrt_quit = false;
+  }
+  nrtSizeBufs();
+  reserveBlk();
+
+  for (int i = 0; lane_n && i < threads; i++)
+    _nrt_thread.push_back(std::thread(&DtBlkFx::nrtWorker, this));
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::blkRandSeed()
+// internal method
+// seed the effects' random state from the absolute position of the current blk
+{
+  unsigned long long h = (unsigned long long)(_blk_samp_abs + _samp_abs_origin) * 2654435761ULL;
+  g_rand_i = (long)((h ^ (h >> 32)) & 0x7fffffff) | 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline bool /*true=queued*/ DtBlkFx::nrtQueue()
+// internal method
+// non-realtime: hand the current blk (placed by findBlkInPos) to a lane, false if it has to be
+// processed here (the blks in flight are mixed out first)
+{
+  if (_nrt_lane.empty())
+    return false;
+  RT_CHECK_KNOWN("non-realtime render");
+
+  // blks that depend on the output of the blks before them or on state kept between them
+  bool ok = !_stft_cache && !_freeze && _wola == WOLA_OFF && !_wola_blk && !_multires &&
+            !_adapt_hop && !_memo.on() && _x3_tail_abs >= _x3_end_abs;
+  for (int i = 0; ok && i < BlkFxParam::NUM_FX_SETS; i++)
+    ok = !_fx1_0[i].getFxRun(/*for_display*/ false)->keepsState();
+  if (!ok) {
+    nrtMix(/*all*/ true);
+    return false;
+  }
+
+  // every lane has a blk in flight, make room
+  if (_nrt_n == (long)_nrt_lane.size())
+    nrtMixOldest();
+  DtBlkFx& lane = *_nrt_lane[(_nrt_head + _nrt_n) % _nrt_lane.size()];
+  ScopeCriticalSection lane_scs(lane._protect);
+
+  // the lane has to have been sized for the blk & make the same choices as this instance would
+  bool fits = lane._x0_sz == _x0_sz && lane._blk_alloc_n >= _freq_fft_n &&
+              lane._nrt_out_n >= _freq_fft_n &&
+              (lane._decim_alloc_n >= _freq_fft_n) == (_decim_alloc_n >= _freq_fft_n) &&
+              (lane._diff_alloc_n >= _freq_fft_n) == (_diff_alloc_n >= _freq_fft_n);
+  if (!fits) {
+    nrtMix(/*all*/ true);
+    return false;
+  }
+
+  // unwindowed blks are aligned as doFFT would (it then leaves them as they are)
+  long x0_xform_i = _x0_i - _data_pre_x0_n;
+  if (x0_xform_i < 0)
+    x0_xform_i += _x0_sz;
+  if (blkShoulderN() <= /*arbitrary, as doFFT*/ 12)
+    alignBlkIn(x0_xform_i);
+
+  // a gap after the data in x3 is filled in & the data before it faded out by prepMixOut, which
+  // has to be after the blks in flight have been mixed
+  if (_x3_end_abs < _dst_fft_abs)
+    nrtMix(/*all*/ true);
+  prepMixOut();
+
+  nrtLoad(lane, x0_xform_i);
+  {
+    std::lock_guard<std::mutex> lock(_nrt_mutex);
+    lane._nrt_state = NRT_QUEUED;
+    _nrt_n++;
+  }
+  _nrt_wake.notify_one();
+  return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::nrtLoad(DtBlkFx& lane, long x0_xform_i)
+// internal method
+// copy the current blk to "lane" (with its _protect held): the position, the params & its input
+// at the same x0 positions
+{
+  lane._blk_samp_abs = _blk_samp_abs;
+  lane._samp_abs_origin = _samp_abs_origin;
+  lane._curr_samp_abs = _curr_samp_abs;
+  lane._buf_end_abs = _buf_end_abs;
+  lane._dst_fft_abs = _dst_fft_abs;
+  lane._stereo_diff_abs = _stereo_diff_abs;
+  lane._x0_i = _x0_i;
+  lane._x0_n = _x0_n;
+  lane._x0_n_past_end = _x0_n_past_end;
+  lane._data_pre_x0_n = _data_pre_x0_n;
+  lane._time_fft_n = _time_fft_n;
+  lane._freq_fft_n = _freq_fft_n;
+  lane._plan = _plan;
+  lane._delay_n = _delay_n;
+  lane._extra_data = _extra_data;
+
+  // mix out
+  lane._mixback = _mixback;
+  lane._fadein_n = _fadein_n;
+  lane._fadeout_n = _fadeout_n;
+  lane._blk_mix_fn = _blk_mix_fn;
+  lane._blk_mix_fn_n = _blk_mix_fn_n;
+  lane._mix_keep_n = _mix_keep_n;
+  lane._mix_tail_n = _mix_tail_n;
+  lane._mix_tail_j = _mix_tail_j;
+
+  // modes, the ones that queued blks don't use are off in the lanes
+  lane.sampleRate = sampleRate;
+  lane._samps_per_beat = _samps_per_beat;
+  lane._param_morph_mode = _param_morph_mode;
+  lane._decim = _decim;
+  lane._diff_resynth = _diff_resynth;
+  lane._stereo_pack = _stereo_pack;
+  lane._dual_mono = _dual_mono;
+
+  // params (same sizes, nothing is allocated)
+  lane._params = _params;
+  for (int i = 0; i < BlkFxParam::NUM_FX_SETS; i++) {
+    for (int j = 0; j < BlkFxParam::NUM_FX_PARAMS; j++)
+      lane._fx1_0[i]._param[j] = _fx1_0[i]._param[j];
+  }
+
+  // input read by the blk stages: the transform from x0_xform_i & the dry input from _x0_i, both
+  // may run on past _x0_sz (into the copy past the end or wrapped to the start)
+  long x0_i = _x0_i < x0_xform_i ? _x0_i + _x0_sz : _x0_i;
+  long end_i = max(x0_xform_i + _freq_fft_n, x0_i + _time_fft_n);
+  long lin_n = min(end_i, _x0_sz + (long)MAX_FFT_SZ) - x0_xform_i;
+  for (int i = 0; i < AUDIO_CHANNELS; i++) {
+    Copy(lane._chan[i].x0 + x0_xform_i, _chan[i].x0 + x0_xform_i, lin_n);
+    if (end_i > _x0_sz)
+      Copy(lane._chan[i].x0.ptr, _chan[i].x0.ptr, end_i - _x0_sz);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::nrtRun()
+// internal method
+// lane: fft, effects & inverse of the blk loaded by nrtLoad, leaves the time data, the out_scale
+// of each channel & the power for the spectrogram callbacks for the owner to mix out
+{
+  ScopeCriticalSection scs(_protect);
+
+  // as many threads as sets may be claiming them
+  while (!attachScratch())
+    std::this_thread::yield();
+
+  _blk_stage = BLK_STAGE_FFT;
+  while (_blk_stage != BLK_STAGE_MIX)
+    runBlkStage();
+  procFFTDone();
+
+  long n_bins = _freq_fft_n / 2 + 1;
+  float* out_pwr = _nrt_out + AUDIO_CHANNELS * _freq_fft_n + n_bins;
+  Copy(out_pwr, binPwr(/*ch*/ 0, 0, n_bins - 1), n_bins);
+
+  Resynth r;
+  resynthPrepare(r);
+  for (int i = 0; i < AUDIO_CHANNELS; i++)
+    Copy(_nrt_out + i * _freq_fft_n, resynthChan(r, i), _time_fft_n);
+
+  _blk_stage = BLK_IDLE;
+  detachScratch();
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::nrtSwapMix(DtBlkFx& lane)
+// internal method
+// swap what mixOutChan uses for the current blk with the blk in "lane"
+{
+  std::swap(_dst_fft_abs, lane._dst_fft_abs);
+  std::swap(_x0_i, lane._x0_i);
+  std::swap(_time_fft_n, lane._time_fft_n);
+  std::swap(_mixback, lane._mixback);
+  std::swap(_fadein_n, lane._fadein_n);
+  std::swap(_fadeout_n, lane._fadeout_n);
+  std::swap(_blk_mix_fn, lane._blk_mix_fn);
+  std::swap(_blk_mix_fn_n, lane._blk_mix_fn_n);
+  std::swap(_mix_keep_n, lane._mix_keep_n);
+  std::swap(_mix_tail_n, lane._mix_tail_n);
+  std::swap(_mix_tail_j, lane._mix_tail_j);
+  std::swap(_wola_blk, lane._wola_blk);
+  std::swap(_multires_blk, lane._multires_blk);
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::nrtMixOldest()
+// internal method
+// mix the oldest blk in flight to x3 (processing it here if no worker has started on it)
+{
+  RT_CHECK_KNOWN("non-realtime render");
+  DtBlkFx& lane = *_nrt_lane[_nrt_head];
+  {
+    std::unique_lock<std::mutex> lock(_nrt_mutex);
+    if (lane._nrt_state == NRT_QUEUED) {
+      lane._nrt_state = NRT_BUSY;
+      lock.unlock();
+      lane.nrtRun();
+      lock.lock();
+      lane._nrt_state = NRT_DONE;
+    }
+    while (lane._nrt_state != NRT_DONE)
+      _nrt_done.wait(lock);
+  }
+
+  {
+    ScopeCriticalSection scs(lane._protect);
+    long n_bins = lane._freq_fft_n / 2 + 1;
+    const float* in_pwr = lane._nrt_out + AUDIO_CHANNELS * lane._freq_fft_n;
+    if (inputSpectrogramCallback)
+      inputSpectrogramCallback(in_pwr, n_bins);
+    if (outputSpectrogramCallback)
+      outputSpectrogramCallback(in_pwr + n_bins, n_bins);
+
+    nrtSwapMix(lane);
+    for (int i = 0; i < AUDIO_CHANNELS; i++)
+      mixOutChan(
+          i, lane._nrt_out + i * lane._freq_fft_n, lane._chan[i].out_scale, lane._chan[i].x0);
+    nrtSwapMix(lane);
+
+    _diff_stats.full += lane._diff_stats.full;
+    _diff_stats.resonator += lane._diff_stats.resonator;
+    _diff_stats.pruned += lane._diff_stats.pruned;
+    lane._diff_stats.full = lane._diff_stats.resonator = lane._diff_stats.pruned = 0;
+  }
+
+  std::lock_guard<std::mutex> lock(_nrt_mutex);
+  lane._nrt_state = NRT_FREE;
+  _nrt_head = (_nrt_head + 1) % (long)_nrt_lane.size();
+  _nrt_n--;
+}
+
+//-------------------------------------------------------------------------------------------------
+inline void DtBlkFx::nrtMix(bool all)
+// internal method
+// mix out the blks in flight in order: all of them or up to the last one with output due in this
+// callback (blks can be placed before the blks before them when the delay is reduced)
+{
+  long n = all ? _nrt_n : 0;
+  for (long k = n; k < _nrt_n; k++) {
+    if (_nrt_lane[(_nrt_head + k) % _nrt_lane.size()]->_dst_fft_abs - _buf_end_abs < 0)
+      n = k + 1;
+  }
+  while (n-- > 0)
+    nrtMixOldest();
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::nrtDrop()
+// internal method
+// forget the blks in flight (waiting for any that a worker is part way through)
+{
+  std::unique_lock<std::mutex> lock(_nrt_mutex);
+  for (long k = 0; k < _nrt_n; k++) {
+    DtBlkFx& lane = *_nrt_lane[(_nrt_head + k) % _nrt_lane.size()];
+    while (lane._nrt_state == NRT_BUSY)
+      _nrt_done.wait(lock);
+    lane._nrt_state = NRT_FREE;
+  }
+  _nrt_head = _nrt_n = 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::nrtStop()
+// internal method
+// mix out the blks in flight, stop the workers & free the lanes
+{
+  {
+    ScopeCriticalSection scs(_protect);
+    nrtMix(/*all*/ true);
+  }
+  {
+    std::lock_guard<std::mutex> lock(_nrt_mutex);
+    _nrt_quit = true;
+  }
+  _nrt_wake.notify_all();
+  for (size_t i = 0; i < _nrt_thread.size(); i++)
+    _nrt_thread[i].join();
+  _nrt_thread.clear();
+
+  // freed outside of the locks
+  std::vector<std::unique_ptr<DtBlkFx>> lanes;
+  {
+    std::lock_guard<std::mutex> alloc_lock(_alloc_mutex);
+    ScopeCriticalSection scs(_protect);
+    lanes.swap(_nrt_lane);
+    _nrt_head = _nrt_n = 0;
+    _nonrealtime = false;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::nrtWorker()
+// internal method
+// worker thread, processes the oldest queued blk
+{
+  SCOPE_NO_FP_EXCEPTIONS_OR_DENORMALS;
+
+  std::unique_lock<std::mutex> lock(_nrt_mutex);
+  while (!_nrt_quit) {
+    DtBlkFx* lane = NULL;
+    for (long k = 0; k < _nrt_n && !lane; k++) {
+      DtBlkFx* l = _nrt_lane[(_nrt_head + k) % _nrt_lane.size()].get();
+      if (l->_nrt_state == NRT_QUEUED)
+        lane = l;
+    }
+    if (!lane) {
+      _nrt_wake.wait(lock);
+      continue;
+    }
+    lane->_nrt_state = NRT_BUSY;
+    lock.unlock();
+    lane->nrtRun();
+    lock.lock();
+    lane->_nrt_state = NRT_DONE;
+    _nrt_done.notify_all();
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::nrtSizeBufs()
+// internal method
+// size x0 of the lanes the same as this instance's (blks are loaded at the same positions)
+{
+  std::lock_guard<std::mutex> alloc_lock(_alloc_mutex);
+  for (size_t k = 0; k < _nrt_lane.size(); k++) {
+    DtBlkFx* lane = _nrt_lane[k].get();
+    {
+      ScopeCriticalSection scs(lane->_protect);
+      lane->sampleRate = _bufs_sample_rate;
+      lane->_max_buf_n = _bufs_buf_n;
+      lane->_bufs_sample_rate = 0.0f;
+    }
+    lane->sizeBufs();
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+void DtBlkFx::nrtReserve(long plan, bool decim, bool diff, bool stereo_pack)
+// internal method (from reserveBlk)
+// grow the lanes for blks of "plan" with the modes that are on, the output of a blk in flight is
+// kept
+{
+  long n = g_fft_sz[plan];
+  for (size_t k = 0; k < _nrt_lane.size(); k++) {
+    DtBlkFx* lane = _nrt_lane[k].get();
+    long out_n = lane->_nrt_out_n;
+    ScopeFFTWfMalloc<float> out;
+    if (n > out_n)
+      out.resize(AUDIO_CHANNELS * n + 2 * (n / 2 + 1));
+    {
+      ScopeCriticalSection scs(lane->_protect);
+      lane->_decim = decim;
+      lane->_diff_resynth = diff;
+      lane->_stereo_pack = stereo_pack;
+      if (n > out_n) {
+        if (out_n)
+          Copy(out.ptr, lane->_nrt_out.ptr, AUDIO_CHANNELS * out_n + 2 * (out_n / 2 + 1));
+        std::swap(out.ptr, lane->_nrt_out.ptr);
+        lane->_nrt_out_n = n;
+      }
+    }
+    lane->requestPlan(plan);
+    lane->reserveBlk();
+  }
+}
@@ -26,14 +26,21 @@ General Public License for more details.
 #include "vst2_stub.h"
 
 #include "BlkFxParam.h"
+#include "BlkMemo.h"
 #include "FxState1_0.h"
 #include "MorphParam.h"
 #include "ParamsDelay.h"
+#include "SpscFifo.h"
 #include "VstProgram.h"
 #include "misc_stuff.h"
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <thread>
 
 class Gui;
+class StftCache;
+struct BlkScratch;
 
 //------------------------------------------------------------------------
 class DtBlkFx : public AudioEffectX {
@@ -78,7 +85,6 @@ public: // our own methods
 
   std::function<void(const float*, int)> inputSpectrogramCallback;
   std::function<void(const float*, int)> outputSpectrogramCallback;
-  std::vector<float> _spectrogram_buffer;
 
   // get a global param for display
   bool getParamDisplayGlobal(BlkFxParam::SplitParamNum& p, float v, CharRng text);
@@ -90,8 +96,9 @@ public: // our own methods
         _freq_fft_n * BlkFxParam::getHz(param) / sampleRate, 0.0f, _freq_fft_n * 0.5f);
   }
 
-  // return fixed-position fft buffer (with offset to allow for shift overrun)
-  cplxf* FFTdata(int ch) { return _chan[ch].x1 + 32; }
+  // return current fft buffer (with offset to allow for shift overrun), this is normally x1 but
+  // is switched to xh while the multi-res high band is being processed
+  cplxf* FFTdata(int ch) { return _chan[ch].fft; }
 
   //
   template <int CHANNELS> VecPtr<cplxf, CHANNELS> _FFTdata()
@@ -114,10 +121,46 @@ public: // our own methods
   VecPtr<cplxf, AUDIO_CHANNELS> FFTdata() { return _FFTdata<AUDIO_CHANNELS>(); }
   VecPtr<cplxf, AUDIO_CHANNELS> FFTdataTmp() { return _FFTdataTmp<AUDIO_CHANNELS>(); }
 
+  // return the power (norm) of each bin of FFTdata(ch), indexed the same way as FFTdata, with bins
+  // b0..b1 (inclusive) up to date. The plane is filled in on the first query after the fft and
+  // only bins that have been written since are recalculated
+  const float* binPwr(int ch, long b0, long b1);
+
+  // effects must call one of these after writing bins b0..b1 (inclusive) of FFTdata
+  void binPwrWritten(int ch, long b0, long b1);
+  void binPwrWritten(long b0, long b1)
+  {
+    for (int i = 0; i < AUDIO_CHANNELS; i++)
+      binPwrWritten(i, b0, b1);
+  }
+
+  // forget the whole power plane (FFTdata has been replaced)
+  void binPwrReset()
+  {
+    for (int i = 0; i < AUDIO_CHANNELS; i++) {
+      _chan[i].pwr_b0 = _chan[i].sum_b0 = 0;
+      _chan[i].pwr_b1 = _chan[i].sum_b1 = -1;
+    }
+  }
+
+  // return the cumulative power of FFTdata(ch): sum[b] is the power of bins 0..b-1 (b up to
+  // _freq_fft_n/2+1). It is built from the power plane on first use and the difference of 2
+  // entries stays correct for ranges that haven't been written since
+  const double* cumPwr(int ch);
+
+  // power of bins b0..b1 (inclusive) in constant time (unless the cumulative sum has to be rebuilt)
+  float rngPwr(int ch, long b0, long b1)
+  {
+    Chan& c = _chan[ch];
+    if (b0 < c.sum_b0 || b1 > c.sum_b1)
+      cumPwr(ch);
+    return (float)(c.pwr_sum[b1 + 1] - c.pwr_sum[b0]);
+  }
+
   // for debugging
   bool chkInRng(int ch, cplxf* p, int& offs)
   {
-    offs = p - _chan[ch].x1;
+    offs = p - (_chan[ch].fft - 32);
     return offs >= 0 && offs <= _freq_fft_n / 2;
   }
 
@@ -127,6 +170,9 @@ public: // our own methods
   // guess what the current FFT length will be (for display purposes)
   void guessFFTLen(int& /*return*/ freq_fft_n, int& /*return*/ time_fft_n);
 
+  // input needed before output is independent of earlier input (to skip settling in renders)
+  long /*samples*/ getSettleSamps();
+
   // guess what a frequency will be rounded to (for display purposes)
   float /*hz*/ guessRoundHz(float freq_hz, float bin_adjust_frac = 0.0f);
 
@@ -147,13 +193,70 @@ protected: // internal methods
   void paramsChkSync();
   void paramsChk();
   void findBlkInPos();
+  void adaptBlkLen();
+  void adaptHopMeasure();
   void prepMixOut();
+  void prepWolaTail();
+  int blkShoulderN();
+  long alignBlkIn(long& /*in,out*/ x0_xform_i);
   void doFFT();
-  void procFFT();
+  void doFFTTransform(float* const* src);
+  bool memoLookup();
+  bool freezeFFT();
+  long decimFactor();
+  long decimFactorFor(float top_bin);
+  void decimFFT(float* const* src);
+  void decimResynth(int ch, float* x2);
+  // differential resynthesis: how the change to a channel of a blk is resynthesized
+  enum { DIFF_FULL, DIFF_RESONATOR, DIFF_PRUNED };
+  struct DiffBand {
+    long b0, b1;   // changed bins (b0 > b1 if none)
+    int method;    // DIFF_*
+    long plan;     // DIFF_PRUNED: complex plan of the short inverse ffts
+    long taylor_n; // DIFF_PRUNED: number of them (terms of the interpolation)
+  };
+  int diffRange(int ch, DiffBand& /*out*/ band);
+  void diffResynth(int ch, const DiffBand& band, float* /*out*/ out);
+  void diffPruned(int ch, const DiffBand& band, float* /*in,out*/ out);
+  // how each channel of the current blk is resynthesized (see resynthPrepare)
+  struct Resynth {
+    DiffBand diff_band[AUDIO_CHANNELS];
+    bool diff, decim, pack, same;
+  };
+  void resynthPrepare(Resynth& /*out*/ r);
+  float* resynthChan(const Resynth& r, int ch);
+  void mixOutChan(int ch, float* x2, float out_scale, float* x0_dat);
+  void freezeCapture();
+  void fftStereoPacked(float* const* src);
+  void ifftStereoPacked();
+  void procFFTPrepare();
+  void procFFTDone();
+  bool multiResOk();
+  void procFFTMultiRes();
+  void wolaWindow(long hop_n);
   template <class SRC> void mixToX3(SRC src, int ch);
   void ifftAndMixOut();
   void nextBlk();
   void zeroFillOutput();
+  void runBlkStage();
+  bool runBlkStages(bool force_out);
+  void asyncStart();
+  void asyncStop();
+  void asyncWorker();
+  void asyncPublish(long n);
+  void asyncProcess(float** inputs, float** outputs, long n, bool add);
+  void blkRandSeed();
+  bool nrtQueue();
+  void nrtLoad(DtBlkFx& lane, long x0_xform_i);
+  void nrtRun();
+  void nrtSwapMix(DtBlkFx& lane);
+  void nrtMixOldest();
+  void nrtMix(bool all);
+  void nrtDrop();
+  void nrtStop();
+  void nrtWorker();
+  void nrtSizeBufs();
+  void nrtReserve(long plan, bool decim, bool diff, bool stereo_pack);
 
   void _process(float** in_buf, long buf_n);
 
@@ -177,6 +280,10 @@ public: //
   // absolute sample position of x0[x0_i] and also x1[0]/x2[0] when processing a fft-blk
   long _blk_samp_abs;
 
+  // absolute position of sample 0 as seen by the phase references of the effects (non-zero when
+  // rendering part of a longer signal, not reset by init)
+  long _samp_abs_origin;
+
   long _x0_sz;           // wraping position of x0
   long _x0_force_out_sz; // force output if x0_n exceeds this
 
@@ -189,6 +296,10 @@ public: //
   long _x3_end_abs;  // 1 + abs sample position of final sample in _x3
   bool _x3_is_clear; // true when x3 is initialized with 0's
 
+  // x3 is complete before this, from here to _x3_end_abs it's the tail of a run of wola blks that
+  // the next blk of the run would add to (see _wola_past)
+  long _x3_tail_abs;
+
   enum {
     PARAMS_CHK_SYNC,  // params need to be processed for the current blk
     PARAMS_NONINTERP, // params have been gathered but can't be interpolated
@@ -212,19 +323,533 @@ public: //
   // channel specific data
   struct Chan {
     ScopeFFTWfMalloc<float> x0; // pre FFT circular buffer, note: special alignment
-    ScopeFFTWfMalloc<cplxf> x1; // FFT'd data (frequency-domain), note: special alignment
-    ScopeFFTWfMalloc<float> x2; // IFFT'd data (time-domain) and may be used as a temporary buffer
-                                // during effects, note: special alignment
+    ScopeFFTWfMalloc<cplxf> x1; // FFT'd data (frequency-domain), sized by reserveBlk(), note:
+                                // special alignment
+    ScopeFFTWfMalloc<cplxf> xf; // freeze mode: captured fft data (x1 layout), only allocated once
+                                // freeze mode is used
+    float freeze_pwr;           // total power of xf
     std::valarray<float> x3;    // output FIFO
 
+    // the following are shared scratch (see BlkScratch) and only valid inside _process()
+
+    _PtrBase<float> x2; // IFFT'd data (time-domain) and may be used as a temporary buffer
+                        // during effects, note: special alignment
+    // multi-res mode: short fft data for the high band, note: special alignment
+    _PtrBase<cplxf> xh;
+    // multi-res mode: overlap-added time-domain output of the high band
+    _PtrBase<float> xh_out;
+
+    // fft data currently being processed (x1+32 or xh+32)
+    cplxf* fft;
+
+    // decimated blks: the decimated blk input & then the change the effects made to it, only
+    // allocated once decimation is used
+    ScopeFFTWfMalloc<float> xl;
+
+    // decimated blks: power of the blk above the decimated band (added to the in & out power for
+    // the power matching), 0 for other blks
+    float hi_pwr;
+
+    // differential resynthesis: fft data before the effects, only allocated once differential
+    // resynthesis is used (kept per instance as the mix out may be in a later callback)
+    ScopeFFTWfMalloc<cplxf> xd;
+
+    // power of each bin of "fft" (shared scratch), only bins pwr_b0..pwr_b1 are valid (see
+    // binPwr)
+    _PtrBase<float> pwr;
+    long pwr_b0, pwr_b1;
+
+    // cumulative sum of pwr (shared scratch), differences are valid within sum_b0..sum_b1 (see
+    // cumPwr)
+    _PtrBase<double> pwr_sum;
+    long sum_b0, sum_b1;
+
     float total_in_pwr;  // x1 input power
     float total_out_pwr; // current x1 output power after effects
 
     // these 2 calculated after processing done
     float out_pwr_scale; // pwr scaling (total_in_pwr/total_out_pwr)
     float out_scale;     // sqrt(out_pwr_scale)
+    float xh_scale;      // multi-res mode: as out_scale but for xh_out
   } _chan[AUDIO_CHANNELS];
 
+public: // multi-resolution mode
+  // when on, the spectrum is split at _multires_xover_hz: slots below the crossover run on the
+  // normal (long) fft blk and slots above run on hann windowed ffts that are
+  // _multires_plan_reduce plans shorter, overlap-added across the blk, the two bands are summed in
+  // the time domain before mixing to x3. The low band is processed decimated (see _decim) when
+  // the crossover & its slots allow
+  bool _multires;
+  float _multires_xover_hz;
+  long _multires_plan_reduce;
+
+  enum {
+    MULTIRES_RAMP_BINS = 2 // width of the crossover in high band bins
+  };
+
+  // turn multi-res mode on/off (safe to call from any thread)
+  void setMultiRes(bool on, float xover_hz = 800.0f, long plan_reduce = 8);
+
+public: // stereo packed ffts
+  // when on (stereo only), both channels are transformed with one complex fft per blk (left as
+  // the real part & right as the imaginary part) & split into FFTdata(0) & FFTdata(1) using the
+  // symmetry of real data, the inverse is done the same way. Output matches the per-channel ffts
+  // to within float rounding
+  bool _stereo_pack;
+
+  // complex fft data for both channels (shared scratch, only valid inside _process())
+  _PtrBase<cplxf> _xc;
+
+  // turn stereo packed ffts on/off (safe to call from any thread)
+  void setStereoPack(bool on);
+
+public: // dual mono
+  // when on (stereo only), blks where the input channels are the same are only transformed once,
+  // the effects are only run on channel 0 if they are all FxRun1_0::chanSymmetric & blks where
+  // both spectra are still the same after the effects are only inverse transformed once. The
+  // output is unchanged
+  bool _dual_mono;
+
+  // absolute position just after the last input sample where the channels differed (only kept
+  // up to date while _dual_mono is on)
+  long _stereo_diff_abs;
+
+  // current blk was transformed once for all channels
+  bool _dual_mono_blk;
+
+  // the effects of the current blk run on channel 0 only, procFFTDone copies it to the others
+  bool _dual_mono_fx;
+
+  // number of channels the effects process
+  int fxChannels() { return _dual_mono_fx ? 1 : AUDIO_CHANNELS; }
+
+  // turn dual mono detection on/off (safe to call from any thread)
+  void setDualMono(bool on);
+
+public: // differential resynthesis
+  // when on, the spectrum of each blk is kept from before the effects. If the effects only
+  // changed a band of bins, the output is the input from x0 plus the inverse of the change rather
+  // than a full inverse fft: one resonator per changed bin for a few bins, or a pruned inverse for
+  // wider bands (the band shifted down to dc goes through a few short inverse ffts that are
+  // interpolated & modulated back up, see diffPruned). The full inverse is used when neither is
+  // cheaper. Not used for frozen, memo cache, decimated or multi-res blks
+  bool _diff_resynth;
+
+  // current blk's spectrum from before the effects is in xd
+  bool _diff_blk;
+
+  // largest fft blk that xd & _diff_u have been sized for
+  long _diff_alloc_n;
+
+  enum {
+    DIFF_TAYLOR_MAX = 6 // most short inverse ffts per pruned inverse (_diff_u holds them)
+  };
+  // largest error of the pruned inverse relative to the change
+  static constexpr float DIFF_TAYLOR_TOL = 1e-5f;
+
+  // short inverse ffts of the pruned inverse (blk length, shared by the channels)
+  ScopeFFTWfMalloc<cplxf> _diff_u;
+
+  // channel blks resynthesized each way since the last reset (only written by the blk stages)
+  struct DiffStats {
+    long full, resonator, pruned;
+  };
+  DiffStats _diff_stats;
+
+  // turn differential resynthesis on/off (safe to call from any thread, turning it on may
+  // allocate)
+  void setDiffResynth(bool on);
+
+  // counts of how the blks have been resynthesized while differential resynthesis was on,
+  // optionally starting them again
+  DiffStats getDiffStats(bool reset = false);
+
+public: // decimated low band
+  // when on, blks where every fx set that writes bins does so in place & below DECIM_PASS of the
+  // nyquist of the signal decimated by 2, 4 or 8 are processed at that rate: the blk is low passed
+  // & decimated (windowed sinc), transformed with the correspondingly shorter fft (same bin
+  // spacing so the effects see the same bins) & the change the effects made is interpolated back
+  // & added to the input so the high band passes through unchanged. Checked on every blk so
+  // param changes switch between this & the full rate. Not used in freeze mode. Multi-res blks
+  // always decimate their low band this way (whether or not this is on) when its slots are in
+  // place & the crossover is below DECIM_PASS, the low band is then interpolated back on its own
+  bool _decim;
+
+  enum {
+    DECIM_MAX = 8,   // largest decimation factor
+    DECIM_ZEROS = 6, // zero crossings either side of the kernel centre
+  };
+  // fraction of the decimated nyquist the fx sets must stay below (kernel is flat to about 0.01dB
+  // there & aliases that fold into it are at least 60dB down)
+  static constexpr float DECIM_PASS = 0.6f;
+
+  // decimation factor of the current blk (1=full rate) & the plan of its fft
+  long _decim_n;
+  long _decim_plan;
+
+  // largest fft blk that xl has been sized for
+  long _decim_alloc_n;
+
+  // turn decimated processing on/off (safe to call from any thread, turning it on may allocate)
+  void setDecimate(bool on);
+
+public: // spectral freeze
+  // when on (BlkFxParam::FREEZE), the fft data of the next blk is captured & every blk after that
+  // is resynthesized from it without doing the forward fft (the input is still collected), the fx
+  // sets still run on top of the frozen data. Changing the fft length captures again. Multi-res
+  // processing is off while frozen
+  bool _freeze;
+
+  // phase of the frozen bins on each blk
+  enum {
+    FREEZE_PHASE_HOLD,    // as captured (the blk repeats)
+    FREEZE_PHASE_ADVANCE, // advanced as for a sinusoid at the bin centre
+    FREEZE_PHASE_RANDOM,  // random (same for all channels)
+  };
+  int _freeze_phase;
+
+  // fft length that xf was captured with (0=nothing captured yet) & blk position it came from
+  long _freeze_fft_n;
+  long _freeze_abs;
+
+  // largest fft blk that xf has been sized for
+  long _freeze_alloc_n;
+  long _freeze_rand_i;
+
+  // turn freeze on/off by setting the param (safe to call from any thread, turning it on may
+  // allocate outside of _protect)
+  void setFreeze(bool on, int phase = FREEZE_PHASE_HOLD);
+
+public: // weighted overlap-add
+  // when on (BlkFxParam::WOLA), each blk is the whole fft blk (the shoulder params don't apply),
+  // analysed & resynthesized with the same window "w" where w*w overlap-adds to a constant at the
+  // hop the param picks (half or a quarter of the blk, the overlap param doesn't apply), the
+  // resynthesized blks are added together in x3 rather than cross-faded. This gives joins without
+  // blk artifacts at a much lower blk rate than the cross-fade needs. Beat & param sync are off (a
+  // shorter hop would break the constant sum). Not used for decimated or multi-res blks.
+  //
+  // Only a run of blks with the same window, length & hop sums to a constant, so a blk that
+  // would break the run is cross-faded instead: one that can't be the whole fft blk (not enough
+  // input, adaptive length), a change of FFT_LEN, window, hop or delay, or the first blk.
+  // A cross-faded blk that follows a run adds itself to the incomplete tail of the run with the
+  // weight that is missing from it, the first blk of a run scales the complete data it overlaps
+  // by the weight of the blks that would have been before it
+  int _wola; // window of the current blk's params (BlkFxParam::getWolaWdw)
+  int _wola_hop_div; // & its hop is the blk length divided by this (BlkFxParam::getWolaHopDiv)
+
+  // window types
+  enum {
+    WOLA_OFF,
+    WOLA_HANN,   // sqrt of a periodic hann window
+    WOLA_KAISER, // sqrt of a kaiser kernel convolved with a box the length of the hop (as a
+                 // kaiser-bessel-derived window but for any hop)
+  };
+  // kaiser kernel shape (about 60dB side lobes)
+  static constexpr float WOLA_KAISER_BETA = 8.0f;
+
+  // current blk is windowed & overlap-added
+  bool _wola_blk;
+
+  // "w" for _wola_fft_n, _wola_hop_n & _wola_wdw_type (per instance, only allocated once wola is
+  // used), _wola_fft_n is 0 when it needs working out again
+  ScopeFFTWfMalloc<float> _wola_wdw;
+  long _wola_fft_n, _wola_hop_n;
+  int _wola_wdw_type;
+
+  // 1/(sum of w*w of the blks overlapping any sample)
+  float _wola_scale;
+
+  // _wola_past[j] is the sum of _wola_scale*w*w at sample j of a blk & of all of the blks before
+  // it in a run (the weight that x3 has there after the blk has been added)
+  ScopeFFTWfMalloc<float> _wola_past;
+
+  // how the current blk joins the run (set by prepMixOut): the first _mix_keep_n samples of a
+  // cross-faded blk are left as they are, the next _mix_tail_n are added with 1-_wola_past[] from
+  // _mix_tail_j on. A wola blk starting a run scales the data under it by _wola_past[] from hop on
+  bool _wola_run_start;
+  long _mix_keep_n, _mix_tail_n, _mix_tail_j;
+
+  // largest fft blk that _wola_wdw has been sized for
+  long _wola_alloc_n;
+
+  // select the window (WOLA_OFF=cross-fade blks) & the hop (blk length/"hop_div", 2 or 4) by
+  // setting the param, safe to call from any thread, turning it on may allocate
+  void setWola(int wdw, int hop_div = 4);
+
+public: // adaptive blk length
+  // when on, the input that each blk would output (the _time_fft_n samples at its centre) is
+  // checked for transients (the power of a sub-blk jumping above _adapt_thresh times the mean of
+  // the sub-blks of the blk before it) & blks with one are done with a plan _adapt_plan_reduce
+  // plans shorter than the FFT_LEN param (4 plans per octave), so the shorter blks & their shorter
+  // hop only cover the transients. With wola the change of length is cross-faded (see above). Not
+  // used when frozen
+  bool _adapt_len;
+  long _adapt_plan_reduce;
+  float _adapt_thresh; // power ratio
+
+  // turn adaptive blk length on/off (safe to call from any thread)
+  void setAdaptiveLen(bool on, long plan_reduce = 12, float thresh_db = 9.0f);
+
+public: // adaptive hop
+  // when on, the input spectrum of each blk is summarised as the power in ADAPT_HOP_BANDS log
+  // spaced bands & compared with the blk before it (flux = sum of the change in band magnitude /
+  // sum of the larger band magnitude). While the flux stays below _adapt_hop_flux the hop grows by
+  // half each blk up to a blk overlap of _adapt_hop_min_overlap, it goes straight back to the hop
+  // from the overlap param on change (or when the blk wasn't analysed: memo hits, frozen or 100%
+  // mixback blks). Beat sync still applies. Not used for wola blks
+  bool _adapt_hop;
+  float _adapt_hop_flux;
+  float _adapt_hop_min_overlap;
+
+  enum { ADAPT_HOP_BANDS = 24 };
+
+  // band magnitudes of the last measured blk & its fft length (0=none)
+  float _adapt_hop_band[ADAPT_HOP_BANDS];
+  long _adapt_hop_fft_n;
+
+  // current blk's spectrum is close to the last one
+  bool _adapt_hop_stable;
+
+  // current hop
+  long _adapt_hop_n;
+
+  // turn adaptive hop on/off (safe to call from any thread)
+  void setAdaptiveHop(bool on, float flux = 0.15f, float min_overlap = 0.1f);
+
+public: // offline analysis cache
+  // when set (by the offline renderer), doFFT takes the spectra & total power of each blk from
+  // the cache while it has them for the blk, or appends them if the cache is being written
+  StftCache* _stft_cache;
+
+public: // memo cache
+  // when on (budget > 0), processed blks are kept in a bounded cache keyed by a hash of the input
+  // samples, the params, the phase state of the effects that depend on the blk position (see
+  // FxRun1_0::phasePeriod) & the blk layout so that looped input that lines up with the blk grid
+  // again is only processed once. Effects that keep state between blks (pitch
+  // tracking, random) don't see cached blks. Not used in multi-res or freeze mode
+  BlkMemo _memo;
+
+  // size the cache (0=off) & empty it, allocates so not from the audio thread
+  void setMemoBudget(size_t bytes);
+  BlkMemo::Stats getMemoStats(bool reset = false);
+
+  // host loop from getTimeInfo (cycle positions): absolute sample position of the start of a
+  // pass & its length (0=not looping). While the memo cache is on, each pass starts a blk (see
+  // nextBlk) so that the blk grid lines up with the looped input again & the position in the pass
+  // is part of the key
+  long _loop_start_abs, _loop_n;
+
+  // current blk: its key, entry length & time length it was looked up with
+  uint64_t _memo_key;
+  long _memo_n, _memo_time_n;
+
+  // current blk came from the cache / is being stored in the cache (else NULL)
+  const float* _memo_hit;
+  float* _memo_store;
+
+  // offsets of the things stored after the time data of each channel in an entry
+  long memoScaleOffs() { return AUDIO_CHANNELS * _memo_time_n; }
+  long memoRoundOffs() { return memoScaleOffs() + AUDIO_CHANNELS; }
+  long memoInPwrOffs() { return memoRoundOffs() + 1; }
+  long memoOutPwrOffs() { return memoInPwrOffs() + _freq_fft_n / 2 + 1; }
+
+public: // amortized blk processing
+  // when on, the stages of a blk (fft, each fx set, ifft & mix out) are spread evenly over the
+  // callbacks between the blk's input being complete & its output being due (the output delay)
+  // rather than all being run in one callback. Output is unchanged, only the cpu spikes move
+  bool _amortize;
+
+  // turn amortized processing on/off (safe to call from any thread)
+  void setAmortize(bool on);
+
+  // stages of a blk in the order they're run
+  enum {
+    BLK_IDLE = -1,     // no blk in progress
+    BLK_STAGE_FFT = 0, // fft & collect fx params
+    BLK_STAGE_FX = 1,  // first fx set (one stage per set, all in one for multi-res blks)
+    BLK_STAGE_MIX = BLK_STAGE_FX + BlkFxParam::NUM_FX_SETS, // pwr match, ifft & mix out
+    NUM_BLK_STAGES
+  };
+
+  // next stage of the blk in progress (BLK_IDLE between blks), a blk that isn't idle at the end
+  // of _process() is carried over to the next callback
+  int _blk_stage;
+
+  // time spent in process() or processReplacing() per callback (the host side only when
+  // processing asynchronously), doesn't block
+  struct CallbackCost {
+    double max_secs; // worst case since the last reset
+    double avg_secs;
+    long callbacks;
+    double blk_rate; // blks per second of input
+  };
+  void getCallbackCost(CallbackCost& /*out*/ r, bool reset = false);
+
+  // add a callback that took "secs" (only called by the thread running the callbacks)
+  void addCallbackCost(double secs);
+
+  // running totals only written by the thread running the callbacks (or the worker for the blk
+  // & sample counts), the max is reset by that thread when _callback_max_reset is set
+  std::atomic<double> _callback_max_secs, _callback_sum_secs;
+  std::atomic<long> _callback_n;
+  std::atomic<bool> _callback_max_reset;
+
+  // blks finished & input samples processed (for blk_rate)
+  std::atomic<long> _callback_blk_n;
+  std::atomic<double> _callback_samp_n;
+
+  // totals at the last reset (getCallbackCost only)
+  double _callback_sum_base, _callback_samp_base;
+  long _callback_n_base, _callback_blk_base;
+
+public: // asynchronous processing
+  // when on, process() & processReplacing() only copy input to _async_in & output from
+  // _async_out, a worker thread runs _process() as soon as input arrives. x3 data is passed to
+  // _async_out as soon as no later blk can change it (up to where the next blk starts) so the
+  // worker can run ahead by about the output delay less the fft blk length. "extra_delay_n" adds
+  // latency for when the delay is too short for that. The worker holds _protect while it
+  // processes so the host never takes it: param changes are queued in _async_params & applied by
+  // the worker when it reaches the input position they were set at. The worker runs at normal
+  // priority. Not safe to call while processing
+  void setAsync(bool on, long extra_delay_n = 0);
+  bool _async;
+  long _async_delay_n;
+
+  // param change for the worker, "abs" is the input position (_async_host_abs) it was set at
+  struct AsyncParam {
+    long abs;
+    int index;
+    float value;
+  };
+  MpscQueue<AsyncParam> _async_params;
+
+  // input samples the host has passed to _async_in (as an absolute position)
+  std::atomic<long> _async_host_abs;
+
+  // worker is waiting for input (the host only wakes it then)
+  std::atomic<bool> _async_idle;
+
+  // apply params that are due & return how much of "n" samples of input the worker can process
+  long asyncParams(long n);
+
+  // setParameter() with _protect held
+  void setParameterNow(int index, float value);
+
+  // most the worker processes at once
+  enum { ASYNC_CHUNK_N = 1024 };
+
+  SpscFifo<AUDIO_CHANNELS> _async_in, _async_out;
+
+  // worker only (under _protect): absolute position of the next sample to go to _async_out
+  long _async_pub_abs;
+
+  // host only: output samples owed to _async_out by earlier underruns (skipped to stay aligned)
+  long _async_skip;
+
+  // number of callbacks where input was dropped or output wasn't ready
+  std::atomic<long> _async_xruns;
+
+  std::thread _async_thread;
+  std::atomic<bool> _async_quit;
+
+  // whether the worker got real-time priority (the platform may not allow it)
+  std::atomic<bool> _async_rt_priority;
+  std::mutex _async_mutex;
+  std::condition_variable _async_wake;
+
+  // output before this absolute sample position is final, blks are never placed before it. This
+  // is _curr_samp_abs unless processing asynchronously where data is passed on early
+  long _out_final_abs;
+
+public: // non-realtime processing
+  // when on (the host is rendering offline), the blks are still placed one after the other but
+  // the fft, effects & inverse of each are done by a lane (an instance that only runs the blk
+  // stages) on a worker thread while later blks are placed: the lane takes a copy of the blk's
+  // input, params & position. The blks are mixed to x3 in order once their output is due (or a
+  // lane is needed again) so the overlap-add is the same as processing them here. The effects'
+  // random state is seeded from the blk position (see blkRandSeed) so the output doesn't depend
+  // on the number of threads. Blks that depend on the blks before them are processed here once
+  // the ones in flight have been mixed out: freeze, wola, multi-res, adaptive hop, the memo &
+  // analysis caches & the effects that track between blks (FxRun1_0::keepsState)
+  bool _nonrealtime;
+
+  // turn non-realtime processing on/off with "threads" workers (0=one per cpu, 1=no workers but
+  // the random state is still seeded per blk), allocates so not from the audio thread
+  void setNonRealtime(bool on, int threads = 0);
+
+  // two lanes per worker so they're kept busy while blks are mixed out, the blks in flight are in
+  // _nrt_n lanes from _nrt_head on (in blk order)
+  std::vector<std::unique_ptr<DtBlkFx>> _nrt_lane;
+  long _nrt_head, _nrt_n;
+
+  // lane: where its blk is (changed under the owner's _nrt_mutex)
+  enum { NRT_FREE, NRT_QUEUED, NRT_BUSY, NRT_DONE };
+  int _nrt_state;
+
+  // lane: time data of each channel (_freq_fft_n apart) & the input & output power of channel 0
+  // for the spectrogram callbacks, sized for blks up to _nrt_out_n long
+  ScopeFFTWfMalloc<float> _nrt_out;
+  long _nrt_out_n;
+
+  std::vector<std::thread> _nrt_thread;
+  bool _nrt_quit;
+  std::mutex _nrt_mutex;
+  std::condition_variable _nrt_wake, _nrt_done;
+
+public: // buffer sizing
+  // nothing is allocated on the audio thread: x0 & x3 are sized for the sample rate by resume()
+  // & the fft blk buffers by reserveBlk(). A blk longer than they've been allocated for is done at
+  // the longest length they have been & asks for them to be grown by the next reserveBlk()
+
+  // longest delay that x3 is sized for
+  static constexpr float MAX_DELAY_SECS = 3.0f;
+
+  // sample rate & most input per callback that x0 & x3 were sized for, most input per callback
+  // from setBlockSize()
+  float _bufs_sample_rate;
+  long _bufs_buf_n, _max_buf_n;
+
+  // size x0 & x3 (from resume)
+  void sizeBufs();
+
+  // largest fft blk (& its plan) that x1 has been sized for
+  long _blk_alloc_n;
+  long _blk_alloc_plan;
+
+  // largest plan asked for by setParameter or by a blk that had to be done shorter
+  std::atomic<long> _blk_req_plan;
+  void requestPlan(long plan);
+
+  // grow per-instance buffers & the scratch shared between instances for the largest plan asked
+  // for & the modes that are on. Not from the audio thread (the plugin calls it from a timer), it
+  // does nothing if there is nothing to grow
+  void reserveBlk();
+  std::mutex _alloc_mutex;
+
+  // claim shared scratch for the blk stages of a callback (see BlkScratchPool) & release it
+  bool attachScratch();
+  void detachScratch();
+  int _scratch_set;     // claimed set (-1=none or own)
+  BlkScratch* _scratch; // attached scratch (NULL=none)
+
+  // scratch for when every shared set is in use (more threads processing at once than there are
+  // sets) so that a blk is never output unprocessed, grown with the shared sets by reserveBlk
+  BlkScratch* _own_scratch;
+
+  // callbacks that used _own_scratch because no shared set was free (diagnostic only)
+  long _scratch_misses;
+
+  // let the input of the current blk through unprocessed
+  void mixOutDry();
+
+  // memory used by this instance and by the scratch shared between instances
+  struct MemReport {
+    size_t x0, x1, x3, other; // per instance
+    size_t scratch;           // shared with other instances
+    size_t instance() const { return x0 + x1 + x3 + other; }
+  };
+  void getMemReport(MemReport& /*out*/ r);
+
 public: // temporary variables used during blk processing
   // sample position of next call to _process() (1+end of current buffer)
   long _buf_end_abs;
@@ -253,6 +878,12 @@ public: // temporary variables used during blk processing
   // mixback multiplier
   float _mixback;
 
+  // x0 position of the first sample that was fft'd
+  long _x0_xform_i;
+
+  // true if the current blk is being processed in multi-res mode
+  bool _multires_blk;
+
 public: // polled variables that are updated periodically
   // samples per beat
   float _samps_per_beat;
@@ -55,6 +55,7 @@ TODO:
 #include "Debug.h"
 
 #include "SinCosTable.h"
+#include "fast_math.h"
 
 #include "DtBlkFx.hpp"
 #include "FxRun1_0.h"
@@ -63,10 +64,8 @@ TODO:
 
 using namespace std;
 
-// constants
-enum { AUDIO_CHANNELS = BlkFxParam::AUDIO_CHANNELS };
-
-long g_rand_i = 1;
+// per thread so that offline renders on several threads are repeatable
+thread_local long g_rand_i = 1;
 
 //*************************************************************************************************
 class PhaseCorrect
@@ -91,7 +90,7 @@ public:
   // MUST call init before use
   void init(DtBlkFx* b)
   {
-    _mult = (long long)b->_blk_samp_abs * g_sincos_table.LEN;
+    _mult = (long long)(b->_blk_samp_abs + b->_samp_abs_origin) * g_sincos_table.LEN;
     _fft_len = b->_freq_fft_n;
   }
 };
@@ -101,7 +100,7 @@ public:
 // initialize phase correction
 void init(ShiftPhaseCorrect& phase_corr, DtBlkFx* b)
 {
-  phase_corr.init(b->_blk_samp_abs, b->_freq_fft_n);
+  phase_corr.init(b->_blk_samp_abs + b->_samp_abs_origin, b->_freq_fft_n);
 }
 
 // initialize temporary buffer
@@ -162,6 +161,8 @@ void FxRun1_0::_fillValues(Rng<float> values)
   }
 }
 
+enum { AUDIO_CHANNELS = BlkFxParam::AUDIO_CHANNELS };
+
 //*************************************************************************************************
 class ProcessBase
 //
@@ -174,12 +175,20 @@ public:
   // blkfx that state is attached to
   _Ptr<DtBlkFx> _b;
 
+  // channels to process (only channel 0 of dual mono blks, see DtBlkFx::fxChannels)
+  int _n_ch;
+
   ProcessBase(FxState1_0* s)
   {
     _s = s;
     _b = s->_b;
+    _n_ch = _b->fxChannels();
   }
 
+  // true if run(b0, b1) only writes bins b0..b1 (so a mask can keep using the power plane of bins
+  // that haven't been run yet)
+  enum { IN_PLACE = 0 };
+
   // whether to process backwards or not
   bool reverse() { return false; }
 
@@ -201,6 +210,8 @@ class AmpProcess
 //
 {
 public:
+  enum { IN_PLACE = 1 };
+
   float _amp;
 
   AmpProcess(FxState1_0* s, float amp)
@@ -217,9 +228,12 @@ public:
   // apply scaling from bin b0 to b1
   void run(long b0, long b1)
   {
-    VecPtr<cplxf, AUDIO_CHANNELS> d = _b->FFTdata();
-    for (int i = b0; i <= b1; i++)
-      d[i] *= _amp;
+    for (int ch = 0; ch < _n_ch; ch++) {
+      cplxf* d = _b->FFTdata(ch);
+      for (long i = b0; i <= b1; i++)
+        d[i] *= _amp;
+    }
+    _b->binPwrWritten(b0, b1);
   }
 };
 
@@ -233,6 +247,8 @@ public:
   // process that we're driving
   _Ptr<T> _process;
 
+  enum { IN_PLACE = T::IN_PLACE };
+
   MaskProcessBase(FxState1_0* s)
       : ProcessBase(s)
   {
@@ -463,13 +479,16 @@ public:
     if (b0 > b1)
       swap(b0, b1);
 
-    // always peak find on the left channel for stereo
-    base::init(fx_val,
-               PeakFindFft(base::_b->FFTdata(/*left*/ 0),
-                           b0,
-                           b1,
-                           /*estimate fundamental*/ 5.0f) // find fft peak bin
-    );
+    // always track the fundamental on the left channel for stereo
+    DtBlkFx* b = base::_b;
+    PitchTrack& track = base::_s->pitch_track[0];
+    track(b->FFTdata(/*left*/ 0),
+          b0,
+          b1,
+          b->rngPwr(/*left*/ 0, b0, b1),
+          b->_freq_fft_n,
+          /*estimate fundamental*/ 5.0f);
+    base::init(fx_val, track);
   }
 };
 
@@ -548,6 +567,9 @@ public:
   // width_bins*2 + 1
   long _width2_bins;
 
+  // channel 0 power plane (only valid from b0..b1 in run)
+  const float* _pwr;
+
   //
   ThreshMaskProcess(FxState1_0* s, //
                     T& process,
@@ -565,11 +587,18 @@ public:
     _thresh_param = powf(thresh_param, 0.8f);
   }
 
+  // power of a channel 0 bin, bins ahead of the scan are only written by the process we drive if
+  // it isn't in-place, in which case the power plane can't be used
+  float pwr(cplxf* x)
+  {
+    return T::IN_PLACE ? _pwr[x - base::_b->FFTdata(/*channel*/ 0)] : norm(*x);
+  }
+
   template <int DIR /*1=fwd, -1=rev*/>
   bool /*peak found*/ findThreshBrk(float thresh_val, CplxfPtrPair& /*in-out*/ dat)
   {
     while (!dat.equal()) {
-      float t = norm(*dat.a);
+      float t = pwr(dat.a);
       if (SELECT_BELOW ? t < thresh_val : t >= thresh_val)
         return true;
       dat.a += DIR;
@@ -581,10 +610,11 @@ public:
   {
 
     // find min & max pwr of channel 0
-    CplxfPtrPair dat(base::_b->FFTdata(/*channel*/ 0), b0, b1 + 1);
+    _pwr = base::_b->binPwr(/*channel*/ 0, b0, b1);
     FindMinMax<float> pwr_lim(1e30f, 1e-30f);
-    for (; !dat.equal(); dat.a++)
-      pwr_lim(norm(*dat.a));
+    for (long b = b0; b <= b1; b++)
+      pwr_lim(_pwr[b]);
+    CplxfPtrPair dat;
 
     // determine threshold by lerp min & max values
     float thresh_val = exp_interp(_thresh_param, pwr_lim);
@@ -700,6 +730,12 @@ public:
   }
 
   virtual bool isMask() { return true; }
+
+  // the auto masks (searching freq a..b for the fundamental) track it between blks
+  virtual bool keepsState() { return _params_used[BlkFxParam::FX_FREQ_B]; }
+
+  // the fundamental is found on channel 0, so the same for each channel of dual mono blks
+  virtual bool chanSymmetric() { return true; }
 };
 HarmMaskFx g_harm_mask("HarmMask", /*freq_b_param_used*/ false);
 HarmMaskFx g_auto_harm_mask("AutoHarmMask", /*freq_b_param_used*/ true);
@@ -736,6 +772,9 @@ public:
 
   virtual bool isMask() { return true; }
 
+  // the threshold is found on channel 0
+  virtual bool chanSymmetric() { return true; }
+
 } g_thresh_mask;
 
 //-------------------------------------------------------------------------------------------------
@@ -900,6 +939,10 @@ public:
     return HarmDispVal(text, val);
   }
 
+  virtual bool inPlace() { return true; }
+
+  virtual bool chanSymmetric() { return true; }
+
 } g_harm_filt_fx;
 
 //*************************************************************************************************
@@ -911,6 +954,10 @@ public:
   {
     memset(_params_used, 0, sizeof(_params_used));
   }
+
+  virtual bool inPlace() { return true; }
+
+  virtual bool chanSymmetric() { return true; }
 } g_no_fx;
 
 //*************************************************************************************************
@@ -929,6 +976,10 @@ public:
     MaskedRun(s, amp);
   }
 
+  virtual bool inPlace() { return true; }
+
+  virtual bool chanSymmetric() { return true; }
+
 } g_filter_fx;
 
 //*************************************************************************************************
@@ -971,15 +1022,11 @@ struct ContrastProcess
   //
   void run(long b0, long b1)
   {
-    for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
-      CplxfPtrPair dat(_b->FFTdata(ch), b0, b1 + 1), x;
+    for (int ch = 0; ch < _n_ch; ch++) {
+      CplxfPtrPair dat(_b->FFTdata(ch), b0, b1 + 1);
 
       // input power for this range
-      float in_pwr = 0;
-
-      // find input power
-      for (x = dat; !x.equal(); x.a++)
-        in_pwr += norm(*x.a);
+      float in_pwr = _b->rngPwr(ch, b0, b1);
 
       // find scale factor to normalize power to make sure powf works correctly
       float scale = MatchPwr(/*scale*/ 1.0f, /*target*/ (float)(b1 - b0 + 1), /*current*/ in_pwr);
@@ -995,7 +1042,7 @@ struct ContrastProcess
         if (t < _min_v)
           xc = 0.0f;
         else if (t < _max_v)
-          xc = xc * powf(t, _raise); // equivalent to abs(*x) <= abs(*x)^(2*raise+1)
+          xc = xc * FastPow<FAST_MATH_TIER>(t, _raise); // abs(*x) <= abs(*x)^(2*raise+1)
 
         out_pwr += norm(xc);
         *x = xc;
@@ -1007,6 +1054,7 @@ struct ContrastProcess
                /*current*/ out_pwr,
                CplxfPtrPair(_b->FFTdata(ch), b0, b1 + 1));
     }
+    _b->binPwrWritten(b0, b1);
   }
 };
 
@@ -1030,6 +1078,10 @@ public:
     return text << spr_percent(val * 2 - 1);
   }
 
+  virtual bool inPlace() { return true; }
+
+  virtual bool chanSymmetric() { return true; }
+
 } g_contrast_fx;
 
 //******************************************************************************************
@@ -1048,13 +1100,14 @@ struct SmearProcess : public AmpProcess {
   //
   {
     long rand_i = g_rand_i;
-    for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+    for (int ch = 0; ch < _n_ch; ch++) {
       for (CplxfPtrPair x(_b->FFTdata(ch), b0, b1 + 1); !x.equal(); x.a++) {
         *x = /*AmpProcess::*/ _amp * (*x) * (g_sincos_table[rand_i] * _smear + 1.0f - _smear);
         rand_i = prbs32(rand_i);
       }
     }
     g_rand_i = rand_i;
+    _b->binPwrWritten(b0, b1);
   }
 };
 
@@ -1078,6 +1131,8 @@ public:
     return text << spr_percent(val);
   }
 
+  virtual bool inPlace() { return true; }
+
 } g_smear_fx;
 
 //-------------------------------------------------------------------------------------------------
@@ -1110,6 +1165,10 @@ public:
     return ThreshDispVal(text, val);
   }
 
+  virtual bool inPlace() { return true; }
+
+  virtual bool chanSymmetric() { return true; }
+
 } g_thresh_fx;
 
 //*************************************************************************************************
@@ -1130,14 +1189,15 @@ struct ClipProcess
   void run(long b0, long b1)
   // clip bins with magnitude higher than the threshold
   {
-    for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+    for (int ch = 0; ch < _n_ch; ch++) {
 
       CplxfPtrPair fft_data(_b->FFTdata(ch), b0, b1 + 1), x;
+      const float* pwr = _b->binPwr(ch, b0, b1) + b0;
 
       // find min & max pwr of channel 0
       FindMinMax<float> pwr_lim(1e30f, 1e-30f);
-      for (x = fft_data; !x.equal(); x.a++)
-        pwr_lim(norm(*x.a));
+      for (long i = 0; i <= b1 - b0; i++)
+        pwr_lim(pwr[i]);
 
       // determine clip-threshold by interpolating min & max values (note that a thresh param of
       // 0 means not very much clipping should be done)
@@ -1147,8 +1207,8 @@ struct ClipProcess
       // do cliping
       float in_pwr = 0;
       float out_pwr = 0;
-      for (x = fft_data; !x.equal(); x.a++) {
-        float t0 = norm(*x.a);
+      for (x = fft_data; !x.equal(); x.a++, pwr++) {
+        float t0 = *pwr;
         in_pwr += t0;
         if (t0 >= thresh) {
           float t1 = sqrt_thresh / sqrtf(t0);
@@ -1162,6 +1222,7 @@ struct ClipProcess
       // adjust pwr to match that before clipping
       MatchPwr(AmpProcess::_amp, in_pwr, out_pwr, fft_data);
     }
+    _b->binPwrWritten(b0, b1);
   }
 };
 
@@ -1185,6 +1246,10 @@ public:
     return text << spr_percent(val);
   }
 
+  virtual bool inPlace() { return true; }
+
+  virtual bool chanSymmetric() { return true; }
+
 } g_clip_fx;
 
 //*************************************************************************************************
@@ -1200,6 +1265,9 @@ class ShiftProcess
 //
 {
 public:
+  // writes outside of b0..b1
+  enum { IN_PLACE = 0 };
+
   // max bin
   long _max_bin;
 
@@ -1285,7 +1353,7 @@ public:
 
     if (_reverse) {
       // process spectrum in reverse (shift up)
-      for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+      for (int ch = 0; ch < _n_ch; ch++) {
         cplxf* xd = _b->FFTdata(ch) + dst_bin + n_bins;
         for (CplxfPtrPair xs(_b->FFTdata(ch), src_bin + n_bins - 1, src_bin - 1); !xs.equal();
              xs.a--, xd--)
@@ -1294,7 +1362,7 @@ public:
     }
     else {
       // process spectrum forwards (shift down)
-      for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+      for (int ch = 0; ch < _n_ch; ch++) {
         cplxf* xd = _b->FFTdata(ch) + dst_bin;
         for (CplxfPtrPair xs(_b->FFTdata(ch), src_bin, src_bin + n_bins); !xs.equal(); xs.a++, xd++)
           run(xd, xs.a);
@@ -1518,14 +1586,23 @@ public:
 
   virtual bool ampMixMode() { return true; }
 
+  // whole bin shifts (see PhaseCorrect)
+  virtual long long phasePeriod(long fft_n) { return fft_n; }
+
+  virtual bool chanSymmetric() { return true; }
+
 } g_shift_fx;
 
 //*************************************************************************************************
+template <int CHANNELS>
 class ConstShiftProcess
     : public AmpProcess
 // shift frequency up or down by a constant number of Hz
 {
 public:
+  // writes outside of b0..b1
+  enum { IN_PLACE = 0 };
+
   static float /*Hz*/ paramToHz(float v /*0..1*/)
   //
   // Convert freq shift param to Hz
@@ -1550,7 +1627,7 @@ public:
   }
 
 public:
-  FrqShiftFft<AUDIO_CHANNELS> _shift;
+  FrqShiftFft<CHANNELS> _shift;
 
   // frequency shift in bins
   FixPoint<12> _frq_shift;
@@ -1574,7 +1651,8 @@ public:
 
   void run(long b0, long b1)
   {
-    _shift.run</*CONJ*/ 0>(/*src first*/ b0, /*src last*/ b1, /*dst first*/ b0 + _frq_shift);
+    _shift.template run</*CONJ*/ 0>(
+        /*src first*/ b0, /*src last*/ b1, /*dst first*/ b0 + _frq_shift);
   }
 
   void done() { _shift.flush(); }
@@ -1594,19 +1672,32 @@ public:
     _fillValues(TO_RNG(values));
   }
 
-  virtual void process(FxState1_0* s)
+  template <int CHANNELS> void processCh(FxState1_0* s)
   {
-    ConstShiftProcess shift(s);
+    ConstShiftProcess<CHANNELS> shift(s);
     MaskedRun(s, shift);
   }
 
+  virtual void process(FxState1_0* s)
+  {
+    if (s->_b->fxChannels() == 1)
+      processCh<1>(s);
+    else
+      processCh<AUDIO_CHANNELS>(s);
+  }
+
   virtual Rng<char> /*updated*/ dispVal(FxState1_0*, Rng<char> /*out*/ text, float /*0..1*/ val)
   {
-    return text << sprnum(ConstShiftProcess::paramToHz(val), /*min unit*/ 1.0f) << "Hz";
+    return text << sprnum(ConstShiftProcess<1>::paramToHz(val), /*min unit*/ 1.0f) << "Hz";
   }
 
   virtual bool ampMixMode() { return true; }
 
+  // shifts in 1/4096 bins (see ShiftPhaseCorrect)
+  virtual long long phasePeriod(long fft_n) { return (long long)fft_n << 12; }
+
+  virtual bool chanSymmetric() { return true; }
+
 } g_const_shift_fx;
 
 //*************************************************************************************************
@@ -1637,16 +1728,24 @@ public:
     return HarmDispVal(text, val);
   }
 
+  // tracks the fundamental between blks
+  virtual bool keepsState() { return true; }
+
+  virtual bool chanSymmetric() { return true; }
 } g_auto_harm_fx;
 
 //*************************************************************************************************
+template <int CHANNELS>
 class ResizeProcess
     : public AmpProcess
 // resize can resize in the freq & time domains
 {
 public:
+  // writes outside of b0..b1
+  enum { IN_PLACE = 0 };
+
   //
-  FrqShiftFft<AUDIO_CHANNELS> _shift;
+  FrqShiftFft<CHANNELS> _shift;
 
   // frequency scaling to apply to bins
   FixPoint<12> _frq_mult;
@@ -1668,15 +1767,15 @@ public:
   void run(long b0, long b1)
   {
     if (_conjugate_mode)
-      _shift.run</*CONJ*/ 1>(/*src first*/ b0,
-                             /*src last*/ b1,
-                             /*dst*/ (b0 + b1 - (b1 - b0 + 1) * _frq_mult) / 2,
-                             /*dst scale*/ _frq_mult);
+      _shift.template run</*CONJ*/ 1>(/*src first*/ b0,
+                                      /*src last*/ b1,
+                                      /*dst*/ (b0 + b1 - (b1 - b0 + 1) * _frq_mult) / 2,
+                                      /*dst scale*/ _frq_mult);
     else
-      _shift.run</*CONJ*/ 0>(/*src first*/ b0,
-                             /*src last*/ b1,
-                             /*dst*/ (b0 + b1 - (b1 - b0 + 1) * _frq_mult) / 2,
-                             /*dst scale*/ _frq_mult);
+      _shift.template run</*CONJ*/ 0>(/*src first*/ b0,
+                                      /*src last*/ b1,
+                                      /*dst*/ (b0 + b1 - (b1 - b0 + 1) * _frq_mult) / 2,
+                                      /*dst scale*/ _frq_mult);
   }
 
   void done() { _shift.flush(); }
@@ -1704,7 +1803,7 @@ public:
     _fillValues(TO_RNG(values));
   }
 
-  virtual void process(FxState1_0* s)
+  template <int CHANNELS> void processCh(FxState1_0* s)
   {
     Param p(s->temp.val);
 
@@ -1718,10 +1817,18 @@ public:
       conj_mode = !conj_mode;
 
     // do the resize
-    ResizeProcess resize(s, p.f_part, conj_mode);
+    ResizeProcess<CHANNELS> resize(s, p.f_part, conj_mode);
     MaskedRun(s, resize);
   }
 
+  virtual void process(FxState1_0* s)
+  {
+    if (s->_b->fxChannels() == 1)
+      processCh<1>(s);
+    else
+      processCh<AUDIO_CHANNELS>(s);
+  }
+
   virtual Rng<char> /*updated*/ dispVal(FxState1_0*, Rng<char> /*out*/ text, float /*0..1*/ val)
   {
     Param p(val);
@@ -1729,6 +1836,11 @@ public:
   }
   virtual bool ampMixMode() { return true; }
 
+  // shifts in 1/4096 bins (see ShiftPhaseCorrect)
+  virtual long long phasePeriod(long fft_n) { return (long long)fft_n << 12; }
+
+  virtual bool chanSymmetric() { return true; }
+
 } g_resize_fx;
 
 //*************************************************************************************************
@@ -1785,8 +1897,8 @@ public:
     if (harm0_pwr <= 0)
       return;
 
-    for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
-      _pwr_scale[ch] = GetPwr(_b->FFTdata(ch), f0, f1) / harm0_pwr;
+    for (int ch = 0; ch < _n_ch; ch++) {
+      _pwr_scale[ch] = _b->rngPwr(ch, f0, f1) / harm0_pwr;
       if (_copy_mode)
         _pwr_scale[ch] *= _amp * _amp;
     }
@@ -1796,7 +1908,7 @@ public:
       : AmpProcess(s)
   {
     // default for pwr scale
-    for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+    for (int ch = 0; ch < _n_ch; ch++)
       _pwr_scale[ch] = 1.0f;
 
     _n_harms = harm_data.n_harms;
@@ -1854,7 +1966,7 @@ public:
         return;
 
       // do the copy for each channel from the fundamental
-      for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+      for (int ch = 0; ch < _n_ch; ch++) {
         // copy mode
         cplxf* src = _b->FFTdata(ch) + f0;
 
@@ -1882,9 +1994,9 @@ public:
     else {
 
       // scale mode
-      for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+      for (int ch = 0; ch < _n_ch; ch++) {
         // find what we need to scale the existing data by to match the harmonic power
-        float orig_pwr = GetPwr(_b->FFTdata(ch), b0, b1);
+        float orig_pwr = _b->rngPwr(ch, b0, b1);
         float target_pwr = _pwr_scale[ch] * harm_pwr;
 
         // attempt to match to harmonic pwr
@@ -1894,6 +2006,7 @@ public:
           *x = (*x) * scale;
       }
     }
+    _b->binPwrWritten(b0, b1);
   }
 };
 
@@ -1920,21 +2033,21 @@ public:
     return text << (v.i_part ? "copy0" : "scale") << "/" << spr_percent(v.f_part);
   }
   virtual bool ampMixMode() { return true; }
+
+  // tracks the fundamental between blks
+  virtual bool keepsState() { return true; }
+
+  virtual bool chanSymmetric() { return true; }
 };
 
-extern HarmData sweep1_coeff;
 HarmMatchFx g_sweep1_fx("Triangles", sweep1_coeff);
 
-extern HarmData sweep2_coeff;
 HarmMatchFx g_sweep2_fx("Squares", sweep2_coeff);
 
-extern HarmData sweep3_coeff;
 HarmMatchFx g_sweep3_fx("Saws", sweep3_coeff);
 
-extern HarmData sweep4_coeff;
 HarmMatchFx g_sweep4_fx("Pointy", sweep4_coeff);
 
-extern HarmData sweep5_coeff;
 HarmMatchFx g_sweep5_fx("Sweep", sweep5_coeff);
 
 //*************************************************************************************************
@@ -1942,6 +2055,9 @@ HarmMatchFx g_sweep5_fx("Sweep", sweep5_coeff);
 //-------------------------------------------------------------------------------------------------
 template <int CHANNELS> class HarmShiftProcess : public AmpProcess {
 public:
+  // writes outside of b0..b1
+  enum { IN_PLACE = 0 };
+
   FrqShiftFft<CHANNELS> _shift;
 
   // scaling to get bin shift (frq_mult-1)
@@ -1973,11 +2089,15 @@ public:
 // check for repitch to right channel
 #ifdef STEREO
       if (fx_val >= 0.7f) {
-        // find peak in bottom 1/8th spectrum of right channel
-        PeakFindFft peak_r(_b->FFTdata(/*left*/ 1),
-                           /*b0*/ 1,
-                           /*b1*/ _b->_freq_fft_n / 8,
-                           /*estimate fundamental*/ 5.0f);
+        // track fundamental in bottom 1/8th spectrum of right channel
+        long b1 = _b->_freq_fft_n / 8;
+        PitchTrack& peak_r = _s->pitch_track[1];
+        peak_r(_b->FFTdata(/*right*/ 1),
+               /*b0*/ 1,
+               b1,
+               _b->rngPwr(/*right*/ 1, 1, b1),
+               _b->_freq_fft_n,
+               /*estimate fundamental*/ 5.0f);
 
         // repitch
         if (peak_r.max_pwr > 1e-25f && _parent->_freq > 0)
@@ -2043,12 +2163,20 @@ public:
     return GetShiftValuePreset(this, idx, curr_val);
   }
 
-  virtual void process(FxState1_0* s)
+  template <int CHANNELS> void processCh(FxState1_0* s)
   {
-    HarmShiftProcess<AUDIO_CHANNELS> shift(s, /*repitch*/ false);
+    HarmShiftProcess<CHANNELS> shift(s, /*repitch*/ false);
     AutoHarmMaskRun(s, shift);
   }
 
+  virtual void process(FxState1_0* s)
+  {
+    if (s->_b->fxChannels() == 1)
+      processCh<1>(s);
+    else
+      processCh<AUDIO_CHANNELS>(s);
+  }
+
   virtual Rng<char> /*updated*/ dispVal(FxState1_0*, Rng<char> /*out*/ text, float /*0..1*/ val)
   {
     // display octave shift as notes (semitones) shift
@@ -2057,6 +2185,14 @@ public:
   }
 
   virtual bool ampMixMode() { return true; }
+
+  // shifts in 1/4096 bins (see ShiftPhaseCorrect)
+  virtual long long phasePeriod(long fft_n) { return (long long)fft_n << 12; }
+
+  // tracks the fundamental between blks
+  virtual bool keepsState() { return true; }
+
+  virtual bool chanSymmetric() { return true; }
 } g_harm_shift;
 
 //-------------------------------------------------------------------------------------------------
@@ -2147,12 +2283,21 @@ public:
   }
 
   virtual bool ampMixMode() { return true; }
+
+  // shifts in 1/4096 bins (see ShiftPhaseCorrect)
+  virtual long long phasePeriod(long fft_n) { return (long long)fft_n << 12; }
+
+  // tracks the fundamental between blks
+  virtual bool keepsState() { return true; }
 } g_harm_repitch;
 
 //*************************************************************************************************
-class ResampleProcess : public AmpProcess {
+template <int CHANNELS> class ResampleProcess : public AmpProcess {
 public:
-  FrqShiftFft<AUDIO_CHANNELS> _shift;
+  // writes outside of b0..b1
+  enum { IN_PLACE = 0 };
+
+  FrqShiftFft<CHANNELS> _shift;
 
   FixPoint<12> _frq_mult;
 
@@ -2175,7 +2320,7 @@ public:
 
   void run(long b0, long b1)
   {
-    _shift.run</*CONJ*/ 0>(
+    _shift.template run</*CONJ*/ 0>(
         /*src first*/ b0, /*src last*/ b1, /*dst first*/ b0 * _frq_mult, /*dst scale*/ _frq_mult);
   }
 
@@ -2197,12 +2342,20 @@ public:
     return GetShiftValuePreset(this, idx, curr_val);
   }
 
-  virtual void process(FxState1_0* s)
+  template <int CHANNELS> void processCh(FxState1_0* s)
   {
-    ResampleProcess resample(s);
+    ResampleProcess<CHANNELS> resample(s);
     MaskedRun(s, resample);
   }
 
+  virtual void process(FxState1_0* s)
+  {
+    if (s->_b->fxChannels() == 1)
+      processCh<1>(s);
+    else
+      processCh<AUDIO_CHANNELS>(s);
+  }
+
   virtual Rng<char> /*updated*/ dispVal(FxState1_0*, Rng<char> /*out*/ text, float /*0..1*/ val)
   {
     // display octave shift as notes (semitones) shift
@@ -2211,6 +2364,11 @@ public:
   }
 
   virtual bool ampMixMode() { return true; }
+
+  // shifts in 1/4096 bins (see ShiftPhaseCorrect)
+  virtual long long phasePeriod(long fft_n) { return (long long)fft_n << 12; }
+
+  virtual bool chanSymmetric() { return true; }
 } g_resample_fx;
 
 //*************************************************************************************************
@@ -2276,6 +2434,11 @@ public:
     memcpy(fftTmp.data[0], b->FFTdata(0), fftSize);
     memcpy(fftTmp.data[1], b->FFTdata(1), fftSize);
 
+    // cumulative power of the unmodified input, the vocode below doesn't tell blkfx about its
+    // writes so these keep matching fftTmp (& the dst segments, which are each read before they
+    // are written) and every segment's power is a difference of 2 entries
+    const double* in_sum[2] = {b->cumPwr(0), b->cumPwr(1)};
+
     // do vocode (envelope match)
     if (voc_amp > 0.0f) {
 
@@ -2338,13 +2501,13 @@ public:
             break;
 
           // get the power from the src segment (or from src start bin if empty)
-          float src_pwr;
-          if (src.equal())
-            src_pwr = norm(*src);
-          else
-            src_pwr = GetPwr(src);
+          long s0 = src.a - fftTmp.data[srcCh];
+          long s1 = src.equal() ? s0 + 1 : src.b - fftTmp.data[srcCh];
+          float src_pwr = (float)(in_sum[srcCh][s1] - in_sum[srcCh][s0]);
 
-          float dst_in_pwr = GetPwr(dst);
+          long d0 = dst.a - b->FFTdata(dstCh);
+          long d1 = dst.b - b->FFTdata(dstCh);
+          float dst_in_pwr = (float)(in_sum[dstCh][d1] - in_sum[dstCh][d0]);
           float dst_scale = MatchPwr(voc_amp, src_pwr, dst_in_pwr) + voc_mixback;
 
           // scale the dst segment to match the src segment
@@ -2484,7 +2647,7 @@ public:
       return;
 
     // power in destination harmonic
-    float dst_in_pwr = GetPwr(_b->FFTdata(_dst_ch), b0, b1);
+    float dst_in_pwr = _b->rngPwr(_dst_ch, b0, b1);
 
     // determine src harmonic
     long s0, s1;
@@ -2498,7 +2661,7 @@ public:
     // get src harmonic pwr
     float src_pwr = dst_in_pwr;
     if (s1 >= s0)
-      src_pwr = GetPwr(_b->FFTdata(_src_ch), s0, s1);
+      src_pwr = _b->rngPwr(_src_ch, s0, s1);
 
     // attempt to match dst pwr to src pwr
     float scale = MatchPwr(_amp, src_pwr, dst_in_pwr) + _mix_back;
@@ -2506,6 +2669,7 @@ public:
     // scale the destination data
     for (CplxfPtrPair x(_b->FFTdata(_dst_ch), b0, b1 + 1); !x.equal(); x.a++)
       *x.a = (*x.a) * scale;
+    _b->binPwrWritten(_dst_ch, b0, b1);
   }
 };
 
@@ -2626,23 +2790,30 @@ struct CrossMixProcess
     cplxf* src = _b->FFTdata(_src_ch) + b0;
     CplxfPtrPair dst_(_b->FFTdata(_dst_ch), b0, b1 + 1);
     CplxfPtrPair dst;
+    const float* src_pwr_b = _b->binPwr(_src_ch, b0, b1) + b0;
+    const float* dst_pwr_b = _b->binPwr(_dst_ch, b0, b1) + b0;
 
     float src_pwr = 0.0f;
     float dst_pwr = 0.0f;
     float mix_pwr_temp = 0.0f;
     for (dst = dst_; !dst.equal(); src++, dst.a++) {
-      float norm_src = norm(*src);
-      float norm_dst = norm(*dst);
+      float norm_src = *src_pwr_b++;
+      float norm_dst = *dst_pwr_b++;
       src_pwr += norm_src;
       dst_pwr += norm_dst;
-      *dst = polar_to_cplxf(powf(norm_src, _raise_src) * powf(norm_dst, _raise_dst),
-                            angle(*src) * _mix_src + angle(*dst) * _mix_dst);
+      // powf(norm_src, _raise_src) * powf(norm_dst, _raise_dst) done as a single exp2
+      float mag = FastExp2<FAST_MATH_TIER>(_raise_src * FastLog2<FAST_MATH_TIER>(norm_src) +
+                                           _raise_dst * FastLog2<FAST_MATH_TIER>(norm_dst));
+      *dst = FastPolar<FAST_MATH_TIER>(mag,
+                                       FastAngle<FAST_MATH_TIER>(*src) * _mix_src +
+                                           FastAngle<FAST_MATH_TIER>(*dst) * _mix_dst);
       mix_pwr_temp += norm(*dst);
     }
 
     // power match output for segment
     float mix_pwr = src_pwr * _mix_src + dst_pwr * _mix_dst;
     MatchPwr(_amp, /*desired*/ mix_pwr, /*current*/ mix_pwr_temp, /*data*/ dst_);
+    _b->binPwrWritten(_dst_ch, b0, b1);
   }
 
   void done()
@@ -2691,6 +2862,9 @@ struct WeirdMixProcess
 //
 //
 {
+  // writes outside of b0..b1
+  enum { IN_PLACE = 0 };
+
   // mode 0 or mode 1 mixing
   int _mode;
 
@@ -2745,7 +2919,7 @@ struct WeirdMixProcess
       cplxf prv = *curr.a;
       float pwr = norm(prv);
       while (++curr.a < curr.b) {
-        total_len += logf(_val_pwr_scale * norm(*curr.a - prv) + 2.7183f);
+        total_len += FastLog<FAST_MATH_TIER>(_val_pwr_scale * norm(*curr.a - prv) + 2.7183f);
         prv = *curr.a;
         pwr += norm(prv);
       }
@@ -2831,7 +3005,8 @@ struct WeirdMixProcess
         val_delta[a] = cur - val[a];
 
         // "distance" between this point & previous
-        float dl = logf(_val_pwr_scale * norm(val_delta[a]) + 2.7183f) * norm_len_mul[a];
+        float dl = FastLog<FAST_MATH_TIER>(_val_pwr_scale * norm(val_delta[a]) + 2.7183f) *
+                   norm_len_mul[a];
         len[a] += dl;
 
         // update value with current value
@@ -2998,6 +3173,9 @@ public:
   // actually distortion amount
   virtual bool ampMixMode() { return true; }
 
+  // whole bin shifts (see PhaseCorrect)
+  virtual long long phasePeriod(long fft_n) { return fft_n; }
+
 } g_warpmix_fx;
 
 #endif
@@ -3047,4 +3225,5 @@ FxRun1_0* GetFxRun1_0(int idx)
   return g_fft_fx_table[idx];
 }
 
+
 //*************************************************************************************************
@@ -81,6 +81,24 @@ public:
   // default is amp is dB all the time
   virtual bool ampMixMode() { return false; }
 
+  // return true if the effect only writes bins inside its freq range (temp.bin[0]..temp.bin[1]
+  // after process() has run), DtBlkFx then keeps the power of the other bins
+  virtual bool inPlace() { return false; }
+
+  // return the period (in samples of blk position) of the phase correction that the effect
+  // applies to shifted bins for an fft of "fft_n", the output for the same input repeats when
+  // the blk position moves by a multiple of it. 0 if the output doesn't depend on the position
+  virtual long long phasePeriod(long /*fft_n*/) { return 0; }
+
+  // return true if the effect keeps state between blks (the fundamental tracking in
+  // FxState1_0::pitch_track), its blks then have to be processed one after the other
+  virtual bool keepsState() { return false; }
+
+  // return true if the effect does the same to each channel (no per channel random state, no
+  // channel used as analysis for another), when all of the effects are like this and the channels
+  // are the same DtBlkFx only runs them on channel 0 (see DtBlkFx::setDualMono)
+  virtual bool chanSymmetric() { return false; }
+
 public: // methods for the GUI
   // is this a mask effect or a normal?
   virtual bool isMask() { return false; }
@@ -116,6 +116,23 @@ void FxState1_0::prepare()
   }
 }
 
+//-------------------------------------------------------------------------------------------------
+void FxState1_0::process()
+// run the effect, the power plane is invalidated for the slot's bin range if the effect only
+// writes inside it (temp.bin[] as left by the effect), otherwise for the whole spectrum
+{
+  FxRun1_0* fx = temp.fft_fx;
+  fx->process(this);
+
+  if (fx->isMask())
+    return;
+
+  if (fx->inPlace() && temp.bin[0] <= temp.bin[1])
+    _b->binPwrWritten(temp.bin[0], temp.bin[1]);
+  else
+    _b->binPwrWritten(0, _b->_freq_fft_n / 2);
+}
+
 //-------------------------------------------------------------------------------------------------
 bool /*true=printed*/ FxState1_0::getParamDisplay(BlkFxParam::SplitParamNum& p, float v,
                                                   Rng<char> str)
@@ -37,6 +37,7 @@ General Public License for more details.
 
 #include "BlkFxParam.h"
 #include "FxRun1_0.h"
+#include "fftw_support.h"
 //#include "gui_stuff.h"
 
 class MainGuiPanel;
@@ -61,8 +62,8 @@ public:
   // called prior to process
   void prepare();
 
-  // perform the effect
-  void process() { temp.fft_fx->process(this); }
+  // perform the effect (and tell DtBlkFx which bins it may have written)
+  void process();
 
   // get previous fx state from blkfx (or NULL)
   FxState1_0* prevFxState();
@@ -102,6 +103,17 @@ public: // temporary variables used during processing
 
   } temp;
 
+  //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+public: // processing state kept between blocks (cleared by DtBlkFx::init)
+  // fundamental tracking for the auto harmonic effects (left channel) & repitch to right channel
+  Array<PitchTrack, 2> pitch_track;
+
+  void resetTracking()
+  {
+    pitch_track[0].reset();
+    pitch_track[1].reset();
+  }
+
   //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 public: // GUI state stuff
   //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
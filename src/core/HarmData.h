@@ -7,4 +7,11 @@ struct HarmData {
   int n_harms;
 };
 
+// generated tables (sweep*_coeff.cpp)
+extern HarmData sweep1_coeff;
+extern HarmData sweep2_coeff;
+extern HarmData sweep3_coeff;
+extern HarmData sweep4_coeff;
+extern HarmData sweep5_coeff;
+
 #endif
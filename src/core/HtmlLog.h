@@ -32,6 +32,7 @@ public:
   startline(const char* style // eg: "color:#ff0000;background:#000000" for red on black
   )
   {
+    RT_CHECK("file io");
     bool print_style = style && style[0];
     float clk_sec = (float)clock() / 1000.0f;
 
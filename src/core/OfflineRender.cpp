@@ -0,0 +1,299 @@
+/**************************************************************************************************
+Headless rendering through the DtBlkFx core
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+
+// DTBLKFX_GOLDEN_BASELINE builds this against the core from before the blk processing changes
+// (the golden test's reference renders), which has only the plain VST interface
+
+#include "DtBlkFx.hpp"
+#include "NoteFreq.h"
+#include "OfflineRender.h"
+#ifndef DTBLKFX_GOLDEN_BASELINE
+#include "StftCache.h"
+#endif
+
+using namespace std;
+
+// from FxRun1_0.cpp, random state used by some of the effects
+#ifndef DTBLKFX_GOLDEN_BASELINE
+extern thread_local long g_rand_i;
+#else
+extern long g_rand_i;
+#endif
+
+//-------------------------------------------------------------------------------------------------
+const char* TestSignalName(TestSignal sig)
+{
+  static const char* names[NUM_TEST_SIGNALS] = {"sine", "noise", "chirp", "impulse"};
+  return GET_ELEMENT(names, (int)sig, "?");
+}
+
+//-------------------------------------------------------------------------------------------------
+void GenTestSignal(TestSignal sig, float sample_rate, Rng<float> /*out*/ out)
+{
+  long n = out.size();
+  long i;
+  switch (sig) {
+    case TEST_SINE: {
+      // use double phase accumulation so that long signals don't drift
+      double w = 2.0 * 3.14159265358979 * 1000.0 / sample_rate;
+      for (i = 0; i < n; i++)
+        out[i] = 0.5f * (float)sin(w * (double)i);
+      break;
+    }
+
+    case TEST_NOISE: {
+      long rand_i = 1;
+      for (i = 0; i < n; i++) {
+        out[i] = 0.25f * ((float)(rand_i & 0xffffff) * (2.0f / (float)0x1000000) - 1.0f);
+        rand_i = prbs32(rand_i);
+      }
+      break;
+    }
+
+    case TEST_CHIRP: {
+      // phase of exponential sweep from f0 to f1 over the length of the signal
+      double f0 = 20.0, f1 = 0.5 * sample_rate;
+      double len = (double)n / sample_rate;
+      double k = log(f1 / f0) / len;
+      for (i = 0; i < n; i++) {
+        double t = (double)i / sample_rate;
+        out[i] = 0.5f * (float)sin(2.0 * 3.14159265358979 * f0 * (exp(k * t) - 1.0) / k);
+      }
+      break;
+    }
+
+    case TEST_IMPULSE: {
+      long period = max(1L, (long)sample_rate);
+      for (i = 0; i < n; i++)
+        out[i] = i % period == 0 ? 1.0f : 0.0f;
+      break;
+    }
+
+    default:
+      Clear(out.ptr, n);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+float /*0..1*/ BlkDelayParam(float sample_rate, long fft_n)
+{
+  // (a msec over so that rounding can't make it a sample short)
+  BlkFxParam::Delay delay = BlkFxParam::Delay::msec(1000.0f * (float)fft_n / sample_rate + 1.0f);
+  return delay;
+}
+
+//-------------------------------------------------------------------------------------------------
+static void RenderFrom(DtBlkFx* fx, float** in, float** /*out*/ out, long n, long blk_n)
+// render "n" samples from the start of the signal
+{
+  enum { AUDIO_CHANNELS = DtBlkFx::AUDIO_CHANNELS };
+
+  // fixed transport (tempo affects param interpolation and beat sync)
+  VstTimeInfo& ti = fx->timeInfo;
+  memset(&ti, 0, sizeof(ti));
+  ti.sampleRate = fx->getSampleRate();
+  ti.tempo = 120.0;
+  ti.flags = kVstTempoValid | kVstPpqPosValid | kVstTransportPlaying;
+  double samps_per_beat = 60.0 * ti.sampleRate / ti.tempo;
+
+  // clear all buffers & effect random state, size the blk buffers for the params (the plugin's
+  // timer does this, without it the blks are done at the longest length allocated so far)
+  fx->setBlockSize(blk_n);
+  fx->suspend();
+  fx->resume();
+#ifndef DTBLKFX_GOLDEN_BASELINE
+  fx->reserveBlk();
+#endif
+  g_rand_i = 1;
+
+  float* in_p[AUDIO_CHANNELS];
+  float* out_p[AUDIO_CHANNELS];
+  for (long pos = 0; pos < n; pos += blk_n) {
+    long samps = min(blk_n, n - pos);
+    ti.samplePos = (double)pos;
+    ti.ppqPos = (double)pos / samps_per_beat;
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+      in_p[ch] = in[ch] + pos;
+      out_p[ch] = out[ch] + pos;
+    }
+    fx->processReplacing(in_p, out_p, samps);
+  }
+}
+
+#ifndef DTBLKFX_GOLDEN_BASELINE
+//-------------------------------------------------------------------------------------------------
+void RenderOffline(DtBlkFx* fx, float** in, float** /*out*/ out, long n, long blk_n,
+                   const char* stft_cache_dir)
+{
+  enum { AUDIO_CHANNELS = DtBlkFx::AUDIO_CHANNELS };
+
+  StftCache cache;
+  if (stft_cache_dir) {
+    // key on the input & the params that decide the blk layout (anything else that changes the
+    // analysis of a blk is caught by the blk keys)
+    BlkHash h;
+    h.add((uint64_t)n);
+    h.add((uint64_t)blk_n);
+    h.add(fx->getSampleRate());
+    h.add(fx->getParameter(BlkFxParam::DELAY));
+    h.add(fx->getParameter(BlkFxParam::FFT_LEN));
+    h.add(fx->getParameter(BlkFxParam::OVERLAP));
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+      h.add(in[ch], n);
+
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/dtblkfx_%016llx.stft", stft_cache_dir,
+             (unsigned long long)h.h);
+    if (cache.open(path, h.h, AUDIO_CHANNELS))
+      fx->_stft_cache = &cache;
+  }
+
+  RenderFrom(fx, in, out, n, blk_n);
+
+  fx->_stft_cache = NULL;
+  cache.close();
+}
+
+//-------------------------------------------------------------------------------------------------
+void RenderOfflineParallel(DtBlkFx* fx, float** in, float** /*out*/ out, long n, long blk_n,
+                           int threads)
+{
+  bool was_nonrealtime = fx->_nonrealtime;
+  fx->setNonRealtime(true, threads);
+  RenderOffline(fx, in, out, n, blk_n);
+  fx->setNonRealtime(was_nonrealtime);
+}
+
+#else
+//-------------------------------------------------------------------------------------------------
+void RenderOffline(DtBlkFx* fx, float** in, float** /*out*/ out, long n, long blk_n,
+                   const char* /*stft_cache_dir*/)
+// the pinned baseline core has no stft cache (see DtBlkFxGoldenBase in CMakeLists.txt)
+{
+  RenderFrom(fx, in, out, n, blk_n);
+}
+#endif
+
+//-------------------------------------------------------------------------------------------------
+RenderDiff CompareRender(const float* ref, const float* x, long n)
+{
+  double ref_pwr = 0.0, err_pwr = 0.0;
+  RenderDiff r;
+  r.max_err = 0.0f;
+  for (long i = 0; i < n; i++) {
+    float err = x[i] - ref[i];
+    ref_pwr += (double)ref[i] * ref[i];
+    err_pwr += (double)err * err;
+    r.max_err = max(r.max_err, fabsf(err));
+  }
+
+  // limit so that identical renders (or silent references) give a finite number
+  if (err_pwr <= ref_pwr * 1e-100)
+    r.snr_db = 1000.0;
+  else
+    r.snr_db = limit_range(10.0 * log10(ref_pwr / err_pwr), -1000.0, 1000.0);
+  return r;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool /*true=ok*/ SaveRender(const char* path, const float* x, long n)
+{
+  FILE* f = fopen(path, "wb");
+  if (!f)
+    return false;
+  bool ok = fwrite(x, sizeof(float), n, f) == (size_t)n;
+  return fclose(f) == 0 && ok;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool /*true=ok*/ LoadRender(const char* path, float* /*out*/ x, long n)
+{
+  FILE* f = fopen(path, "rb");
+  if (!f)
+    return false;
+  bool ok = fread(x, sizeof(float), n, f) == (size_t)n;
+  fclose(f);
+  return ok;
+}
+
+//-------------------------------------------------------------------------------------------------
+DtBlkFx* NewRenderFx()
+{
+  CreateFFTWfPlans();
+  DtBlkFx* fx = new DtBlkFx(NULL);
+  fx->setSampleRate(RENDER_SAMPLE_RATE);
+  return fx;
+}
+
+//-------------------------------------------------------------------------------------------------
+RenderBuf::RenderBuf(long n_)
+    : n(n_)
+    , data(DtBlkFx::AUDIO_CHANNELS * n_)
+    , ch(DtBlkFx::AUDIO_CHANNELS)
+{
+  for (int i = 0; i < DtBlkFx::AUDIO_CHANNELS; i++)
+    ch[i] = &data[i * n];
+}
+
+//-------------------------------------------------------------------------------------------------
+void RenderBuf::gen(TestSignal left, TestSignal right)
+{
+  for (int i = 0; i < DtBlkFx::AUDIO_CHANNELS; i++)
+    GenTestSignal(i % 2 ? right : left, RENDER_SAMPLE_RATE, Rng<float>(ch[i], n));
+}
+
+//-------------------------------------------------------------------------------------------------
+void SetSoloFx(DtBlkFx* fx, int fx_type, float freq_a, float freq_b, float amp, float val)
+{
+  namespace P = BlkFxParam;
+  for (int s = 0; s < P::NUM_FX_SETS; s++) {
+    int p = P::paramOffs(s);
+    fx->setParameter(p + P::FX_TYPE, P::getEffectTypeInv(s == 0 ? fx_type : 9 /*off*/));
+    fx->setParameter(p + P::FX_FREQ_A, s == 0 ? freq_a : 0.0f);
+    fx->setParameter(p + P::FX_FREQ_B, s == 0 ? freq_b : 0.0f);
+    fx->setParameter(p + P::FX_AMP, s == 0 ? amp : 0.0f);
+    fx->setParameter(p + P::FX_VAL, s == 0 ? val : 0.0f);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+float /*0..1*/ FreqParam(float hz)
+{
+  return hz <= 0.0f ? 0.0f : limit_range(HzToNoteOffs(hz) / BlkFxParam::noteSpan(), 0.0f, 1.0f);
+}
+
+//-------------------------------------------------------------------------------------------------
+void SetSoloFilter(DtBlkFx* fx, const FilterPreset& preset)
+{
+  SetSoloFx(fx,
+            0 /*filter*/,
+            FreqParam(preset.lo_hz),
+            FreqParam(preset.hi_hz),
+            BlkFxParam::getAmpParam(preset.db),
+            0.0f);
+}
+
+//-------------------------------------------------------------------------------------------------
+long SetFFTLen(DtBlkFx* fx, long fft_len)
+{
+  int plan = 0;
+  for (int p = 0; p < NUM_FFT_SZ; p++)
+    if (labs(g_fft_sz[p] - fft_len) < labs(g_fft_sz[plan] - fft_len))
+      plan = p;
+  fx->setParameter(BlkFxParam::FFT_LEN, BlkFxParam::getFFTLenParam(plan));
+  fx->setParameter(BlkFxParam::DELAY, BlkDelayParam(fx->getSampleRate(), g_fft_sz[plan]));
+  return g_fft_sz[plan];
+}
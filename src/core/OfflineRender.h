@@ -0,0 +1,110 @@
+#ifndef _DT_OFFLINE_RENDER_H_
+#define _DT_OFFLINE_RENDER_H_
+/**************************************************************************************************
+Headless rendering through the DtBlkFx core
+
+Repeatable renders of fixed signals through the core (no host, no gui) so that output can be
+compared against stored reference renders when changing the effects or the block processing.
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <vector>
+
+#include "misc_stuff.h"
+
+class DtBlkFx;
+
+// signals that GenTestSignal can generate
+enum TestSignal {
+  TEST_SINE,    // 1kHz sine at -6dB
+  TEST_NOISE,   // white noise at -12dB from a fixed seed
+  TEST_CHIRP,   // exponential sweep 20Hz to nyquist at -6dB
+  TEST_IMPULSE, // unit impulse every second
+  NUM_TEST_SIGNALS
+};
+
+// name of a test signal (for naming reference files)
+const char* TestSignalName(TestSignal sig);
+
+// fill "out" with a test signal, always gives the same data for the same length & sample rate
+void GenTestSignal(TestSignal sig, float sample_rate, Rng<float> /*out*/ out);
+
+// DELAY param for a delay of one "fft_n" sample blk: a delay shorter than the blk doesn't leave
+// time to collect it & the blks are done shorter than the FFT_LEN param (see DtBlkFx::reducePlan)
+float /*0..1*/ BlkDelayParam(float sample_rate, long fft_n);
+
+// render "n" samples per channel of "in" to "out" by calling processReplacing with "blk_n" samples
+// at a time. The effect is reset beforehand and a fixed 120bpm transport is supplied so that the
+// same params & input always give the same output. Params should be set before calling.
+// "stft_cache_dir" keeps the forward analysis in a file (see StftCache.h) named from a hash of the
+// input & the analysis params so that rendering the same input again with different effect params
+// doesn't redo the analysis
+void RenderOffline(DtBlkFx* fx, float** in, float** /*out*/ out, long n, long blk_n = 512,
+                   const char* stft_cache_dir = NULL);
+
+// as RenderOffline but with the blks processed by "threads" workers (0=one per cpu) as the host
+// would when rendering offline (see DtBlkFx::setNonRealtime). The output is the same whatever the
+// number of threads, it differs from RenderOffline's only where the effects use random numbers
+void RenderOfflineParallel(DtBlkFx* fx, float** in, float** /*out*/ out, long n, long blk_n = 512,
+                           int threads = 0);
+
+// difference between a render & its reference
+struct RenderDiff {
+  double snr_db;  // reference power over error power (1000 if identical)
+  float max_err;  // largest absolute sample error
+};
+RenderDiff CompareRender(const float* ref, const float* x, long n);
+
+// raw 32 bit float reference files (native byte order)
+bool /*true=ok*/ SaveRender(const char* path, const float* x, long n);
+bool /*true=ok*/ LoadRender(const char* path, float* /*out*/ x, long n);
+
+// sample rate the command line tools (src/tools) render at
+const float RENDER_SAMPLE_RATE = 44100.0f;
+
+// create the fft plans & a DtBlkFx at RENDER_SAMPLE_RATE to render with (delete it when done)
+DtBlkFx* NewRenderFx();
+
+// a buffer of "n" samples per channel, converts to the float** of RenderOffline
+struct RenderBuf {
+  long n;
+  std::vector<float> data; // the channels one after the other
+  std::vector<float*> ch;  // start of each channel in data
+
+  RenderBuf(long n);
+  operator float**() { return ch.data(); }
+
+  // fill the left channel with "left" & the right with "right" (see GenTestSignal)
+  void gen(TestSignal left, TestSignal right);
+};
+
+// fx set 0 is "fx_type" with the given params, the other fx sets are off
+void SetSoloFx(DtBlkFx* fx, int fx_type, float freq_a = 0.2f, float freq_b = 0.7f,
+               float amp = 0.6f, float val = 0.5f);
+
+// FX_FREQ_A/B param for "hz" (0 for 0hz)
+float /*0..1*/ FreqParam(float hz);
+
+// a filter that changes the gain of a band
+struct FilterPreset {
+  const char* name;
+  float lo_hz, hi_hz; // band the filter changes
+  float db;           // gain in the band
+};
+
+// fx set 0 is the filter of "preset", the other fx sets are off
+void SetSoloFilter(DtBlkFx* fx, const FilterPreset& preset);
+
+// FFT_LEN param for the plan closest to "fft_len" & DELAY for one blk of it (see BlkDelayParam),
+// returns the fft length of the plan
+long SetFFTLen(DtBlkFx* fx, long fft_len);
+
+#endif
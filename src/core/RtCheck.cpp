@@ -0,0 +1,161 @@
+/**************************************************************************************************
+Debug checks for things that shouldn't happen in the audio path (see RtCheck.h)
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include "RtCheck.h"
+
+#ifdef DTBLKFX_RT_CHECK
+
+#  include <atomic>
+#  include <new>
+#  include <stdio.h>
+#  include <stdlib.h>
+
+#  ifdef _WIN32
+#    include <windows.h>
+#  else
+#    include <execinfo.h>
+#    include <unistd.h>
+#  endif
+
+thread_local int g_rt_check_depth = 0;
+thread_local const char* g_rt_check_known = NULL;
+
+void* (*g_rt_check_malloc)(size_t n) = malloc;
+void (*g_rt_check_free)(void* p) = free;
+
+static std::atomic<long> g_rt_check_n(0), g_rt_check_known_n(0);
+
+// hashes of stacks that have been reported (open addressing, 0 = empty)
+enum { SEEN_SZ = 1024 };
+static std::atomic<unsigned long> g_rt_check_seen[SEEN_SZ];
+
+//-------------------------------------------------------------------------------------------------
+static bool /*true=new*/ markSeen(unsigned long hash)
+// return true if "hash" hasn't been seen before (or the table is full)
+{
+  hash |= 1;
+  for (unsigned long i = 0; i < SEEN_SZ; i++) {
+    std::atomic<unsigned long>& e = g_rt_check_seen[(hash + i) % SEEN_SZ];
+    unsigned long prv = 0;
+    if (e.compare_exchange_strong(prv, hash))
+      return true;
+    if (prv == hash)
+      return false;
+  }
+  return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+void RtCheckViolation(const char* what, const char* known)
+{
+  if (known || g_rt_check_known) {
+    g_rt_check_known_n++;
+    return;
+  }
+  g_rt_check_n++;
+
+  // no checks while reporting (printing may allocate)
+  int depth = g_rt_check_depth;
+  g_rt_check_depth = 0;
+
+  enum { MAX_FRAMES = 32 };
+  void* frames[MAX_FRAMES];
+#  ifdef _WIN32
+  int n = CaptureStackBackTrace(/*skip*/ 1, MAX_FRAMES, frames, NULL);
+#  else
+  int n = backtrace(frames, MAX_FRAMES);
+#  endif
+
+  // FNV-1a of the return addresses
+  unsigned long hash = 2166136261UL;
+  for (int i = 0; i < n; i++) {
+    hash ^= (unsigned long)(size_t)frames[i];
+    hash *= 16777619UL;
+  }
+
+  if (markSeen(hash)) {
+    fprintf(stderr, "RT_CHECK: %s in the audio path\n", what);
+#  ifdef _WIN32
+    for (int i = 0; i < n; i++)
+      fprintf(stderr, "  %p\n", frames[i]);
+#  else
+    fflush(stderr);
+    backtrace_symbols_fd(frames, n, STDERR_FILENO);
+#  endif
+  }
+
+  g_rt_check_depth = depth;
+}
+
+//-------------------------------------------------------------------------------------------------
+long RtCheckViolations()
+{
+  return g_rt_check_n;
+}
+
+//-------------------------------------------------------------------------------------------------
+long RtCheckKnownViolations()
+{
+  return g_rt_check_known_n;
+}
+
+//-------------------------------------------------------------------------------------------------
+// replace the global allocation functions so that containers, std::function etc get checked
+void* operator new(size_t n)
+{
+  RT_CHECK("operator new");
+  void* p = g_rt_check_malloc(n ? n : 1);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t n)
+{
+  return operator new(n);
+}
+
+void* operator new(size_t n, const std::nothrow_t&) noexcept
+{
+  RT_CHECK("operator new");
+  return g_rt_check_malloc(n ? n : 1);
+}
+
+void* operator new[](size_t n, const std::nothrow_t& nt) noexcept
+{
+  return operator new(n, nt);
+}
+
+void operator delete(void* p) noexcept
+{
+  if (p)
+    RT_CHECK("operator delete");
+  g_rt_check_free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+  operator delete(p);
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef _DT_RT_CHECK_H_
+#define _DT_RT_CHECK_H_
+/**************************************************************************************************
+Debug checks for things that shouldn't happen in the audio path
+
+Built in when DTBLKFX_RT_CHECK is defined (cmake -DDTBLKFX_RT_CHECK=ON), otherwise the macros are
+empty. RT_CHECK_SCOPE marks the audio path (processReplacing, processBlock, the async worker) for
+the current thread & RT_CHECK("what") reports if it's reached from inside that scope. Allocation
+is caught by replacing the global operator new/delete, waiting for a lock held by another thread
+by the CriticalSectionWrapper & ScopeCriticalSection wrappers (taking a free lock isn't reported,
+so the params lock taken in every callback is only reported when a setter or reserveBlk has it) &
+file io by the log. On glibc RtCheckInterpose.cpp also catches
+malloc/free, pthread mutexes & condition variables (std::mutex, notify_one...) & file io from
+anywhere, it's linked into the DtBlkFxRtCheck test (see src/tools/RtCheckRender.cpp) which runs
+the offline renders under the scope & fails on any violation.
+
+Each violation is written to stderr with a stack trace, once per distinct stack so that the same
+lock in every callback doesn't flood the output. Violations that are known & accepted (waking the
+async worker, the locks of a non-realtime render...) are marked with RT_CHECK_KNOWN & only counted,
+separately (RtCheckKnownViolations).
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#ifdef DTBLKFX_RT_CHECK
+
+#  include <stddef.h>
+
+// depth of RtCheckScope on this thread
+extern thread_local int g_rt_check_depth;
+
+// why violations on this thread are known (innermost RtCheckKnown) or NULL
+extern thread_local const char* g_rt_check_known;
+
+// allocation used by the operator new/delete replacements (RtCheckInterpose.cpp points these at
+// the unchecked allocator so that an allocation is only reported once)
+extern void* (*g_rt_check_malloc)(size_t n);
+extern void (*g_rt_check_free)(void* p);
+
+// report a violation (call only inside a scope), "known" is why it's accepted (or NULL)
+void RtCheckViolation(const char* what, const char* known = NULL);
+
+// total number of violations that aren't known (including repeats of the same stack)
+long RtCheckViolations();
+
+// total number of known violations
+long RtCheckKnownViolations();
+
+//-------------------------------------------------------------------------------------------------
+struct RtCheckScope {
+  RtCheckScope() { g_rt_check_depth++; }
+  ~RtCheckScope() { g_rt_check_depth--; }
+};
+
+//-------------------------------------------------------------------------------------------------
+struct RtCheckKnown
+// violations on this thread while in scope are known
+{
+  const char* prv;
+  RtCheckKnown(const char* why)
+  {
+    prv = g_rt_check_known;
+    g_rt_check_known = why;
+  }
+  ~RtCheckKnown() { g_rt_check_known = prv; }
+};
+
+#  define RT_CHECK_SCOPE RtCheckScope _rt_check_scope_
+#  define RT_CHECK_KNOWN(why) RtCheckKnown _rt_check_known_(why)
+#  define RT_CHECK(what) RT_CHECK_AS(what, NULL)
+#  define RT_CHECK_AS(what, known)                                                                 \
+    {                                                                                              \
+      if (g_rt_check_depth > 0)                                                                    \
+        RtCheckViolation(what, known);                                                             \
+    }
+
+#else
+
+#  define RT_CHECK_SCOPE
+#  define RT_CHECK_KNOWN(why)
+#  define RT_CHECK(what)                                                                           \
+    {                                                                                              \
+    }
+#  define RT_CHECK_AS(what, known)                                                                 \
+    {                                                                                              \
+    }
+
+#endif
+
+#endif
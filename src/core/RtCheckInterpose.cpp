@@ -0,0 +1,185 @@
+/**************************************************************************************************
+Catch allocation, locks & file io in the audio path from anywhere (see RtCheck.h)
+
+Replaces malloc/free, the pthread mutex & condition variable calls (std::mutex,
+std::condition_variable::notify_one...) & the basic file io calls so that code that doesn't go
+through operator new or the lock wrappers (the c runtime, the standard library, fftw) is checked
+too. Only on glibc & only when linked into an executable (the DtBlkFxRtCheck test): in a plugin
+the host's definitions are found first. The real functions are glibc's __libc_ allocator & the
+next definitions (dlsym RTLD_NEXT) for the rest.
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include "RtCheck.h"
+
+// (defines __GLIBC__)
+#include <stdlib.h>
+
+#if defined(DTBLKFX_RT_CHECK) && defined(__GLIBC__)
+
+#  include <dlfcn.h>
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <pthread.h>
+#  include <stdarg.h>
+#  include <stdio.h>
+#  include <unistd.h>
+
+extern "C" {
+void* __libc_malloc(size_t n);
+void* __libc_calloc(size_t n, size_t sz);
+void* __libc_realloc(void* p, size_t n);
+void* __libc_memalign(size_t align, size_t n);
+void __libc_free(void* p);
+}
+
+//-------------------------------------------------------------------------------------------------
+template <class FN> static FN next(FN& fn, const char* name)
+// the definition after this one of "name" (looked up once)
+{
+  if (!fn)
+    fn = (FN)dlsym(RTLD_NEXT, name);
+  return fn;
+}
+
+//-------------------------------------------------------------------------------------------------
+// operator new/delete report themselves, don't report them again from malloc/free
+static struct InterposeInit {
+  InterposeInit()
+  {
+    g_rt_check_malloc = __libc_malloc;
+    g_rt_check_free = __libc_free;
+  }
+} g_interpose_init;
+
+//-------------------------------------------------------------------------------------------------
+extern "C" void* malloc(size_t n) noexcept
+{
+  RT_CHECK("malloc");
+  return __libc_malloc(n);
+}
+
+extern "C" void* calloc(size_t n, size_t sz) noexcept
+{
+  RT_CHECK("malloc");
+  return __libc_calloc(n, sz);
+}
+
+extern "C" void* realloc(void* p, size_t n) noexcept
+{
+  RT_CHECK("malloc");
+  return __libc_realloc(p, n);
+}
+
+extern "C" void* memalign(size_t align, size_t n) noexcept
+{
+  RT_CHECK("malloc");
+  return __libc_memalign(align, n);
+}
+
+extern "C" void* aligned_alloc(size_t align, size_t n) noexcept
+{
+  RT_CHECK("malloc");
+  return __libc_memalign(align, n);
+}
+
+extern "C" int posix_memalign(void** p, size_t align, size_t n) noexcept
+{
+  RT_CHECK("malloc");
+  if (align % sizeof(void*) != 0 || (align & (align - 1)) != 0)
+    return EINVAL;
+  *p = __libc_memalign(align, n);
+  return *p ? 0 : ENOMEM;
+}
+
+extern "C" void free(void* p) noexcept
+{
+  if (p)
+    RT_CHECK("free");
+  __libc_free(p);
+}
+
+//-------------------------------------------------------------------------------------------------
+// blocking lock (try_lock doesn't block so it isn't checked)
+extern "C" int pthread_mutex_lock(pthread_mutex_t* m) noexcept
+{
+  static int (*fn)(pthread_mutex_t*);
+  RT_CHECK("mutex lock");
+  return next(fn, "pthread_mutex_lock")(m);
+}
+
+extern "C" int pthread_cond_wait(pthread_cond_t* c, pthread_mutex_t* m)
+{
+  static int (*fn)(pthread_cond_t*, pthread_mutex_t*);
+  RT_CHECK("condition wait");
+  return next(fn, "pthread_cond_wait")(c, m);
+}
+
+extern "C" int pthread_cond_timedwait(pthread_cond_t* c, pthread_mutex_t* m,
+                                      const struct timespec* t)
+{
+  static int (*fn)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*);
+  RT_CHECK("condition wait");
+  return next(fn, "pthread_cond_timedwait")(c, m, t);
+}
+
+// notify may make a system call to wake the waiting thread
+extern "C" int pthread_cond_signal(pthread_cond_t* c) noexcept
+{
+  static int (*fn)(pthread_cond_t*);
+  RT_CHECK("condition notify");
+  return next(fn, "pthread_cond_signal")(c);
+}
+
+extern "C" int pthread_cond_broadcast(pthread_cond_t* c) noexcept
+{
+  static int (*fn)(pthread_cond_t*);
+  RT_CHECK("condition notify");
+  return next(fn, "pthread_cond_broadcast")(c);
+}
+
+//-------------------------------------------------------------------------------------------------
+extern "C" FILE* fopen(const char* path, const char* mode)
+{
+  static FILE* (*fn)(const char*, const char*);
+  RT_CHECK("file io");
+  return next(fn, "fopen")(path, mode);
+}
+
+extern "C" int open(const char* path, int flags, ...)
+{
+  static int (*fn)(const char*, int, ...);
+  RT_CHECK("file io");
+  mode_t mode = 0;
+  if (flags & (O_CREAT | O_TMPFILE)) {
+    va_list args;
+    va_start(args, flags);
+    mode = (mode_t)va_arg(args, int);
+    va_end(args);
+  }
+  return next(fn, "open")(path, flags, mode);
+}
+
+extern "C" ssize_t read(int fd, void* buf, size_t n)
+{
+  static ssize_t (*fn)(int, void*, size_t);
+  RT_CHECK("file io");
+  return next(fn, "read")(fd, buf, n);
+}
+
+extern "C" ssize_t write(int fd, const void* buf, size_t n)
+{
+  static ssize_t (*fn)(int, const void*, size_t);
+  RT_CHECK("file io");
+  return next(fn, "write")(fd, buf, n);
+}
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef _DT_SPSC_FIFO_H_
+#define _DT_SPSC_FIFO_H_
+/**************************************************************************************************
+Single producer, single consumer multi-channel sample FIFO & a multi producer, single consumer
+queue of small items
+
+Lock free: the writer only updates _in & the reader only updates _out (both are running sample
+counts) so one thread can write while another thread reads without any locking. Everything else
+(init) must be done while neither side is running.
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string.h>
+#include <valarray>
+
+//*************************************************************************************************
+template <int CHANNELS>
+class SpscFifo
+{
+public:
+  SpscFifo()
+  {
+    _mask = 0;
+    _in = _out = 0;
+  }
+
+  // size to at least "n" samples (rounded up to a pwr-of-2) & empty
+  void init(long n)
+  {
+    long sz = 1;
+    while (sz < n)
+      sz <<= 1;
+    for (int ch = 0; ch < CHANNELS; ch++)
+      _buf[ch].resize(sz, 0.0f);
+    _mask = sz - 1;
+    _in = _out = 0;
+  }
+
+  long size() const { return _mask + 1; }
+
+  // reader side: number of samples that can be read
+  long readable() const
+  {
+    return (long)(_in.load(std::memory_order_acquire) - _out.load(std::memory_order_relaxed));
+  }
+
+  // writer side: number of samples that can be written
+  long writable() const
+  {
+    return size() -
+           (long)(_in.load(std::memory_order_relaxed) - _out.load(std::memory_order_acquire));
+  }
+
+  // write up to "n" samples from each of "src" (or zeros if "src" is NULL)
+  long /*samples written*/ write(float* const* src, long n)
+  {
+    n = std::min(n, writable());
+    unsigned long i = _in.load(std::memory_order_relaxed);
+    for (int ch = 0; ch < CHANNELS; ch++)
+      copyIn(ch, i, src ? src[ch] : NULL, n);
+    _in.store(i + n, std::memory_order_release);
+    return n;
+  }
+
+  // read up to "n" samples into each of "dst" (or add to "dst")
+  long /*samples read*/ read(float* const* dst, long n, bool add = false)
+  {
+    n = std::min(n, readable());
+    unsigned long o = _out.load(std::memory_order_relaxed);
+    for (int ch = 0; ch < CHANNELS; ch++)
+      copyOut(ch, o, dst[ch], n, add);
+    _out.store(o + n, std::memory_order_release);
+    return n;
+  }
+
+  // throw away up to "n" samples
+  long /*samples skipped*/ skip(long n)
+  {
+    n = std::min(n, readable());
+    _out.store(_out.load(std::memory_order_relaxed) + n, std::memory_order_release);
+    return n;
+  }
+
+protected:
+  void copyIn(int ch, unsigned long pos, const float* src, long n)
+  {
+    float* buf = &_buf[ch][0];
+    long i = (long)(pos & _mask);
+    long n0 = std::min(n, size() - i);
+    if (src) {
+      memcpy(buf + i, src, n0 * sizeof(float));
+      memcpy(buf, src + n0, (n - n0) * sizeof(float));
+    }
+    else {
+      memset(buf + i, 0, n0 * sizeof(float));
+      memset(buf, 0, (n - n0) * sizeof(float));
+    }
+  }
+
+  void copyOut(int ch, unsigned long pos, float* dst, long n, bool add)
+  {
+    const float* buf = &_buf[ch][0];
+    long i = (long)(pos & _mask);
+    long n0 = std::min(n, size() - i);
+    if (add) {
+      for (long j = 0; j < n0; j++)
+        dst[j] += buf[i + j];
+      for (long j = n0; j < n; j++)
+        dst[j] += buf[j - n0];
+    }
+    else {
+      memcpy(dst, buf + i, n0 * sizeof(float));
+      memcpy(dst + n0, buf, (n - n0) * sizeof(float));
+    }
+  }
+
+  std::valarray<float> _buf[CHANNELS];
+  long _mask;
+
+  // running counts of samples written & read
+  std::atomic<unsigned long> _in, _out;
+};
+
+//*************************************************************************************************
+template <class T>
+class MpscQueue
+//
+// bounded queue that any number of threads can push to & one thread pops from, lock free: each
+// slot has a sequence count saying whether it is free for the writer at running count "seq" or
+// holds the item written at "seq-1", writers claim a running count with a CAS on _in
+//
+{
+public:
+  MpscQueue()
+  {
+    _mask = 0;
+    _in = 0;
+    _out = 0;
+  }
+
+  // size to at least "n" items (rounded up to a pwr-of-2) & empty, not while in use
+  void init(long n)
+  {
+    long sz = 1;
+    while (sz < n)
+      sz <<= 1;
+    _slot.reset(new Slot[sz]);
+    for (long i = 0; i < sz; i++)
+      _slot[i].seq.store((unsigned long)i, std::memory_order_relaxed);
+    _mask = sz - 1;
+    _in = 0;
+    _out = 0;
+  }
+
+  // any thread: add "v", false if the queue is full
+  bool push(const T& v)
+  {
+    unsigned long pos = _in.load(std::memory_order_relaxed);
+    while (1) {
+      Slot& s = _slot[pos & _mask];
+      long d = (long)(s.seq.load(std::memory_order_acquire) - pos);
+      if (d < 0)
+        return false;
+      if (d > 0)
+        pos = _in.load(std::memory_order_relaxed);
+      else if (_in.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        s.val = v;
+        s.seq.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    }
+  }
+
+  // reader: oldest item (NULL if empty), stays in the queue until pop()
+  const T* front() const
+  {
+    if (!_slot)
+      return NULL;
+    const Slot& s = _slot[_out & _mask];
+    return s.seq.load(std::memory_order_acquire) == _out + 1 ? &s.val : NULL;
+  }
+
+  // reader: remove the item returned by front()
+  void pop()
+  {
+    _slot[_out & _mask].seq.store(_out + _mask + 1, std::memory_order_release);
+    _out++;
+  }
+
+protected:
+  struct Slot {
+    std::atomic<unsigned long> seq;
+    T val;
+  };
+  std::unique_ptr<Slot[]> _slot;
+  long _mask;
+
+  // running counts of items claimed by writers & read
+  std::atomic<unsigned long> _in;
+  unsigned long _out;
+};
+
+#endif
@@ -0,0 +1,199 @@
+/**************************************************************************************************
+File cache of the forward analysis for repeated offline renders (see StftCache.h)
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include "StftCache.h"
+#include <string.h>
+
+#ifdef _WIN32
+#  include <process.h>
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+static const char g_stft_cache_magic[8] = {'D', 'T', 'S', 'T', 'F', 'T', 'C', '1'};
+
+//-------------------------------------------------------------------------------------------------
+StftCache::StftCache()
+{
+  _chans = 0;
+  _read_n = _write_n = 0;
+  _wr = NULL;
+  _wr_path[0] = _wr_tmp_path[0] = 0;
+  _map = NULL;
+  _map_sz = _map_pos = 0;
+#ifdef _WIN32
+  _file_h = _map_h = NULL;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+bool /*true=ok*/ StftCache::open(const char* path, uint64_t key, int chans)
+{
+  close();
+  _chans = chans;
+  _read_n = _write_n = 0;
+
+  // map an existing file
+#ifdef _WIN32
+  HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL, NULL);
+  if (f != INVALID_HANDLE_VALUE) {
+    LARGE_INTEGER sz;
+    HANDLE m = NULL;
+    if (GetFileSizeEx(f, &sz) && sz.QuadPart >= (LONGLONG)sizeof(Hdr))
+      m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m)
+      _map = (const char*)MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (_map) {
+      _map_sz = (size_t)sz.QuadPart;
+      _file_h = f;
+      _map_h = m;
+    }
+    else {
+      if (m)
+        CloseHandle(m);
+      CloseHandle(f);
+    }
+  }
+#else
+  int fd = ::open(path, O_RDONLY);
+  if (fd >= 0) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(Hdr)) {
+      void* p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        _map = (const char*)p;
+        _map_sz = (size_t)st.st_size;
+      }
+    }
+    // the mapping stays valid after the file is closed
+    ::close(fd);
+  }
+#endif
+
+  if (_map) {
+    const Hdr* h = (const Hdr*)_map;
+    if (!memcmp(h->magic, g_stft_cache_magic, sizeof(h->magic)) && h->key == key &&
+        h->chans == (uint64_t)chans && h->complete) {
+      _map_pos = sizeof(Hdr);
+      return true;
+    }
+    close();
+    _chans = chans;
+  }
+
+  // (re)create for writing, in a file of our own until close()
+  if (strlen(path) >= sizeof(_wr_path))
+    return false;
+  strcpy(_wr_path, path);
+#ifdef _WIN32
+  int pid = _getpid();
+#else
+  int pid = (int)getpid();
+#endif
+  snprintf(_wr_tmp_path, sizeof(_wr_tmp_path), "%s.%d.%p.tmp", path, pid, (void*)this);
+  _wr = fopen(_wr_tmp_path, "wb");
+  if (!_wr)
+    return false;
+  memcpy(_wr_hdr.magic, g_stft_cache_magic, sizeof(_wr_hdr.magic));
+  _wr_hdr.key = key;
+  _wr_hdr.chans = chans;
+  _wr_hdr.complete = 0;
+  if (fwrite(&_wr_hdr, sizeof(_wr_hdr), 1, _wr) != 1) {
+    close(/*complete*/ false);
+    return false;
+  }
+  return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+void StftCache::close(bool complete)
+{
+  if (_wr) {
+    // mark complete only if everything was written
+    _wr_hdr.complete = 1;
+    bool ok = complete && !ferror(_wr) && fseek(_wr, 0, SEEK_SET) == 0 &&
+              fwrite(&_wr_hdr, sizeof(_wr_hdr), 1, _wr) == 1;
+    ok &= fclose(_wr) == 0;
+    _wr = NULL;
+
+    // replace the file (renders that have the old one mapped keep it), otherwise throw it away
+#ifdef _WIN32
+    ok = ok && MoveFileExA(_wr_tmp_path, _wr_path, MOVEFILE_REPLACE_EXISTING);
+#else
+    ok = ok && rename(_wr_tmp_path, _wr_path) == 0;
+#endif
+    if (!ok)
+      remove(_wr_tmp_path);
+    _wr_path[0] = _wr_tmp_path[0] = 0;
+  }
+  if (_map) {
+#ifdef _WIN32
+    UnmapViewOfFile(_map);
+    CloseHandle((HANDLE)_map_h);
+    CloseHandle((HANDLE)_file_h);
+    _map_h = _file_h = NULL;
+#else
+    munmap((void*)_map, _map_sz);
+#endif
+    _map = NULL;
+    _map_sz = _map_pos = 0;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+bool /*true=found*/ StftCache::next(uint64_t blk_key, long n_bins, const float*& /*out*/ total_pwr,
+                                    const cplxf*& /*out*/ spectra)
+{
+  size_t rec_sz = sizeof(RecHdr) + pwrBytes() + _chans * n_bins * sizeof(cplxf);
+  if (!_map || _map_pos + rec_sz > _map_sz)
+    return false;
+
+  const char* p = _map + _map_pos;
+  const RecHdr* r = (const RecHdr*)p;
+  if (r->blk_key != blk_key || r->n_bins != (uint64_t)n_bins) {
+    // analysed differently, stop reading
+    _map_pos = _map_sz;
+    return false;
+  }
+  total_pwr = (const float*)(p + sizeof(RecHdr));
+  spectra = (const cplxf*)(p + sizeof(RecHdr) + pwrBytes());
+  _map_pos += rec_sz;
+  _read_n++;
+  return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+void StftCache::write(uint64_t blk_key, long n_bins, const float* total_pwr,
+                      const cplxf* const* spectra)
+{
+  if (!_wr)
+    return;
+
+  RecHdr r;
+  r.blk_key = blk_key;
+  r.n_bins = n_bins;
+  char pwr[64];
+  memset(pwr, 0, sizeof(pwr));
+  memcpy(pwr, total_pwr, _chans * sizeof(float));
+
+  fwrite(&r, sizeof(r), 1, _wr);
+  fwrite(pwr, pwrBytes(), 1, _wr);
+  for (int ch = 0; ch < _chans; ch++)
+    fwrite(spectra[ch], sizeof(cplxf), n_bins, _wr);
+  _write_n++;
+}
@@ -0,0 +1,92 @@
+#ifndef _DT_STFT_CACHE_H_
+#define _DT_STFT_CACHE_H_
+/**************************************************************************************************
+File cache of the forward analysis (scaled input spectra & total input power of each blk) for
+repeated offline renders of the same input
+
+The first render writes a record per blk in the order they're analysed, later renders with the same
+key map the file & take each blk's spectra straight from the mapping instead of windowing &
+transforming. Each record also has a key for the blk layout (fft length, position, shoulder window)
+so that a render that analyses differently stops using the file rather than using the wrong data.
+
+Writing is appended through stdio since the number & size of the blks isn't known until the render
+has finished. It goes to a temporary file next to "path" that close() renames over it once it's
+complete, so a render that didn't finish is never read & a file that another render has mapped is
+replaced rather than truncated under it.
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include "cplxf.h"
+#include <stdint.h>
+#include <stdio.h>
+
+//*************************************************************************************************
+class StftCache {
+public:
+  StftCache();
+  ~StftCache() { close(/*complete*/ false); }
+
+  // open "path" for reading if it's a complete cache for "key" with "chans" channels, otherwise
+  // (re)create it for writing
+  bool /*true=ok*/ open(const char* path, uint64_t key, int chans);
+
+  // finish writing (marking the file complete unless "complete" is false) or unmap
+  void close(bool complete = true);
+
+  bool reading() const { return _map != NULL; }
+  bool writing() const { return _wr != NULL; }
+
+  // reading: get the next blk if it was analysed with "blk_key" & "n_bins", "total_pwr" is one
+  // value per channel & "spectra" has "n_bins" bins for each channel one after the other. Both point
+  // into the mapping (valid until close). If the blk doesn't match, reading stops
+  bool /*true=found*/ next(uint64_t blk_key, long n_bins, const float*& /*out*/ total_pwr,
+                           const cplxf*& /*out*/ spectra);
+
+  // writing: append a blk
+  void write(uint64_t blk_key, long n_bins, const float* total_pwr, const cplxf* const* spectra);
+
+  // blks read & written since open
+  long _read_n, _write_n;
+
+protected:
+  struct Hdr {
+    char magic[8];
+    uint64_t key;
+    uint64_t chans;
+    uint64_t complete; // nonzero once all blks are written
+  };
+  struct RecHdr {
+    uint64_t blk_key;
+    uint64_t n_bins;
+    // followed by the total power of each channel (padded to 8 bytes) then the spectra
+  };
+
+  // bytes of total power after RecHdr
+  size_t pwrBytes() const { return (_chans * sizeof(float) + 7) & ~(size_t)7; }
+
+  int _chans;
+
+  // writing (to _wr_tmp_path, renamed to _wr_path by close)
+  FILE* _wr;
+  Hdr _wr_hdr;
+  char _wr_path[1024];
+  char _wr_tmp_path[1024 + 64];
+
+  // reading
+  const char* _map;
+  size_t _map_sz, _map_pos;
+#ifdef _WIN32
+  void* _file_h;
+  void* _map_h;
+#endif
+};
+
+#endif
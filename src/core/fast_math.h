@@ -0,0 +1,218 @@
+#ifndef _DT_FAST_MATH_H_
+#define _DT_FAST_MATH_H_
+/**************************************************************************************************
+Polynomial approximations of log2, exp2, pow, atan2 & sincos for the per-bin effects
+
+All functions are templated on an accuracy tier (FAST_MATH_LO/MID/HI). They're branch free (only
+selects) & don't touch memory so that loops calling them can be auto-vectorized on both x86 &
+arm (gcc only turns the selects into vector ones with -fno-trapping-math, clang's default). Inputs
+are expected to be finite, see each function for its range.
+
+Worst case errors against libm (float evaluation), checked by src/tools/FastMathTest.cpp:
+
+              LO        MID       HI
+  log2 abs    8.6e-4    1.9e-5    4.2e-6 (x 1e-30..1e30, rounding of the sum once the exponent
+                                          is large)
+  exp2 rel    1.5e-4    3.9e-6    1.2e-7 (x -126..126)
+  pow rel     2.5e-3    4.8e-5    6.8e-6 (x 1e-6..1e6 & |y| up to 4, it grows with |y|)
+  atan2 abs   6.1e-4    1.2e-5    5.1e-7 (radians)
+  sin/cos abs 1.6e-4    6.6e-7    9.2e-8 (|a| up to 1000)
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include "cplxf.h"
+#include <string.h>
+
+enum FastMathTier { FAST_MATH_LO, FAST_MATH_MID, FAST_MATH_HI };
+
+// tier used by the effects
+#ifndef FAST_MATH_TIER
+#  define FAST_MATH_TIER FAST_MATH_MID
+#endif
+
+namespace FastMath {
+
+//-------------------------------------------------------------------------------------------------
+inline int FloatBits(float x)
+{
+  int i;
+  memcpy(&i, &x, sizeof(i));
+  return i;
+}
+inline float BitsFloat(int i)
+{
+  float x;
+  memcpy(&x, &i, sizeof(x));
+  return x;
+}
+
+// round to nearest (|x| < 2^22), without a float->int->float conversion
+inline float RoundNearest(float x)
+{
+  const float magic = 12582912.0f; // 1.5 * 2^23
+  return (x + magic) - magic;
+}
+
+}; // namespace FastMath
+
+//-------------------------------------------------------------------------------------------------
+template <int TIER> inline float FastLog2(float x)
+// log2(x) for x > 0, returns -1e30 for x <= 0 (so that multiplying by 0 still gives 0)
+{
+  using namespace FastMath;
+
+  // split into exponent & mantissa with the mantissa in [sqrt(.5), sqrt(2)) so that the
+  // polynomial is centred on log2(1) = 0
+  int bits = FloatBits(x);
+  int e = (bits - 0x3f3504f3) >> 23;
+  float t = BitsFloat(bits - (int)((unsigned)e << 23)) - 1.0f;
+
+  // log2(1+t) = t*p(t)
+  float p;
+  if (TIER == FAST_MATH_LO)
+    p = 1.44515231f + t * (-0.7540812f + t * 0.445067292f);
+  else if (TIER == FAST_MATH_MID)
+    p = 1.442578f +
+        t * (-0.720241816f + t * (0.486686462f + t * (-0.394575075f + t * 0.252658062f)));
+  else
+    p = 1.44269973f +
+        t * (-0.721375871f +
+             t * (0.480465014f +
+                  t * (-0.358961895f +
+                       t * (0.297262908f + t * (-0.272697535f + t * 0.170632826f)))));
+
+  return x > 0.0f ? (float)e + t * p : -1e30f;
+}
+
+// natural log
+template <int TIER> inline float FastLog(float x)
+{
+  return 0.693147181f * FastLog2<TIER>(x);
+}
+
+//-------------------------------------------------------------------------------------------------
+template <int TIER> inline float FastExp2(float x)
+// 2^x, returns 0 below -126 & saturates at 2^126
+{
+  using namespace FastMath;
+
+  float xc = x > 126.0f ? 126.0f : x;
+  xc = xc < -126.0f ? -126.0f : xc;
+
+  // 2^x = 2^r * 2^f with r integer & f in [-.5, .5]
+  float r = RoundNearest(xc);
+  float f = xc - r;
+
+  // 2^f - 1 = f*p(f)
+  float p;
+  if (TIER == FAST_MATH_LO)
+    p = 0.693112498f + f * (0.242225511f + f * 0.0559771195f);
+  else if (TIER == FAST_MATH_MID)
+    p = 0.693121516f + f * (0.240220243f + f * (0.0559197502f + f * 0.00968175635f));
+  else
+    p = 0.693147206f +
+        f * (0.240226513f +
+             f * (0.0555032774f + f * (0.00961800537f + f * (0.00134002829f +
+                                                              f * 0.000154759079f))));
+
+  float y = BitsFloat(FloatBits(1.0f + f * p) + (int)((unsigned)(int)r << 23));
+  return x < -126.0f ? 0.0f : y;
+}
+
+//-------------------------------------------------------------------------------------------------
+template <int TIER> inline float FastPow(float x, float y)
+// x^y for x >= 0, (0^0 = 1, 0^y = 0 for y > 0)
+{
+  return FastExp2<TIER>(y * FastLog2<TIER>(x));
+}
+
+//-------------------------------------------------------------------------------------------------
+template <int TIER> inline float FastAtan2(float y, float x)
+// atan2(y, x) in -pi..pi (0 for 0,0)
+{
+  float ax = fabsf(x), ay = fabsf(y);
+  float mx = ax > ay ? ax : ay;
+  float mn = ax > ay ? ay : ax;
+
+  // atan(z) for z = 0..1 as z*p(z^2)
+  float z = mn / (mx > 0.0f ? mx : 1.0f);
+  float z2 = z * z;
+  float p;
+  if (TIER == FAST_MATH_LO)
+    p = 0.995357961f + z2 * (-0.288690157f + z2 * 0.0793389391f);
+  else if (TIER == FAST_MATH_MID)
+    p = 0.999866332f +
+        z2 * (-0.330304798f + z2 * (0.180159302f + z2 * (-0.0851563308f + z2 * 0.0208450962f)));
+  else
+    p = 0.999996112f +
+        z2 * (-0.333173693f +
+              z2 * (0.198078245f +
+                    z2 * (-0.132333715f +
+                          z2 * (0.0796241476f + z2 * (-0.0336045927f + z2 * 0.00681190592f)))));
+  float a = z * p;
+
+  // undo the octant reduction
+  a = ay > ax ? 1.57079633f - a : a;
+  a = x < 0.0f ? 3.14159265f - a : a;
+  return y < 0.0f ? -a : a;
+}
+
+//-------------------------------------------------------------------------------------------------
+template <int TIER> inline void FastSinCos(float a, float& /*out*/ s, float& /*out*/ c)
+// sin & cos of "a" (|a| < about 2^20)
+{
+  using namespace FastMath;
+
+  // reduce to r = -pi/4..pi/4 & quadrant q (pi/2 split in 2 for accuracy)
+  float q = RoundNearest(a * 0.636619772f);
+  float r = (a - q * 1.5703125f) - q * 4.83826794896619e-4f;
+  float r2 = r * r;
+
+  // sin(r) = r*ps(r^2), cos(r) = 1 + r^2*pc(r^2)
+  float ps, pc;
+  if (TIER == FAST_MATH_LO) {
+    ps = 0.999031448f + r2 * -0.160344067f;
+    pc = -0.499776308f + r2 * 0.0404889368f;
+  }
+  else if (TIER == FAST_MATH_MID) {
+    ps = 0.999994998f + r2 * (-0.166601621f + r2 * 0.00812155944f);
+    pc = -0.499998948f + r2 * (0.0416562946f + r2 * -0.00135978237f);
+  }
+  else {
+    ps = 0.999999986f + r2 * (-0.166666368f + r2 * (0.00833158453f + r2 * -0.000194621097f));
+    pc = -0.499999997f + r2 * (0.0416666233f + r2 * (-0.00138867633f + r2 * 2.43904062e-05f));
+  }
+  float sr = r * ps;
+  float cr = 1.0f + r2 * pc;
+
+  // rotate by the quadrant
+  int qi = (int)q;
+  float s1 = qi & 1 ? cr : sr;
+  float c1 = qi & 1 ? sr : cr;
+  s = qi & 2 ? -s1 : s1;
+  c = (qi + 1) & 2 ? -c1 : c1;
+}
+
+//-------------------------------------------------------------------------------------------------
+// cplxf versions of angle() & polar_to_cplxf()
+template <int TIER> inline float FastAngle(const cplxf& a)
+{
+  return FastAtan2<TIER>(a.imag(), a.real());
+}
+
+template <int TIER> inline cplxf FastPolar(float mag, float ang)
+{
+  float s, c;
+  FastSinCos<TIER>(ang, s, c);
+  return cplxf(mag * c, mag * s);
+}
+
+#endif
@@ -12,10 +12,13 @@ SinCosTable</*bits*/ 12> g_sincos_table;
 
 namespace FFTWf {
 void(__cdecl* destroy_plan)(fftwf_plan p);
+void(__cdecl* execute_dft)(const fftwf_plan p, fftwf_complex* in, fftwf_complex* out);
 void(__cdecl* execute_dft_c2r)(const fftwf_plan p, fftwf_complex* in, float* out);
 void(__cdecl* execute_dft_r2c)(const fftwf_plan p, float* in, fftwf_complex* out);
 void(__cdecl* free)(void* p);
 void*(__cdecl* malloc)(size_t n);
+fftwf_plan(__cdecl* plan_dft_1d)(int n, fftwf_complex* in, fftwf_complex* out, int sign,
+                                 unsigned flags);
 fftwf_plan(__cdecl* plan_dft_c2r_1d)(int n, fftwf_complex* in, float* out, unsigned flags);
 fftwf_plan(__cdecl* plan_dft_r2c_1d)(int n, float* in, fftwf_complex* out, unsigned flags);
 }; // namespace FFTWf
@@ -69,10 +72,12 @@ bool /*true=success*/ LoadFFTWfDll(std::vector<std::string> paths, std::ostream*
 
   // now grab some functions from the DLL
   LOAD_FN(destroy_plan);
+  LOAD_FN(execute_dft);
   LOAD_FN(execute_dft_c2r);
   LOAD_FN(execute_dft_r2c);
   LOAD_FN(free);
   LOAD_FN(malloc);
+  LOAD_FN(plan_dft_1d);
   LOAD_FN(plan_dft_c2r_1d);
   LOAD_FN(plan_dft_r2c_1d);
 
@@ -228,3 +233,59 @@ void PeakFindFft::operator()(cplxf* fft, int b0,
   // adjust max bin to correspond to estimated fundamental (if we decided that)
   max_bin /= harmonic;
 }
+
+//-------------------------------------------------------------------------------------------------
+void PitchTrack::operator()(cplxf* fft, int b0,
+                            int b1, // b1 >= b0
+                            float band_pwr,
+                            long len,
+                            float estimate_fundamental)
+// see header for information
+{
+  // keep the same frequency if the fft length changed
+  if (len != fft_len) {
+    if (fft_len > 0)
+      max_bin *= (float)len / (float)fft_len;
+    fft_len = len;
+  }
+
+  if (locked && max_bin >= (float)b0 && max_bin <= (float)b1) {
+    // search about a semitone either side of the previous fundamental
+    int centre = (int)(max_bin + 0.5f);
+    int w = max(2, (int)(max_bin * 0.06f));
+    int w0 = max(b0, centre - w);
+    int w1 = min(b1, centre + w);
+    PeakFindFft peak(fft, w0, w1);
+
+    // a peak on the edge of the window (that isn't the edge of the band) has probably moved out
+    int p = (int)(peak.max_bin + 0.5f);
+    bool at_edge = (p <= w0 && w0 > b0) || (p >= w1 && w1 < b1);
+
+    if (peak.max_pwr > 0.0f && !at_edge) {
+      max_bin = peak.max_bin;
+      max_pwr = peak.max_pwr;
+      updateConfidence(fft, b0, b1, band_pwr);
+      if (confidence >= 0.5f * lock_confidence)
+        return;
+    }
+  }
+
+  // lost lock (or never had it), do the full search
+  PeakFindFft peak(fft, b0, b1, estimate_fundamental);
+  max_bin = peak.max_bin;
+  max_pwr = peak.max_pwr;
+  updateConfidence(fft, b0, b1, band_pwr);
+
+  // don't bother tracking noise
+  locked = max_pwr > 0.0f && confidence >= /*arbitrary*/ 0.1f;
+  lock_confidence = confidence;
+}
+
+//-------------------------------------------------------------------------------------------------
+void PitchTrack::updateConfidence(cplxf* fft, int b0, int b1, float band_pwr)
+{
+  // power in the bins either side of the fundamental (may overrun b1 by 1 like PeakFindFft)
+  int b = limit_range((int)max_bin, b0, b1);
+  float pwr = norm(fft[b]) + norm(fft[b + 1]);
+  confidence = band_pwr > 0.0f ? min(1.0f, pwr * (float)CONF_SCALE / band_pwr) : 0.0f;
+}
@@ -27,10 +27,13 @@ inline fftwf_complex* to_fftwf_complex(cplxf* t)
 // I load the dll manually so as I can check other directories that aren't in the path
 namespace FFTWf {
 extern void(__cdecl* destroy_plan)(fftwf_plan p);
+extern void(__cdecl* execute_dft)(const fftwf_plan p, fftwf_complex* in, fftwf_complex* out);
 extern void(__cdecl* execute_dft_c2r)(const fftwf_plan p, fftwf_complex* in, float* out);
 extern void(__cdecl* execute_dft_r2c)(const fftwf_plan p, float* in, fftwf_complex* out);
 extern void(__cdecl* free)(void* p);
 extern void*(__cdecl* malloc)(size_t n);
+extern fftwf_plan(__cdecl* plan_dft_1d)(int n, fftwf_complex* in, fftwf_complex* out, int sign,
+                                        unsigned flags);
 extern fftwf_plan(__cdecl* plan_dft_c2r_1d)(int n, fftwf_complex* in, float* out, unsigned flags);
 extern fftwf_plan(__cdecl* plan_dft_r2c_1d)(int n, float* in, fftwf_complex* out, unsigned flags);
 }; // namespace FFTWf
@@ -46,6 +49,10 @@ inline void destroy_plan(fftwf_plan p)
 {
   fftwf_destroy_plan(p);
 }
+inline void execute_dft(const fftwf_plan p, fftwf_complex* i, fftwf_complex* o)
+{
+  fftwf_execute_dft(p, i, o);
+}
 inline void execute_dft_c2r(const fftwf_plan p, fftwf_complex* i, float* o)
 {
   fftwf_execute_dft_c2r(p, i, o);
@@ -62,6 +69,10 @@ inline void* malloc(size_t n)
 {
   return fftwf_malloc(n);
 }
+inline fftwf_plan plan_dft_1d(int n, fftwf_complex* i, fftwf_complex* o, int sign, unsigned flags)
+{
+  return fftwf_plan_dft_1d(n, i, o, sign, flags);
+}
 inline fftwf_plan plan_dft_c2r_1d(int n, fftwf_complex* i, float* o, unsigned flags)
 {
   return fftwf_plan_dft_c2r_1d(n, i, o, flags);
@@ -158,6 +169,14 @@ public:
     return g_sincos_table[(_mult * bin_shift.val) / _fft_len];
   }
 
+  // as above without the table quantization (for the start of a run of bins, see FrqShiftFft)
+  cplxf exact(FixPoint<12> bin_shift) const
+  {
+    long long len = (long long)_fft_len << 12;
+    return std::polar(1.0f, (float)(6.283185307179586 * (double)((_mult * bin_shift.val) % len) /
+                                    (double)len));
+  }
+
   int maxBin() { return _fft_len / 2; }
 
   // MUST call init before use
@@ -539,48 +558,10 @@ public:
     //
     // do the actual processing
     //
-    FixPoint<12> dst_bin = _buf.getReverseDir() ? dst_last_bin : dst_first_bin;
-    if (shift_stp == 1) {
-      // constant shift
-      Slice<cplxf, CHANNELS> mult = _phase_corr(dst_first_bin - src_first_bin) * _dst_amp;
-
-      if (_buf.getReverseDir()) {
-        for (int src_bin = src_last_bin; src_bin >= src_first_bin; src_bin--) {
-          Slice<cplxf, CHANNELS> m = getSrc<CONJ>(src_bin) * mult;
-          _buf.data(src_bin) *= _src_amp;
-          FFTFracShift::add(_buf.dst(), dst_bin, m);
-          dst_bin -= 1;
-        }
-      }
-      else {
-        for (int src_bin = src_first_bin; src_bin <= src_last_bin; src_bin++) {
-          Slice<cplxf, CHANNELS> m = getSrc<CONJ>(src_bin) * mult;
-          _buf.data(src_bin) *= _src_amp;
-          FFTFracShift::add(_buf.dst(), dst_bin, m);
-          dst_bin += 1;
-        }
-      }
-    }
-    else if (_buf.getReverseDir()) {
-      // scaling shift
-      for (int src_bin = src_last_bin; src_bin >= src_first_bin; src_bin--) {
-        Slice<cplxf, CHANNELS> m =
-            getSrc<CONJ>(src_bin) * _dst_amp * _phase_corr(dst_bin - src_bin);
-        _buf.data(src_bin) *= _src_amp;
-        FFTFracShift::add(_buf.dst(), dst_bin, m);
-        dst_bin -= shift_stp;
-      }
-    }
-    else {
-      // scaling shift
-      for (int src_bin = src_first_bin; src_bin <= src_last_bin; src_bin++) {
-        Slice<cplxf, CHANNELS> m =
-            getSrc<CONJ>(src_bin) * _dst_amp * _phase_corr(dst_bin - src_bin);
-        _buf.data(src_bin) *= _src_amp;
-        FFTFracShift::add(_buf.dst(), dst_bin, m);
-        dst_bin += shift_stp;
-      }
-    }
+    if (_buf.getReverseDir())
+      runBins<CONJ>(src_last_bin, -1, src_last_bin - src_first_bin + 1, dst_last_bin, -shift_stp);
+    else
+      runBins<CONJ>(src_first_bin, 1, src_last_bin - src_first_bin + 1, dst_first_bin, shift_stp);
   }
 
   void flush(bool fold = true)
@@ -611,6 +592,83 @@ public: // internals
     for (int i = first_bin; i <= last_bin; i++)
       _buf.data(i) *= _src_amp;
   }
+
+  enum {
+    RUN_N = 64 // bins per run, the phase correction is recalculated at the start of each run
+  };
+
+  template <int CONJ>
+  void runBins(int src_bin,          // first src bin to process
+               int dir,              // src bin step (1 or -1)
+               int n,                // number of src bins
+               FixPoint<12> dst_bin, // destination of the first src bin
+               FixPoint<12> dst_stp  // destination step per src bin
+  )
+  // process runs of bins: load, phase correct & scale the src bins of a run into "m" then add
+  // them into the destination. The phase correction advances by a constant rotation each bin so
+  // it's calculated exactly at the start of the run & then rotated rather than looked up per bin.
+  //
+  // Reading the whole run before writing is safe: the destination bins are either in the tmp
+  // buffer or (see "run()") only ever land on src bins that were already processed
+  {
+    cplxf rot = _phase_corr.exact(dst_stp - dir);
+
+    // destination fraction doesn't change when the step is a whole number of bins (constant
+    // shift or whole number scaling) so the same shift coefficients apply to the whole run
+    bool const_frac = dst_stp.getFracRaw() == 0;
+    int dst_stp_i = dst_stp.getRound();
+
+    cplxf ph[RUN_N];
+    cplxf m[CHANNELS][RUN_N];
+
+    while (n > 0) {
+      int run_n = std::min(n, (int)RUN_N);
+
+      ph[0] = _phase_corr.exact(dst_bin - src_bin);
+      for (int k = 1; k < run_n; k++)
+        ph[k] = ph[k - 1] * rot;
+
+      for (int ch = 0; ch < CHANNELS; ch++) {
+        cplxf* src = _buf.data().data[ch] + src_bin;
+        float dst_amp = _dst_amp[ch];
+        float src_amp = _src_amp[ch];
+        for (int k = 0; k < run_n; k++) {
+          cplxf x = src[k * dir];
+          m[ch][k] = (CONJ ? conj(x) : x) * ph[k] * dst_amp;
+          src[k * dir] = x * src_amp;
+        }
+      }
+
+      if (const_frac) {
+        FixPoint<FFTFracShift::BITS> fix_dst_bin;
+        fix_dst_bin.setClosest(dst_bin);
+        const cplxf* c = FFTFracShift::coeff[fix_dst_bin.getFracRaw()];
+        int dst_bin_r = fix_dst_bin.getRound() - FFTFracShift::W_OFFS;
+        for (int ch = 0; ch < CHANNELS; ch++) {
+          cplxf* dst = _buf.dst().data[ch] + dst_bin_r;
+          const cplxf* mc = m[ch];
+          for (int j = 0; j < FFTFracShift::W; j++) {
+            cplxf cj = c[j];
+            for (int k = 0; k < run_n; k++)
+              dst[k * dst_stp_i + j] += cj * mc[k];
+          }
+        }
+      }
+      else {
+        FixPoint<12> d = dst_bin;
+        for (int k = 0; k < run_n; k++, d += dst_stp) {
+          Slice<cplxf, CHANNELS> mk;
+          for (int ch = 0; ch < CHANNELS; ch++)
+            mk[ch] = m[ch][k];
+          FFTFracShift::add(_buf.dst(), d, mk);
+        }
+      }
+
+      src_bin += dir * run_n;
+      dst_bin += dst_stp * run_n;
+      n -= run_n;
+    }
+  }
 };
 
 //-------------------------------------------------------------------------------------------------
@@ -680,4 +738,69 @@ struct PeakFindFft
   operator float() { return max_bin; }
 };
 
+//*************************************************************************************************
+struct PitchTrack
+//
+// incremental version of PeakFindFft for effects that follow a fundamental from block to block
+//
+// Once locked, only a small window either side of the previous fundamental is searched (without
+// the harmonic hunt, which is where the octave jumps came from). The full PeakFindFft search is
+// only done when lock is lost: the peak moved out of the window or the confidence dropped below
+// half of what it was when locked
+//
+// State is kept in fundamental bins for the last fft length & rescaled if the length changes
+//
+{
+  enum {
+    CONF_SCALE = 8 // confidence is 1 when the fundamental has 1/CONF_SCALE of the band power
+  };
+
+  // fundamental bin from the last update (only meaningful if max_pwr > 0)
+  float max_bin;
+
+  // power of the peak found (same meaning as PeakFindFft::max_pwr)
+  float max_pwr;
+
+  // 0..1, how much of the power in the search band is at the fundamental
+  float confidence;
+
+  // false if the next update must do a full search
+  bool locked;
+
+  // confidence when lock was gained
+  float lock_confidence;
+
+  // fft length that "max_bin" relates to
+  long fft_len;
+
+  PitchTrack() { reset(); }
+
+  // forget the tracked pitch
+  void reset()
+  {
+    max_bin = 0.0f;
+    max_pwr = -1.0f;
+    confidence = 0.0f;
+    locked = false;
+    lock_confidence = 0.0f;
+    fft_len = 0;
+  }
+
+  // update from "fft" searching bins b0..b1 (like PeakFindFft may overrun "b1" by 1 bin),
+  // "band_pwr" is the power in bins b0..b1 (used for the confidence)
+  void operator()(cplxf* fft,
+                  int b0,
+                  int b1 /* b1 >= b0, b1 < fft_len/2 */,
+                  float band_pwr,
+                  long fft_len,
+                  float estimate_fundamental = 1.0f);
+
+  // return fundamental bin position
+  operator float() { return max_bin; }
+
+protected:
+  // set "confidence" from the power around "max_bin"
+  void updateConfidence(cplxf* fft, int b0, int b1, float band_pwr);
+};
+
 #endif
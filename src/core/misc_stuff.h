@@ -37,6 +37,8 @@ Free software!
 #include <valarray>
 #include <vector>
 
+#include "RtCheck.h"
+
 // for debugging
 #define VAR(x) ", " #x "=" << (x)
 #define VAR_(x) #x "=" << (x)
@@ -161,7 +163,14 @@ class CriticalSectionWrapper : public CRITICAL_SECTION {
 public:
   CriticalSectionWrapper() { InitializeCriticalSection(this); }
   ~CriticalSectionWrapper() { DeleteCriticalSection(this); }
-  void lock() { EnterCriticalSection(this); }
+  void lock()
+  {
+    // a free lock is taken without waiting, only waiting for another thread is reported
+    if (!TryEnterCriticalSection(this)) {
+      RT_CHECK("lock wait");
+      EnterCriticalSection(this);
+    }
+  }
   void unlock() { LeaveCriticalSection(this); }
   operator CRITICAL_SECTION*() { return this; }
 };
@@ -173,7 +182,11 @@ public:
   ScopeCriticalSection(CRITICAL_SECTION* cs_)
   {
     cs = cs_;
-    EnterCriticalSection(cs_);
+    // (as CriticalSectionWrapper::lock)
+    if (!TryEnterCriticalSection(cs_)) {
+      RT_CHECK("lock wait");
+      EnterCriticalSection(cs_);
+    }
   }
   ~ScopeCriticalSection() { LeaveCriticalSection(cs); }
 };
@@ -213,7 +226,14 @@ struct CriticalSectionWrapper
 {
   OSSpinLock sl;
   CriticalSectionWrapper() { sl = 0; }
-  void lock() { OSSpinLockLock(&sl); }
+  void lock()
+  {
+    // a free lock is taken without waiting, only waiting for another thread is reported
+    if (!OSSpinLockTry(&sl)) {
+      RT_CHECK("lock wait");
+      OSSpinLockLock(&sl);
+    }
+  }
   void unlock() { OSSpinLockUnlock(&sl); }
   operator OSSpinLock*() { return &sl; }
 };
@@ -225,7 +245,11 @@ public:
   ScopeCriticalSection(OSSpinLock* sl_)
   {
     sl = sl_;
-    OSSpinLockLock(sl_);
+    // (as CriticalSectionWrapper::lock)
+    if (!OSSpinLockTry(sl_)) {
+      RT_CHECK("lock wait");
+      OSSpinLockLock(sl_);
+    }
   }
   ~ScopeCriticalSection() { OSSpinLockUnlock(sl); }
 };
@@ -14,15 +14,22 @@ This software is completely free software
 // #include <StdAfx.h>
 
 #include "rfftw_float.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace std;
 
 // these blocks were found by choosing the fastest 4 block sizes between each pwr-of-2 (including
-// the pwr-of-2) blocks, most of them were auto selected but a few were hand picked
+// the pwr-of-2) blocks, most of them were auto selected but a few were hand picked. They can be
+// replaced at startup by a table tuned for the host cpu (see TuneFFTSz & LoadFFTSzTable)
 int g_fft_sz[NUM_FFT_SZ] = {256,   320,   384,   448,   512,   640,   768,   896,   1024,
                             1280,  1536,  1792,  2048,  2560,  3072,  3584,  4096,  5120,
                             6144,  7168,  8192,  9600,  12288, 13440, 16384, 20480, 24576,
                             28672, 32768, 40500, 49152, 57600, 65536, 80640};
 
 ScopeFFTWfPlan g_fft_plan[NUM_FFT_SZ], g_ifft_plan[NUM_FFT_SZ];
+ScopeFFTWfPlan g_cfft_plan[NUM_FFT_SZ], g_icfft_plan[NUM_FFT_SZ];
 //-------------------------------------------------------------------------------------------------
 void CreateFFTWfPlans()
 {
@@ -33,6 +40,9 @@ void CreateFFTWfPlans()
   ScopeFFTWfMalloc<cplxf> b;
   b.resize(MAX_FFT_SZ / 2 + 1);
 
+  ScopeFFTWfMalloc<cplxf> c;
+  c.resize(MAX_FFT_SZ);
+
   // create the plans
   for (int i = 0; i < NUM_FFT_SZ; i++) {
     g_fft_plan[i] = FFTWf::plan_dft_r2c_1d(g_fft_sz[i], a, to_fftwf_complex(b), FFTW_ESTIMATE);
@@ -42,7 +52,152 @@ void CreateFFTWfPlans()
     // g_ifft_plan[i] = FFTWf::plan_dft_c2r_1d(g_fft_sz[i], (fftwf_complex*)NULL, (float*)NULL,
     // FFTW_ESTIMATE);
 
-    if (!g_fft_plan[i] || !g_ifft_plan[i])
+    g_cfft_plan[i] = FFTWf::plan_dft_1d(
+        g_fft_sz[i], to_fftwf_complex(c), to_fftwf_complex(c), FFTW_FORWARD, FFTW_ESTIMATE);
+    g_icfft_plan[i] = FFTWf::plan_dft_1d(
+        g_fft_sz[i], to_fftwf_complex(c), to_fftwf_complex(c), FFTW_BACKWARD, FFTW_ESTIMATE);
+
+    if (!g_fft_plan[i] || !g_ifft_plan[i] || !g_cfft_plan[i] || !g_icfft_plan[i])
       throw 0;
   }
 }
+
+//-------------------------------------------------------------------------------------------------
+void FFTSzRange(int i, int& /*out*/ lo, int& /*out*/ hi)
+{
+  // plans come in groups of 4 starting at each pwr-of-2
+  int pwr2 = MIN_FFT_SZ << (i / 4);
+  int nominal = pwr2 + pwr2 / 4 * (i % 4);
+  if (i % 4 == 0) {
+    lo = hi = pwr2;
+    return;
+  }
+  lo = nominal - pwr2 / 8;
+  hi = min(nominal + pwr2 / 8, (int)MAX_FFT_SZ);
+}
+
+//-------------------------------------------------------------------------------------------------
+static bool /*true=only factors of 2,3,5,7*/ SmoothSz(int n)
+{
+  static const int factors[] = {2, 3, 5, 7};
+  for (int f : factors)
+    while (n % f == 0)
+      n /= f;
+  return n == 1;
+}
+
+//-------------------------------------------------------------------------------------------------
+static double /*seconds*/ TimeFFTSz(int n, float* a, cplxf* b, double secs)
+// time for a forward & inverse fft of length "n" (best of a few batches)
+{
+  typedef chrono::steady_clock Clock;
+
+  // plan the same way as CreateFFTWfPlans
+  ScopeFFTWfPlan fwd = FFTWf::plan_dft_r2c_1d(n, a, to_fftwf_complex(b), FFTW_ESTIMATE);
+  ScopeFFTWfPlan inv = FFTWf::plan_dft_c2r_1d(n, to_fftwf_complex(b), a, FFTW_ESTIMATE);
+  if (!fwd || !inv)
+    return 1e30;
+
+  double best = 1e30;
+  for (int batch = 0; batch < 3; batch++) {
+    long reps = 0;
+    Clock::time_point t0 = Clock::now();
+    double t;
+    do {
+      // inverse is unscaled, keep the data from growing
+      for (int i = 0; i < n; i++)
+        a[i] = (float)((i * 7919) % 1024) * (1.0f / 512.0f) - 1.0f;
+      FFTWf::execute_dft_r2c(fwd, a, to_fftwf_complex(b));
+      FFTWf::execute_dft_c2r(inv, to_fftwf_complex(b), a);
+      reps++;
+      t = chrono::duration<double>(Clock::now() - t0).count();
+    } while (t < secs / 3.0 || reps < 3);
+    best = min(best, t / (double)reps);
+  }
+  return best;
+}
+
+//-------------------------------------------------------------------------------------------------
+void TuneFFTSz(int* /*out*/ sz, double secs_per_sz, std::ostream* log)
+{
+  ScopeFFTWfMalloc<float> a;
+  a.resize(MAX_FFT_SZ);
+
+  ScopeFFTWfMalloc<cplxf> b;
+  b.resize(MAX_FFT_SZ / 2 + 1);
+
+  for (int i = 0; i < NUM_FFT_SZ; i++) {
+    int lo, hi;
+    FFTSzRange(i, lo, hi);
+
+    // fall back to the built in size if nothing better turns up
+    sz[i] = g_fft_sz[i];
+    double best = TimeFFTSz(sz[i], a, b, secs_per_sz) / (double)sz[i];
+
+    for (int n = lo + (lo & 1); n <= hi; n += 2) {
+      if (n == g_fft_sz[i] || !SmoothSz(n))
+        continue;
+      double t = TimeFFTSz(n, a, b, secs_per_sz) / (double)n;
+      if (t < best) {
+        best = t;
+        sz[i] = n;
+      }
+    }
+    if (log)
+      *log << "plan " << i << ": " << sz[i] << " (" << best * 1e9 << " ns/sample, was "
+           << g_fft_sz[i] << ")" << std::endl;
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+bool /*true=ok*/ LoadFFTSzTable(const char* path)
+{
+  FILE* f = fopen(path, "r");
+  if (!f)
+    return false;
+
+  int sz[NUM_FFT_SZ];
+  int n = 0;
+  bool ok = true;
+  char line[256];
+  while (ok && fgets(line, sizeof(line), f)) {
+    // strip comments & skip blank lines
+    char* c = line;
+    while (*c && *c != '#')
+      c++;
+    *c = 0;
+    char* end;
+    long v = strtol(line, &end, 10);
+    if (end == line)
+      continue;
+
+    // each size must be even & in the range of its plan
+    int lo, hi;
+    ok = n < NUM_FFT_SZ;
+    if (ok) {
+      FFTSzRange(n, lo, hi);
+      ok = v >= lo && v <= hi && (v & 1) == 0;
+    }
+    if (ok)
+      sz[n++] = (int)v;
+  }
+  fclose(f);
+
+  if (!ok || n != NUM_FFT_SZ)
+    return false;
+  for (int i = 0; i < NUM_FFT_SZ; i++)
+    g_fft_sz[i] = sz[i];
+  return true;
+}
+
+//-------------------------------------------------------------------------------------------------
+bool /*true=ok*/ SaveFFTSzTable(const char* path, const int* sz)
+{
+  FILE* f = fopen(path, "w");
+  if (!f)
+    return false;
+  bool ok = fprintf(f, "# DtBlkFx fft sizes, one per plan\n") > 0;
+  for (int i = 0; i < NUM_FFT_SZ; i++)
+    ok = ok && fprintf(f, "%d\n", sz[i]) > 0;
+  return fclose(f) == 0 && ok;
+}
@@ -30,7 +30,27 @@ extern int g_fft_sz[NUM_FFT_SZ];
 // array of plans that we have built
 extern ScopeFFTWfPlan g_fft_plan[NUM_FFT_SZ], g_ifft_plan[NUM_FFT_SZ];
 
+// in-place complex plans of the same sizes, used to transform both stereo channels at once (one
+// channel as the real part & the other as the imaginary part)
+extern ScopeFFTWfPlan g_cfft_plan[NUM_FFT_SZ], g_icfft_plan[NUM_FFT_SZ];
+
 // create plans, throw error if failure
 extern void CreateFFTWfPlans();
 
+// range of sizes (inclusive) that plan "i" may be tuned to, pwr-of-2 plans are fixed & the others
+// stay within 1/8 of an octave of their nominal size so that the fft length param still means the
+// same thing for saved sessions
+extern void FFTSzRange(int i, int& /*out*/ lo, int& /*out*/ hi);
+
+// benchmark the sizes in range of each plan on this cpu & return the fastest (per sample) in "sz",
+// progress is written to "log" if not NULL
+extern void TuneFFTSz(int* /*out*/ sz /*NUM_FFT_SZ*/,
+                      double secs_per_sz = 0.05,
+                      std::ostream* log = NULL);
+
+// size table files: text, one size per line for each plan ('#' starts a comment). Loading only
+// replaces g_fft_sz if the whole table is valid & must be done before CreateFFTWfPlans()
+extern bool /*true=ok*/ LoadFFTSzTable(const char* path);
+extern bool /*true=ok*/ SaveFFTSzTable(const char* path, const int* sz /*NUM_FFT_SZ*/);
+
 #endif
@@ -44,9 +44,15 @@ inline long wrapProcess(P& p,         // class containing "process(float*, int n
 
 //------------------------------------------------------------------------------------------
 // some different src & dst mixing classes
+//
+// these work on spans: a SRC returns element "i" of the current span via operator[] and is moved
+// on with advance(), a DST processes a whole span in span(). Ramps are evaluated as val+stp*i
+// rather than accumulated per sample so that there's no loop carried dependency and the compiler
+// can vectorize the loops
 struct PNoSrc {
   void setLen(long n) {}
-  float operator()() { return 0; }
+  float operator[](long i) const { return 0; }
+  void advance(long n) {}
 };
 struct P1Src {
   float *ptr, scale;
@@ -56,20 +62,99 @@ struct P1Src {
     scale = scale_;
   }
   void setLen(long n) {}
-  float operator()() { return *ptr++ * scale; }
+  float operator[](long i) const { return ptr[i] * scale; }
+  void advance(long n) { ptr += n; }
 };
 struct P2Src {
   P1Src a, b;
   void setLen(long n) {}
-  float operator()() { return *a.ptr++ * a.scale + *b.ptr++ * b.scale; }
+  float operator[](long i) const { return a[i] + b[i]; }
+  void advance(long n)
+  {
+    a.advance(n);
+    b.advance(n);
+  }
+};
+struct P3Src {
+  P1Src a, b, c;
+  void setLen(long n) {}
+  float operator[](long i) const { return a[i] + b[i] + c[i]; }
+  void advance(long n)
+  {
+    a.advance(n);
+    b.advance(n);
+    c.advance(n);
+  }
+};
+template <int WDW_PWR = 1> struct P1WdwSrc
+// src scaled by a window (or the window squared)
+{
+  const float *ptr, *wdw;
+  float scale;
+  P1WdwSrc(const float* ptr_ = NULL, const float* wdw_ = NULL, float scale_ = 1)
+  {
+    ptr = ptr_;
+    wdw = wdw_;
+    scale = scale_;
+  }
+  void setLen(long n) {}
+  float operator[](long i) const
+  {
+    return WDW_PWR == 2 ? ptr[i] * wdw[i] * wdw[i] * scale : ptr[i] * wdw[i] * scale;
+  }
+  void advance(long n)
+  {
+    ptr += n;
+    wdw += n;
+  }
+};
+template <class A, class B> struct PSumSrc {
+  A a;
+  B b;
+  void setLen(long n) {}
+  float operator[](long i) const { return a[i] + b[i]; }
+  void advance(long n)
+  {
+    a.advance(n);
+    b.advance(n);
+  }
 };
 struct PBlatDst {
   void setLen(long n) {}
-  void operator()(float* dst, float src) { *dst = src; }
+  template <class SRC> void span(float* dst, const SRC& src, long n)
+  {
+    for (long i = 0; i < n; i++)
+      dst[i] = src[i];
+  }
 };
 struct PScaleDst : public PBlatDst {
   float scale;
-  void operator()(float* dst, float src) { *dst = *dst * scale + src; }
+  template <class SRC> void span(float* dst, const SRC& src, long n)
+  {
+    for (long i = 0; i < n; i++)
+      dst[i] = dst[i] * scale + src[i];
+  }
+};
+struct PWgtDst : public PBlatDst
+// scale dst by a weight per sample & add src
+{
+  const float* wgt;
+  template <class SRC> void span(float* dst, const SRC& src, long n)
+  {
+    for (long i = 0; i < n; i++)
+      dst[i] = dst[i] * wgt[i] + src[i];
+    wgt += n;
+  }
+};
+struct PCompDst : public PWgtDst
+// add src with the weight that dst is missing (1-wgt)
+{
+  template <class SRC> void span(float* dst, const SRC& src, long n)
+  {
+    for (long i = 0; i < n; i++)
+      dst[i] += src[i] * (1.0f - wgt[i]);
+    wgt += n;
+  }
 };
 struct PMixDst
 // mix src into dst
@@ -84,17 +169,23 @@ struct PMixDst
   }
 
   void setLen(long n) { mix.stp /= (float)n; }
-  void operator()(float* dst, float src)
+  template <class SRC> void span(float* dst, const SRC& src, long n)
   {
-    *dst = *dst * mix + src * (1 - mix);
-    mix.next();
+    float m0 = mix.val, stp = mix.stp;
+    for (long i = 0; i < n; i++) {
+      float m = m0 + stp * (float)i;
+      dst[i] = dst[i] * m + src[i] * (1 - m);
+    }
+    mix.next(n);
   }
 };
 struct PRampDst : public PMixDst {
-  void operator()(float* dst, float src)
+  template <class SRC> void span(float* dst, const SRC& src, long n)
   {
-    *dst = *dst * mix + src;
-    mix.next();
+    float m0 = mix.val, stp = mix.stp;
+    for (long i = 0; i < n; i++)
+      dst[i] = dst[i] * (m0 + stp * (float)i) + src[i];
+    mix.next(n);
   }
 };
 //------------------------------------------------------------------------------------------
@@ -111,9 +202,8 @@ struct PSrcDstWrap
   }
   void process(float* dst_data, long n)
   {
-    float* dst_e = dst_data + n;
-    for (; dst_data != dst_e; dst_data++)
-      dst(dst_data, src());
+    dst.span(dst_data, src, n);
+    src.advance(n);
   }
 };
 
@@ -156,6 +246,27 @@ struct PAddOut
   }
 };
 
+//------------------------------------------------------------------------------------------
+struct PWdwCopyOut
+    : public PCopyOut
+// copy FIFO data "x" out to dst scaled by window "wdw"
+// x * wdw => dst
+{
+  const float* wdw;
+  PWdwCopyOut(float* dst_ = NULL, const float* wdw_ = NULL)
+  {
+    dst = dst_;
+    wdw = wdw_;
+  }
+  void process(float* x, long n)
+  {
+    for (long i = 0; i < n; i++)
+      dst[i] = x[i] * wdw[i];
+    dst += n;
+    wdw += n;
+  }
+};
+
 //------------------------------------------------------------------------------------------
 template <class INTERP_PROC, int REVERSE = 0>
 struct PLinInterp
@@ -233,10 +344,10 @@ public: // called by wrapProcess
       samp_i += (long)(dst_e - dst);
 
       // process segment
-      while (dst < dst_e) {
-        proc(dst++, curr_mult);
-        curr_mult.next();
-      }
+      long seg_n = (long)(dst_e - dst);
+      proc.span(dst, curr_mult, seg_n);
+      curr_mult.next(seg_n);
+      dst = dst_e;
     }
   }
 
@@ -268,13 +379,29 @@ public: // internal method
 template <class SRC> struct PMix {
   SRC src;
   void setLen(long n) { src.setLen(n); }
-  void operator()(float* dst, float src_mix) { *dst = lin_interp(src_mix, *dst, src()); }
+
+  // mix ramps from "src_mix" (0=dst, 1=src)
+  void span(float* dst, const ValStp<float>& src_mix, long n)
+  {
+    float m0 = src_mix.val, stp = src_mix.stp;
+    for (long i = 0; i < n; i++)
+      dst[i] = lin_interp(m0 + stp * (float)i, dst[i], src[i]);
+    src.advance(n);
+  }
 };
 
 struct PScaleCopyOut {
   float* dst;
   void setLen(long n) {}
-  void operator()(float* src, float mix) { *dst++ = *src * mix; }
+
+  // copy "src" out to dst scaled by ramp "mix"
+  void span(float* src, const ValStp<float>& mix, long n)
+  {
+    float m0 = mix.val, stp = mix.stp;
+    for (long i = 0; i < n; i++)
+      dst[i] = src[i] * (m0 + stp * (float)i);
+    dst += n;
+  }
 };
 
 #endif
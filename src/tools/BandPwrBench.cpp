@@ -0,0 +1,205 @@
+/**************************************************************************************************
+Show how the cost of the band power queries scales with the number of segments or harmonics
+
+usage: DtBlkFxBandPwrBench [seconds of audio]
+
+Noise (left) & a chirp (right) go through the vocoder at a few fft lengths. For each fft length
+the spectrum of the last blk is then queried the way the effects do: "segs" bands splitting the
+spectrum (as the vocoder's segments) & "harms" bands of 2 harmonic spacings around each harmonic
+(as the harmonic match effects, each bin is in 2 bands). Each query set is answered by scanning
+the bins of each band (GetPwr, as the effects used to) & by DtBlkFx::rngPwr per band, both with
+the cumulative power already built by an earlier query & with it rebuilt first (DtBlkFx::cumPwr,
+as for the first query of a blk or after an earlier slot has written the spectrum). Each line has
+the time per query set each way, the speedup of rngPwr over the scan & the largest relative
+difference between the answers.
+
+The last part renders the vocoder at several segment counts, each line has the average callback
+cost (DtBlkFx::getCallbackCost) which should stay about the same as the segments go up.
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "DtBlkFx.hpp"
+#include "OfflineRender.h"
+
+enum { AUDIO_CHANNELS = DtBlkFx::AUDIO_CHANNELS };
+
+static const int VOCODE_FX = 26;
+
+static const long g_fft_lens[] = {4096, 16384, 65536};
+
+static const long g_seg_counts[] = {10, 100, 400, 1000, 4000};
+
+// vocoder segment counts for the render part (400 is the most the param gives)
+static const long g_voc_segs[] = {1, 10, 100, 200, 400};
+
+//-------------------------------------------------------------------------------------------------
+static void MakeQueries(bool harms, long n_segs, long max_bin, std::vector<long>& /*out*/ b)
+// band i is b[2*i]..b[2*i+1] (inclusive) within 1..max_bin
+{
+  b.clear();
+  double stp = (double)max_bin / (double)n_segs;
+  for (long i = 0; i < n_segs; i++) {
+    double b0 = harms ? (double)i * stp : 1.0 + (double)i * stp;
+    double b1 = harms ? (double)(i + 2) * stp : 1.0 + (double)(i + 1) * stp - 1.0;
+    long l0 = limit_range((long)b0, 1L, max_bin);
+    long l1 = limit_range((long)b1, l0, max_bin);
+    b.push_back(l0);
+    b.push_back(l1);
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+enum QueryMode { SCAN, CUM_PWR, REBUILD };
+
+static double NsPerSet(DtBlkFx* fx, QueryMode mode, const std::vector<long>& b,
+                       std::vector<float>& /*out*/ pwr)
+// time to answer all the queries on both channels
+{
+  long n = (long)b.size() / 2;
+  pwr.resize(AUDIO_CHANNELS * n);
+
+  // at least a few ms per timing
+  long reps = std::max(10L, 20000000L / (fx->_freq_fft_n + 100 * n));
+
+  // start from an up to date cumulative power
+  fx->binPwrReset();
+  for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+    fx->cumPwr(ch);
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (long r = 0; r < reps; r++) {
+    if (mode == REBUILD)
+      fx->binPwrReset();
+
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+      float* p = &pwr[ch * n];
+      if (mode == SCAN)
+        for (long i = 0; i < n; i++)
+          p[i] = GetPwr(fx->FFTdata(ch), b[2 * i], b[2 * i + 1]);
+      else
+        for (long i = 0; i < n; i++)
+          p[i] = fx->rngPwr(ch, b[2 * i], b[2 * i + 1]);
+    }
+  }
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  return secs * 1e9 / (double)reps;
+}
+
+//-------------------------------------------------------------------------------------------------
+static void SetVocode(DtBlkFx* fx, long n_segs)
+// fx set 0 is the vocoder with "n_segs" segments over the whole spectrum, the others are off
+{
+  // (val is the inverse of VocodeFx::getSegs)
+  SetSoloFx(fx, VOCODE_FX, 0.0f, 1.0f, 0.6f, /*val*/ (float)(n_segs - 1) * (0.875f / 399.0f));
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  double audio_secs = argc > 1 ? atof(argv[1]) : 10.0;
+  long n = (long)(audio_secs * RENDER_SAMPLE_RATE);
+
+  // the queries need a few blks of the longest fft whatever the audio length (the scratch of the
+  // last blk is only there if a blk has run since the fft length changed)
+  long query_n = 4 * *std::max_element(std::begin(g_fft_lens), std::end(g_fft_lens));
+
+  DtBlkFx* fx = NewRenderFx();
+
+  RenderBuf in(std::max(n, query_n)), out(std::max(n, query_n));
+  in.gen(TEST_NOISE, TEST_CHIRP);
+
+  namespace P = BlkFxParam;
+  fx->setParameter(P::MIX_BACK, 0.0f);
+  fx->setParameter(P::OVERLAP, 0.3f);
+
+  printf("band power queries, ns per query set (both channels)\n");
+  printf("%6s %-6s %6s %9s %9s %9s %8s %8s %9s\n",
+         "fft",
+         "bands",
+         "n",
+         "scan",
+         "cum pwr",
+         "rebuild",
+         "x cum",
+         "x rebld",
+         "max err");
+
+  std::vector<long> b;
+  std::vector<float> scan_pwr, cum_pwr;
+  for (long fft_len : g_fft_lens) {
+    SetFFTLen(fx, fft_len);
+    SetVocode(fx, 100);
+    RenderOffline(fx, in, out, 4 * fft_len);
+
+    // the last blk's spectrum is left in the scratch (nothing else runs on it until the next
+    // render), FFTdata has the vocoder output so the power plane is rebuilt from it
+    long max_bin = fx->_freq_fft_n / 2;
+
+    for (int harms = 0; harms < 2; harms++) {
+      for (long n_segs : g_seg_counts) {
+        if (n_segs > max_bin / 2)
+          continue;
+        MakeQueries(harms != 0, n_segs, max_bin, b);
+
+        double scan = NsPerSet(fx, SCAN, b, scan_pwr);
+        double rebuild = NsPerSet(fx, REBUILD, b, cum_pwr);
+        double cum = NsPerSet(fx, CUM_PWR, b, cum_pwr);
+
+        float max_err = 0.0f;
+        for (size_t i = 0; i < scan_pwr.size(); i++)
+          max_err = std::max(max_err,
+                             fabsf(cum_pwr[i] - scan_pwr[i]) / std::max(scan_pwr[i], 1e-30f));
+
+        printf("%6ld %-6s %6ld %9.0f %9.0f %9.0f %7.2fx %7.2fx %9.3g\n",
+               fx->_freq_fft_n,
+               harms ? "harms" : "segs",
+               n_segs,
+               scan,
+               cum,
+               rebuild,
+               scan / cum,
+               scan / rebuild,
+               max_err);
+      }
+    }
+  }
+
+  printf("\nvocoder render, %.1f secs of audio, callback costs in us\n", audio_secs);
+  printf("%6s %6s %9s %9s\n", "fft", "segs", "avg", "max");
+  for (long fft_len : g_fft_lens) {
+    SetFFTLen(fx, fft_len);
+    for (long n_segs : g_voc_segs) {
+      SetVocode(fx, n_segs);
+
+      DtBlkFx::CallbackCost cost;
+      fx->getCallbackCost(cost, /*reset*/ true);
+      RenderOffline(fx, in, out, n);
+      fx->getCallbackCost(cost);
+
+      printf("%6ld %6ld %9.1f %9.1f\n",
+             fx->_freq_fft_n,
+             n_segs,
+             cost.avg_secs * 1e6,
+             cost.max_secs * 1e6);
+    }
+  }
+
+  delete fx;
+  return 0;
+}
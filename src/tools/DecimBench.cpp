@@ -0,0 +1,101 @@
+/**************************************************************************************************
+Compare the cost of decimated processing of low band presets with full rate processing
+
+usage: DtBlkFxDecimBench [seconds of audio]
+
+Noise goes through a few presets that only change bins at low frequencies (a sub-bass boost, a
+low cut & a bass shelf) at several fft lengths, rendered at full rate & then with decimated
+processing (DtBlkFx::setDecimate). Each line has the average & worst callback cost
+(DtBlkFx::getCallbackCost) both ways, the speedup of the average & the snr of the decimated output
+against the full rate output.
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "DtBlkFx.hpp"
+#include "OfflineRender.h"
+
+static const FilterPreset g_presets[] = {
+    {"sub boost", 20.0f, 80.0f, 9.0f},
+    {"low cut", 0.0f, 120.0f, -60.0f},
+    {"bass shelf", 0.0f, 400.0f, 6.0f},
+};
+
+static const long g_fft_lens[] = {4096, 16384, 65536};
+
+//-------------------------------------------------------------------------------------------------
+static void Render(DtBlkFx* fx, float** in, float** out, long n, DtBlkFx::CallbackCost& cost)
+{
+  fx->getCallbackCost(cost, /*reset*/ true);
+  RenderOffline(fx, in, out, n);
+  fx->getCallbackCost(cost);
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  double audio_secs = argc > 1 ? atof(argv[1]) : 20.0;
+  long n = (long)(audio_secs * RENDER_SAMPLE_RATE);
+
+  DtBlkFx* fx = NewRenderFx();
+
+  RenderBuf in(n), ref(n), out(n);
+  in.gen(TEST_NOISE, TEST_NOISE);
+
+  namespace P = BlkFxParam;
+  fx->setParameter(P::MIX_BACK, 0.0f);
+  fx->setParameter(P::OVERLAP, 0.3f);
+
+  printf("%.1f secs of audio, callback costs in us\n", audio_secs);
+  printf("%-10s %6s %9s %9s %9s %9s %8s %8s\n",
+         "preset",
+         "fft",
+         "avg full",
+         "max full",
+         "avg decim",
+         "max decim",
+         "speedup",
+         "snr dB");
+
+  for (const FilterPreset& preset : g_presets) {
+    SetSoloFilter(fx, preset);
+
+    for (long fft_len : g_fft_lens) {
+      fft_len = SetFFTLen(fx, fft_len);
+
+      DtBlkFx::CallbackCost full, decim;
+      fx->setDecimate(false);
+      Render(fx, in, ref, n, full);
+      fx->setDecimate(true);
+      Render(fx, in, out, n, decim);
+      fx->setDecimate(false);
+
+      RenderDiff diff = CompareRender(ref.ch[0], out.ch[0], n);
+
+      printf("%-10s %6ld %9.1f %9.1f %9.1f %9.1f %7.2fx %8.1f\n",
+             preset.name,
+             fft_len,
+             full.avg_secs * 1e6,
+             full.max_secs * 1e6,
+             decim.avg_secs * 1e6,
+             decim.max_secs * 1e6,
+             full.avg_secs / decim.avg_secs,
+             diff.snr_db);
+    }
+  }
+
+  delete fx;
+  return 0;
+}
@@ -0,0 +1,116 @@
+/**************************************************************************************************
+Show how differential resynthesis resynthesizes narrow band presets & what it saves
+
+usage: DtBlkFxDiffBench [seconds of audio]
+
+Noise with a 50Hz hum goes through a few presets that only change a band of the spectrum (a hum
+notch, a narrow boost & for comparison a wide cut) at several fft lengths. Each is rendered with
+full inverse ffts & then with differential resynthesis, each line has the number of channel blks
+that went through the full inverse, the resonators & the pruned inverse, the time per second of
+audio both ways & the snr of the differential output against the full inverse output.
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "DtBlkFx.hpp"
+#include "OfflineRender.h"
+
+enum { AUDIO_CHANNELS = DtBlkFx::AUDIO_CHANNELS };
+
+static const FilterPreset g_presets[] = {
+    {"hum notch", 45.0f, 65.0f, -60.0f},
+    {"1k boost", 950.0f, 1050.0f, 6.0f},
+    {"3k+ cut", 3000.0f, 22050.0f, -60.0f},
+};
+
+static const long g_fft_lens[] = {4096, 16384, 65536};
+
+//-------------------------------------------------------------------------------------------------
+static double Render(DtBlkFx* fx, float** in, float** out, long n)
+// return seconds per second of audio
+{
+  auto t0 = std::chrono::steady_clock::now();
+  RenderOffline(fx, in, out, n);
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  return secs * RENDER_SAMPLE_RATE / (double)n;
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  double audio_secs = argc > 1 ? atof(argv[1]) : 20.0;
+  long n = (long)(audio_secs * RENDER_SAMPLE_RATE);
+
+  DtBlkFx* fx = NewRenderFx();
+
+  // noise (the same on every channel) with a hum
+  RenderBuf in(n), ref(n), out(n);
+  unsigned long rnd = 1;
+  for (long i = 0; i < n; i++) {
+    rnd = rnd * 1664525UL + 1013904223UL;
+    float noise = (float)((rnd >> 8) & 0xffff) * (1.0f / 32768.0f) - 1.0f;
+    float hum = sinf(2.0f * 3.1415926f * 50.0f * (float)i / RENDER_SAMPLE_RATE);
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+      in.ch[ch][i] = 0.1f * noise + 0.25f * hum;
+  }
+
+  namespace P = BlkFxParam;
+  fx->setParameter(P::MIX_BACK, 0.0f);
+  fx->setParameter(P::OVERLAP, 0.0f);
+
+  printf("%.1f secs of audio\n", audio_secs);
+  printf("%-10s %6s %8s %8s %8s %10s %10s %9s\n",
+         "preset",
+         "fft",
+         "full",
+         "reson",
+         "pruned",
+         "cpu full",
+         "cpu diff",
+         "snr dB");
+
+  for (const FilterPreset& preset : g_presets) {
+    SetSoloFilter(fx, preset);
+
+    for (long fft_len : g_fft_lens) {
+      fft_len = SetFFTLen(fx, fft_len);
+
+      fx->setDiffResynth(false);
+      double cpu_full = Render(fx, in, ref, n);
+
+      fx->setDiffResynth(true);
+      fx->getDiffStats(/*reset*/ true);
+      double cpu_diff = Render(fx, in, out, n);
+      DtBlkFx::DiffStats stats = fx->getDiffStats();
+
+      // the same on every channel
+      RenderDiff diff = CompareRender(ref.ch[0], out.ch[0], n);
+
+      printf("%-10s %6ld %8ld %8ld %8ld %10.5f %10.5f %9.1f\n",
+             preset.name,
+             fft_len,
+             stats.full,
+             stats.resonator,
+             stats.pruned,
+             cpu_full,
+             cpu_diff,
+             diff.snr_db);
+    }
+  }
+
+  delete fx;
+  return 0;
+}
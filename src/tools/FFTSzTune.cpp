@@ -0,0 +1,37 @@
+/**************************************************************************************************
+Benchmark fft sizes on this cpu & write a size table for DtBlkFx to load at startup
+
+usage: DtBlkFxFFTSzTune [output file] [seconds per size]
+
+The plugin looks for the table in the user application data directory as DtBlkFx/fft_sizes.txt
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <iostream>
+#include <stdlib.h>
+
+#include "rfftw_float.h"
+
+int main(int argc, char** argv)
+{
+  const char* path = argc > 1 ? argv[1] : "fft_sizes.txt";
+  double secs = argc > 2 ? atof(argv[2]) : 0.05;
+
+  int sz[NUM_FFT_SZ];
+  TuneFFTSz(sz, secs, &std::cout);
+
+  if (!SaveFFTSzTable(path, sz)) {
+    std::cerr << "failed to write " << path << std::endl;
+    return 1;
+  }
+  std::cout << "wrote " << path << std::endl;
+  return 0;
+}
@@ -0,0 +1,260 @@
+/**************************************************************************************************
+Accuracy test & throughput benchmark of the fast_math.h approximations against libm
+
+usage: DtBlkFxFastMath [-bench]
+
+Each function is evaluated at every tier over a dense sweep of its input range & the worst error
+against the double precision libm result is compared with the limit documented in fast_math.h.
+Each line has the worst error found & the limit, it exits with 1 if any is over. With -bench it
+also times a loop over an array of inputs for each function & tier & for the float libm function,
+each line has the time per value & the speedup over libm.
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "fast_math.h"
+
+static const char* g_tier_names[] = {"lo", "mid", "hi"};
+
+// limits from the table in fast_math.h, [function][tier]
+enum { LOG2, EXP2, POW, ATAN2, SINCOS, NUM_FNS };
+static const char* g_fn_names[NUM_FNS] = {"log2", "exp2", "pow", "atan2", "sincos"};
+static const char* g_err_names[NUM_FNS] = {"abs", "rel", "rel", "abs", "abs"};
+static const double g_limits[NUM_FNS][3] = {
+    {8.6e-4, 1.9e-5, 4.2e-6},
+    {1.5e-4, 3.9e-6, 1.2e-7},
+    {2.5e-3, 4.8e-5, 6.8e-6},
+    {6.1e-4, 1.2e-5, 5.1e-7},
+    {1.6e-4, 6.6e-7, 9.2e-8},
+};
+
+// points in each sweep
+static const long SWEEP_N = 1 << 20;
+
+//-------------------------------------------------------------------------------------------------
+static double RelErr(double approx, double exact)
+{
+  return fabs(approx - exact) / fabs(exact);
+}
+
+//-------------------------------------------------------------------------------------------------
+template <int TIER> static double WorstErr(int fn)
+// worst error of "fn" at TIER over its sweep
+{
+  double worst = 0.0;
+  for (long i = 0; i < SWEEP_N; i++) {
+    double u = (double)i / (double)(SWEEP_N - 1); // 0..1
+    switch (fn) {
+      case LOG2: {
+        // 1e-30..1e30 log spaced
+        float x = (float)pow(10.0, -30.0 + 60.0 * u);
+        worst = fmax(worst, fabs(FastLog2<TIER>(x) - log2((double)x)));
+        break;
+      }
+      case EXP2: {
+        float x = (float)(-126.0 + 252.0 * u);
+        worst = fmax(worst, RelErr(FastExp2<TIER>(x), exp2((double)x)));
+        break;
+      }
+      case POW: {
+        // x over 1e-6..1e6 & y over -4..4
+        float x = (float)pow(10.0, -6.0 + 12.0 * fmod(u * 1024.0, 1.0));
+        float y = (float)(-4.0 + 8.0 * u);
+        worst = fmax(worst, RelErr(FastPow<TIER>(x, y), pow((double)x, (double)y)));
+        break;
+      }
+      case ATAN2: {
+        // all the way round the circle at a few radii
+        double a = 2.0 * 3.14159265358979 * u;
+        double r = pow(10.0, -3.0 + 6.0 * fmod(u * 64.0, 1.0));
+        float y = (float)(r * sin(a)), x = (float)(r * cos(a));
+        worst = fmax(worst, fabs(FastAtan2<TIER>(y, x) - atan2((double)y, (double)x)));
+        break;
+      }
+      case SINCOS: {
+        // a few hundred turns either side of 0
+        float a = (float)(-1000.0 + 2000.0 * u);
+        float s, c;
+        FastSinCos<TIER>(a, s, c);
+        worst = fmax(worst, fmax(fabs(s - sin((double)a)), fabs(c - cos((double)a))));
+        break;
+      }
+    }
+  }
+  return worst;
+}
+
+//-------------------------------------------------------------------------------------------------
+template <int TIER> static bool TestTier()
+{
+  bool ok = true;
+  for (int fn = 0; fn < NUM_FNS; fn++) {
+    double err = WorstErr<TIER>(fn);
+    double limit = g_limits[fn][TIER];
+    bool fn_ok = err <= limit;
+    printf("%-7s %-4s %-4s %10.3g %10.3g %s\n",
+           g_fn_names[fn],
+           g_err_names[fn],
+           g_tier_names[TIER],
+           err,
+           limit,
+           fn_ok ? "ok" : "FAIL");
+    ok &= fn_ok;
+  }
+  return ok;
+}
+
+//-------------------------------------------------------------------------------------------------
+// the function being timed over "x" (& "y") into "out", TIER -1 is libm. The pointers are restrict
+// so that the loops can be vectorized without alias checks
+template <int TIER> struct Eval {
+  static void run(int fn, const float* __restrict x, const float* __restrict y,
+                  float* __restrict out, long n)
+  {
+    switch (fn) {
+      case LOG2:
+        for (long i = 0; i < n; i++)
+          out[i] = FastLog2<TIER>(x[i]);
+        break;
+      case EXP2:
+        for (long i = 0; i < n; i++)
+          out[i] = FastExp2<TIER>(y[i]);
+        break;
+      case POW:
+        for (long i = 0; i < n; i++)
+          out[i] = FastPow<TIER>(x[i], y[i]);
+        break;
+      case ATAN2:
+        for (long i = 0; i < n; i++)
+          out[i] = FastAtan2<TIER>(y[i], x[i]);
+        break;
+      case SINCOS:
+        for (long i = 0; i < n; i++) {
+          float s, c;
+          FastSinCos<TIER>(y[i], s, c);
+          out[i] = s + c;
+        }
+        break;
+    }
+  }
+};
+template <> struct Eval<-1> {
+  static void run(int fn, const float* __restrict x, const float* __restrict y,
+                  float* __restrict out, long n)
+  {
+    switch (fn) {
+      case LOG2:
+        for (long i = 0; i < n; i++)
+          out[i] = log2f(x[i]);
+        break;
+      case EXP2:
+        for (long i = 0; i < n; i++)
+          out[i] = exp2f(y[i]);
+        break;
+      case POW:
+        for (long i = 0; i < n; i++)
+          out[i] = powf(x[i], y[i]);
+        break;
+      case ATAN2:
+        for (long i = 0; i < n; i++)
+          out[i] = atan2f(y[i], x[i]);
+        break;
+      case SINCOS:
+        for (long i = 0; i < n; i++)
+          out[i] = sinf(y[i]) + cosf(y[i]);
+        break;
+    }
+  }
+};
+
+//-------------------------------------------------------------------------------------------------
+template <int TIER>
+static double NsPerValue(int fn, const std::vector<float>& x, const std::vector<float>& y,
+                         std::vector<float>& out)
+{
+  enum { REPS = 50 };
+  long n = (long)x.size();
+  Eval<TIER>::run(fn, x.data(), y.data(), out.data(), n); // warm up
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < REPS; r++)
+    Eval<TIER>::run(fn, x.data(), y.data(), out.data(), n);
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  return secs * 1e9 / (double)(REPS * n);
+}
+
+//-------------------------------------------------------------------------------------------------
+static void Bench()
+{
+  // inputs in the ranges the effects use (bin powers, gains in octaves, angles)
+  long n = 1 << 14;
+  std::vector<float> x(n), y(n), out(n);
+  for (long i = 0; i < n; i++) {
+    double u = (double)i / (double)n;
+    x[i] = (float)pow(10.0, -8.0 + 10.0 * fmod(u * 97.0, 1.0));
+    y[i] = (float)(-10.0 + 20.0 * fmod(u * 31.0, 1.0));
+  }
+
+  printf("\n%-7s %10s %10s %10s %10s %8s %8s %8s\n",
+         "ns/val",
+         "libm",
+         "lo",
+         "mid",
+         "hi",
+         "x lo",
+         "x mid",
+         "x hi");
+  float sink = 0.0f;
+  for (int fn = 0; fn < NUM_FNS; fn++) {
+    double libm = NsPerValue<-1>(fn, x, y, out);
+    sink += out[n / 2];
+    double t[3];
+    t[FAST_MATH_LO] = NsPerValue<FAST_MATH_LO>(fn, x, y, out);
+    sink += out[n / 2];
+    t[FAST_MATH_MID] = NsPerValue<FAST_MATH_MID>(fn, x, y, out);
+    sink += out[n / 2];
+    t[FAST_MATH_HI] = NsPerValue<FAST_MATH_HI>(fn, x, y, out);
+    sink += out[n / 2];
+    printf("%-7s %10.3f %10.3f %10.3f %10.3f %7.2fx %7.2fx %7.2fx\n",
+           g_fn_names[fn],
+           libm,
+           t[0],
+           t[1],
+           t[2],
+           libm / t[0],
+           libm / t[1],
+           libm / t[2]);
+  }
+
+  // keep the results live
+  if (sink == 12345.0f)
+    printf("\n");
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool bench = argc > 1 && !strcmp(argv[1], "-bench");
+
+  printf("%-7s %-4s %-4s %10s %10s\n", "fn", "err", "tier", "worst err", "limit");
+  bool ok = TestTier<FAST_MATH_LO>();
+  ok &= TestTier<FAST_MATH_MID>();
+  ok &= TestTier<FAST_MATH_HI>();
+
+  if (bench)
+    Bench();
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+/**************************************************************************************************
+Render every effect at several fft lengths & overlaps & compare against reference renders
+
+usage: DtBlkFxGolden [-update] <reference dir> [min snr dB] [seconds of audio]
+
+Each entry of g_fft_fx_table is rendered headless through the core (RenderOffline) at a few fft
+lengths from g_fft_sz & a few overlaps, with a sine & noise & then a chirp & impulses as the two
+channels. With -update the renders are written to the reference dir (one raw float file per case,
+see SaveRender), run it on a known good build before changing the effects or the blk processing.
+Otherwise each render is compared with its reference & the cases with an snr below "min snr dB"
+(default 60) or without a reference are listed. The exit code is 1 if any were. Cases that are
+meant to differ from the references (g_expected_diffs) are listed with the reason but don't fail.
+
+ctest's references are rendered by this program built on the core from before the blk processing
+changes (DtBlkFxGoldenBase, see CMakeLists.txt), the 60dB default leaves room for the fast math
+approximations.
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <algorithm>
+#include <filesystem>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "DtBlkFx.hpp"
+#include "FxRun1_0.h"
+#include "OfflineRender.h"
+
+enum { AUDIO_CHANNELS = DtBlkFx::AUDIO_CHANNELS };
+
+static const long g_fft_lens[] = {256, 1024, 4096, 16384};
+
+static const float g_overlaps[] = {0.0f, 0.2f, 0.4f};
+
+// signals on the left & right channels
+static const TestSignal g_signals[][2] = {{TEST_SINE, TEST_NOISE}, {TEST_CHIRP, TEST_IMPULSE}};
+
+// cases that are meant to differ from the baseline references (see CMakeLists.txt), still rendered
+// & listed but not failed
+struct ExpectedDiff {
+  const char* name;
+  const char* reason;
+};
+static const char* PITCH_TRACK =
+    "auto harmonic pitch is tracked between blks, the chirp is followed without octave jumps";
+static const ExpectedDiff g_expected_diffs[] = {
+    {"fx12_HarmRepitch_1024_ovl200_chirp_impulse", PITCH_TRACK},
+    {"fx12_HarmRepitch_1024_ovl400_chirp_impulse", PITCH_TRACK},
+    {"fx12_HarmRepitch_4096_ovl400_chirp_impulse", PITCH_TRACK},
+    {"fx15_Triangles_1024_ovl400_chirp_impulse", PITCH_TRACK},
+    {"fx15_Triangles_4096_ovl400_chirp_impulse", PITCH_TRACK},
+    {"fx16_Squares_1024_ovl400_chirp_impulse", PITCH_TRACK},
+    {"fx16_Squares_4096_ovl400_chirp_impulse", PITCH_TRACK},
+    {"fx17_Saws_1024_ovl400_chirp_impulse", PITCH_TRACK},
+    {"fx17_Saws_4096_ovl400_chirp_impulse", PITCH_TRACK},
+    {"fx18_Pointy_1024_ovl400_chirp_impulse", PITCH_TRACK},
+    {"fx18_Pointy_4096_ovl400_chirp_impulse", PITCH_TRACK},
+    {"fx19_Sweep_1024_ovl400_chirp_impulse", PITCH_TRACK},
+    {"fx19_Sweep_4096_ovl400_chirp_impulse", PITCH_TRACK},
+};
+
+//-------------------------------------------------------------------------------------------------
+static const char* ExpectedDiffReason(const char* name)
+// NULL if "name" should match its reference
+{
+  for (const ExpectedDiff& e : g_expected_diffs)
+    if (strcmp(e.name, name) == 0)
+      return e.reason;
+  return NULL;
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool update = argc > 1 && strcmp(argv[1], "-update") == 0;
+  if (update) {
+    argc--;
+    argv++;
+  }
+  if (argc < 2) {
+    fprintf(stderr, "usage: DtBlkFxGolden [-update] <reference dir> [min snr dB] [seconds]\n");
+    return 2;
+  }
+  const char* ref_dir = argv[1];
+  double min_snr_db = argc > 2 ? atof(argv[2]) : 60.0;
+  double audio_secs = argc > 3 ? atof(argv[3]) : 1.0;
+  long n = (long)(audio_secs * RENDER_SAMPLE_RATE);
+
+  if (update) {
+    std::error_code err;
+    std::filesystem::create_directories(ref_dir, err);
+  }
+
+  DtBlkFx* fx = NewRenderFx();
+
+  namespace P = BlkFxParam;
+  fx->setParameter(P::MIX_BACK, 0.0f);
+
+  RenderBuf in(n), out(n);
+  std::vector<float> ref_data(AUDIO_CHANNELS * n);
+
+  long case_n = 0, fail_n = 0, missing_n = 0, expected_n = 0;
+  double worst_snr_db = 1000.0;
+  for (const TestSignal* sig : g_signals) {
+    in.gen(sig[0], sig[1]);
+
+    for (int fx_type = 0; fx_type < g_num_fx_1_0; fx_type++) {
+      SetSoloFx(fx, fx_type);
+
+      for (long fft_len : g_fft_lens) {
+        fft_len = SetFFTLen(fx, fft_len);
+
+        for (float overlap : g_overlaps) {
+          fx->setParameter(P::OVERLAP, overlap);
+          RenderOffline(fx, in, out, n);
+          case_n++;
+
+          // (two entries are "Off" so the index is in the name too)
+          char name[256], path[1024];
+          snprintf(name,
+                   sizeof(name),
+                   "fx%02d_%s_%ld_ovl%03d_%s_%s",
+                   fx_type,
+                   GetFxRun1_0(fx_type)->name(),
+                   fft_len,
+                   (int)(overlap * 1000.0f + 0.5f),
+                   TestSignalName(sig[0]),
+                   TestSignalName(sig[1]));
+          snprintf(path, sizeof(path), "%s/%s.f32", ref_dir, name);
+
+          if (update) {
+            if (!SaveRender(path, &out.data[0], AUDIO_CHANNELS * n)) {
+              fprintf(stderr, "can't write %s\n", path);
+              return 2;
+            }
+            continue;
+          }
+
+          if (!LoadRender(path, &ref_data[0], AUDIO_CHANNELS * n)) {
+            printf("%-48s no reference\n", name);
+            missing_n++;
+            continue;
+          }
+          RenderDiff diff = CompareRender(&ref_data[0], &out.data[0], AUDIO_CHANNELS * n);
+          const char* expected = ExpectedDiffReason(name);
+          if (expected) {
+            printf("%-48s snr %7.1fdB  expected, %s\n", name, diff.snr_db, expected);
+            expected_n++;
+            continue;
+          }
+          worst_snr_db = std::min(worst_snr_db, diff.snr_db);
+          if (diff.snr_db < min_snr_db) {
+            printf("%-48s snr %7.1fdB  max err %g\n", name, diff.snr_db, diff.max_err);
+            fail_n++;
+          }
+        }
+      }
+    }
+  }
+
+  if (update)
+    printf("%ld reference renders written to %s\n", case_n, ref_dir);
+  else
+    printf("%ld cases: %ld below %.1fdB, %ld without a reference, %ld expected to differ, "
+           "worst snr %.1fdB\n",
+           case_n,
+           fail_n,
+           min_snr_db,
+           missing_n,
+           expected_n,
+           worst_snr_db);
+
+  delete fx;
+  return fail_n > 0 || missing_n > 0 ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+/**************************************************************************************************
+Show how much faster offline renders are with the fft blks processed on worker threads
+
+usage: DtBlkFxNonRealtimeBench [seconds of audio] [threads]
+
+Noise (left) & a chirp (right) go through a few effects at several fft lengths. Each is rendered
+by one instance as the host would when rendering offline (DtBlkFx::setNonRealtime) with one
+thread & then with "threads" workers (default is one per cpu). Each line has the time per second
+of audio both ways, the speedup & the largest difference between the two outputs (which should be
+0: the blks are mixed in order & the effects' random state is seeded per blk).
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+#include "DtBlkFx.hpp"
+#include "FxRun1_0.h"
+#include "OfflineRender.h"
+
+enum { AUDIO_CHANNELS = DtBlkFx::AUDIO_CHANNELS };
+
+// filter, smear (random phase), resample, harm repitch (tracks between blks so it stays serial)
+// & cross mix
+static const int g_fx_types[] = {0, 2, 6, 12, 29};
+
+static const long g_fft_lens[] = {1024, 4096, 16384};
+
+//-------------------------------------------------------------------------------------------------
+static double Render(DtBlkFx* fx, float** in, float** out, long n, int threads)
+// return seconds per second of audio (not counting starting the workers)
+{
+  fx->setNonRealtime(true, threads);
+  auto t0 = std::chrono::steady_clock::now();
+  RenderOffline(fx, in, out, n);
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  fx->setNonRealtime(false);
+  return secs * RENDER_SAMPLE_RATE / (double)n;
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  double audio_secs = argc > 1 ? atof(argv[1]) : 20.0;
+  int threads = argc > 2 ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+  long n = (long)(audio_secs * RENDER_SAMPLE_RATE);
+
+  DtBlkFx* fx = NewRenderFx();
+
+  RenderBuf in(n), ref(n), out(n);
+  in.gen(TEST_NOISE, TEST_CHIRP);
+
+  namespace P = BlkFxParam;
+  fx->setParameter(P::MIX_BACK, 0.0f);
+  fx->setParameter(P::OVERLAP, 0.3f);
+
+  printf("%.1f secs of audio, %d threads\n", audio_secs, threads);
+  printf("%-12s %6s %10s %10s %8s %10s\n",
+         "effect",
+         "fft",
+         "cpu 1",
+         "cpu N",
+         "speedup",
+         "max err");
+
+  for (int fx_type : g_fx_types) {
+    SetSoloFx(fx, fx_type);
+
+    for (long fft_len : g_fft_lens) {
+      fft_len = SetFFTLen(fx, fft_len);
+
+      double cpu_1 = Render(fx, in, ref, n, 1);
+      double cpu_n = Render(fx, in, out, n, threads);
+
+      float max_err = 0.0f;
+      for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+        max_err = std::max(max_err, CompareRender(ref.ch[ch], out.ch[ch], n).max_err);
+
+      printf("%-12s %6ld %10.5f %10.5f %7.2fx %10g\n",
+             GetFxRun1_0(fx_type)->name(),
+             fft_len,
+             cpu_1,
+             cpu_n,
+             cpu_1 / cpu_n,
+             max_err);
+    }
+  }
+
+  delete fx;
+  return 0;
+}
@@ -0,0 +1,143 @@
+/**************************************************************************************************
+Run the offline renders with the real-time safety checks on & fail on any violation
+
+usage: DtBlkFxRtCheck [seconds of audio]
+
+Built with DTBLKFX_RT_CHECK & RtCheckInterpose.cpp so that allocation, locks, condition variables
+& file io inside processReplacing (& the async worker's processing) are reported with a stack
+trace (see RtCheck.h). Noise (left) & a chirp (right) go through every effect & then through the
+filter with each processing mode on in turn, with spectrogram callbacks that copy to fixed
+buffers as a display would. Each line has the violations & the known violations (accepted &
+only counted) of a render. The exit code is 1 if there were any violations, "ctest" runs it.
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include "DtBlkFx.hpp"
+#include "FxRun1_0.h"
+#include "OfflineRender.h"
+#include "RtCheck.h"
+
+enum { AUDIO_CHANNELS = DtBlkFx::AUDIO_CHANNELS };
+
+// spectrogram display buffers
+static float g_in_pwr[MAX_FFT_SZ / 2 + 1], g_out_pwr[MAX_FFT_SZ / 2 + 1];
+
+// processing modes, each is turned on for a render & off after it
+struct Mode {
+  const char* name;
+  void (*set)(DtBlkFx* fx, bool on);
+  bool paced; // render at the pace of playback (so that a worker thread has time to run)
+};
+
+static const Mode g_modes[] = {
+    {"diff resynth", [](DtBlkFx* fx, bool on) { fx->setDiffResynth(on); }},
+    {"decimate", [](DtBlkFx* fx, bool on) { fx->setDecimate(on); }},
+    {"stereo pack", [](DtBlkFx* fx, bool on) { fx->setStereoPack(on); }},
+    {"dual mono", [](DtBlkFx* fx, bool on) { fx->setDualMono(on); }},
+    {"multi-res", [](DtBlkFx* fx, bool on) { fx->setMultiRes(on); }},
+    {"freeze", [](DtBlkFx* fx, bool on) { fx->setFreeze(on); }},
+    {"wola",
+     [](DtBlkFx* fx, bool on) { fx->setWola(on ? DtBlkFx::WOLA_HANN : DtBlkFx::WOLA_OFF); }},
+    {"adaptive len", [](DtBlkFx* fx, bool on) { fx->setAdaptiveLen(on); }},
+    {"adaptive hop", [](DtBlkFx* fx, bool on) { fx->setAdaptiveHop(on); }},
+    {"memo", [](DtBlkFx* fx, bool on) { fx->setMemoBudget(on ? 64 << 20 : 0); }},
+    {"amortize", [](DtBlkFx* fx, bool on) { fx->setAmortize(on); }},
+    {"async", [](DtBlkFx* fx, bool on) { fx->setAsync(on); }, /*paced*/ true},
+    {"non-realtime", [](DtBlkFx* fx, bool on) { fx->setNonRealtime(on, 2); }},
+};
+
+//-------------------------------------------------------------------------------------------------
+static void RenderPaced(DtBlkFx* fx, float** in, float** /*out*/ out, long n)
+// as RenderOffline but sleeping for the length of each callback
+{
+  enum { BLK_N = 512 };
+  fx->setBlockSize(BLK_N);
+  fx->suspend();
+  fx->resume();
+
+  float* in_p[AUDIO_CHANNELS];
+  float* out_p[AUDIO_CHANNELS];
+  for (long pos = 0; pos < n; pos += BLK_N) {
+    for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+      in_p[ch] = in[ch] + pos;
+      out_p[ch] = out[ch] + pos;
+    }
+    fx->processReplacing(in_p, out_p, (VstInt32)std::min((long)BLK_N, n - pos));
+    std::this_thread::sleep_for(std::chrono::duration<double>(BLK_N / RENDER_SAMPLE_RATE));
+  }
+}
+
+//-------------------------------------------------------------------------------------------------
+static bool /*true=ok*/ Render(DtBlkFx* fx, const char* name, bool paced, float** in, float** out,
+                               long n)
+{
+  long bad_n = RtCheckViolations(), known_n = RtCheckKnownViolations();
+  if (paced)
+    RenderPaced(fx, in, out, n);
+  else
+    RenderOffline(fx, in, out, n);
+  bad_n = RtCheckViolations() - bad_n;
+  known_n = RtCheckKnownViolations() - known_n;
+  printf("%-14s %8ld %8ld\n", name, bad_n, known_n);
+  return bad_n == 0;
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  double audio_secs = argc > 1 ? atof(argv[1]) : 2.0;
+  long n = (long)(audio_secs * RENDER_SAMPLE_RATE);
+
+  DtBlkFx* fx = NewRenderFx();
+  fx->inputSpectrogramCallback = [](const float* pwr, int bins) {
+    memcpy(g_in_pwr, pwr, bins * sizeof(float));
+  };
+  fx->outputSpectrogramCallback = [](const float* pwr, int bins) {
+    memcpy(g_out_pwr, pwr, bins * sizeof(float));
+  };
+
+  RenderBuf in(n), out(n);
+  in.gen(TEST_NOISE, TEST_CHIRP);
+
+  namespace P = BlkFxParam;
+  fx->setParameter(P::MIX_BACK, 0.1f);
+  fx->setParameter(P::OVERLAP, 0.3f);
+  long fft_len = SetFFTLen(fx, 4096);
+
+  printf("%.1f secs of audio, fft length %ld\n", audio_secs, fft_len);
+  printf("%-14s %8s %8s\n", "render", "bad", "known");
+
+  bool ok = true;
+  for (int fx_type = 0; fx_type < g_num_fx_1_0; fx_type++) {
+    SetSoloFx(fx, fx_type);
+    ok &= Render(fx, GetFxRun1_0(fx_type)->name(), /*paced*/ false, in, out, n);
+  }
+
+  SetSoloFx(fx, 0 /*filter*/);
+  for (const Mode& mode : g_modes) {
+    mode.set(fx, true);
+    ok &= Render(fx, mode.name, mode.paced, in, out, n);
+    mode.set(fx, false);
+  }
+
+  printf("%ld violations, %ld known\n", RtCheckViolations(), RtCheckKnownViolations());
+
+  delete fx;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,101 @@
+/**************************************************************************************************
+Render the same input through several effects with the forward analysis cached in files
+
+usage: DtBlkFxStftCacheBench [seconds of audio] [cache dir]
+
+Noise (left) & a chirp (right) go through a few effects at several fft lengths, as when trying
+different params on the same input offline. Each effect is rendered without the cache & then with
+the analysis cached in "cache dir" (default is the current dir, see StftCache.h): the first effect
+at each fft length writes the file & the rest read it. Each line has the time per second of audio
+both ways, the speedup & the largest difference between the two outputs (which should be 0). The
+files are left in the dir so that running it again reads them for the first effects as well.
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "DtBlkFx.hpp"
+#include "FxRun1_0.h"
+#include "OfflineRender.h"
+
+enum { AUDIO_CHANNELS = DtBlkFx::AUDIO_CHANNELS };
+
+// filter, contrast, clip, shift & harm filt
+static const int g_fx_types[] = {0, 1, 4, 7, 13};
+
+static const long g_fft_lens[] = {1024, 4096, 16384};
+
+//-------------------------------------------------------------------------------------------------
+static double Render(DtBlkFx* fx, float** in, float** out, long n, const char* cache_dir)
+// return seconds per second of audio
+{
+  auto t0 = std::chrono::steady_clock::now();
+  RenderOffline(fx, in, out, n, /*blk_n*/ 512, cache_dir);
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  return secs * RENDER_SAMPLE_RATE / (double)n;
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  double audio_secs = argc > 1 ? atof(argv[1]) : 20.0;
+  const char* cache_dir = argc > 2 ? argv[2] : ".";
+  long n = (long)(audio_secs * RENDER_SAMPLE_RATE);
+
+  DtBlkFx* fx = NewRenderFx();
+
+  RenderBuf in(n), ref(n), out(n);
+  in.gen(TEST_NOISE, TEST_CHIRP);
+
+  namespace P = BlkFxParam;
+  fx->setParameter(P::MIX_BACK, 0.0f);
+  fx->setParameter(P::OVERLAP, 0.3f);
+
+  printf("%.1f secs of audio, cache in %s\n", audio_secs, cache_dir);
+  printf("%-12s %6s %10s %10s %8s %10s\n",
+         "effect",
+         "fft",
+         "cpu",
+         "cpu cache",
+         "speedup",
+         "max err");
+
+  for (long fft_len : g_fft_lens) {
+    fft_len = SetFFTLen(fx, fft_len);
+
+    for (int fx_type : g_fx_types) {
+      SetSoloFx(fx, fx_type);
+
+      double cpu = Render(fx, in, ref, n, /*cache_dir*/ NULL);
+      double cpu_cache = Render(fx, in, out, n, cache_dir);
+
+      float max_err = 0.0f;
+      for (int ch = 0; ch < AUDIO_CHANNELS; ch++)
+        max_err = std::max(max_err, CompareRender(ref.ch[ch], out.ch[ch], n).max_err);
+
+      printf("%-12s %6ld %10.5f %10.5f %7.2fx %10g\n",
+             GetFxRun1_0(fx_type)->name(),
+             fft_len,
+             cpu,
+             cpu_cache,
+             cpu / cpu_cache,
+             max_err);
+    }
+  }
+
+  delete fx;
+  return 0;
+}
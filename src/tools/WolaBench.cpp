@@ -0,0 +1,179 @@
+/**************************************************************************************************
+Compare weighted overlap-add blks with cross-faded blks at matched artifact levels
+
+usage: DtBlkFxWolaBench [seconds of audio] [fft length]
+
+Two sines (1kHz & 5kHz) go through a filter that removes everything above 3kHz. The artifact
+level is everything in the output other than the 1kHz sine (a least squares fit of it) relative
+to the sine. Cross-faded blks are rendered at a range of overlaps & wola blks with both windows at
+both hops (half & a quarter of the blk), each prints its artifact level, average hop, blk rate &
+time per second of audio. Then at matched artifact levels: for each cross-faded overlap the wola
+setting with the lowest blk rate that gets an artifact level at least as low is listed next to it
+with the ratio of the blk rates & of the cpu (cross-faded over wola, above 1 is a saving).
+
+This program is free software; you can redistribute it and/or modify it under the terms of the GNU
+General Public License as published by the Free Software Foundation; either version 2 of the
+License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+General Public License for more details.
+
+***************************************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "DtBlkFx.hpp"
+#include "OfflineRender.h"
+
+enum { AUDIO_CHANNELS = DtBlkFx::AUDIO_CHANNELS };
+
+static const float KEEP_HZ = 1000.0f, REMOVE_HZ = 5000.0f, CUTOFF_HZ = 3000.0f;
+
+struct Result {
+  char mode[32];   // "xfade" & overlap param or window & hop
+  double art_db;   // artifact level
+  double hop;      // average samples between blks
+  double blk_rate; // blks per second of audio
+  double cpu;      // seconds per second of audio
+};
+
+//-------------------------------------------------------------------------------------------------
+static double ArtifactDb(const float* x, long i0, long i1)
+// power of "x" other than the KEEP_HZ sine over the power of the sine (dB)
+{
+  // least squares fit of a*sin + b*cos (the two are nearly orthogonal over many cycles)
+  double w = 2.0 * 3.14159265358979 * KEEP_HZ / RENDER_SAMPLE_RATE;
+  double ss = 0, cc = 0, sc = 0, xs = 0, xc = 0;
+  for (long i = i0; i < i1; i++) {
+    double s = sin(w * i), c = cos(w * i);
+    ss += s * s;
+    cc += c * c;
+    sc += s * c;
+    xs += x[i] * s;
+    xc += x[i] * c;
+  }
+  double det = ss * cc - sc * sc;
+  double a = (xs * cc - xc * sc) / det, b = (xc * ss - xs * sc) / det;
+
+  double fit_pwr = 0, res_pwr = 0;
+  for (long i = i0; i < i1; i++) {
+    double f = a * sin(w * i) + b * cos(w * i);
+    fit_pwr += f * f;
+    res_pwr += (x[i] - f) * (x[i] - f);
+  }
+  return 10.0 * log10(std::max(res_pwr, 1e-30) / std::max(fit_pwr, 1e-30));
+}
+
+//-------------------------------------------------------------------------------------------------
+static Result Run(DtBlkFx* fx, int wola_wdw, int hop_div, float overlap, float** in,
+                  float** out, long n)
+// hop_div is for wola & overlap for cross-faded blks
+{
+  fx->setParameter(BlkFxParam::OVERLAP, overlap);
+  fx->setWola(wola_wdw, hop_div);
+
+  DtBlkFx::CallbackCost cost;
+  fx->getCallbackCost(cost, /*reset*/ true);
+
+  auto t0 = std::chrono::steady_clock::now();
+  RenderOffline(fx, in, out, n);
+  double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  fx->getCallbackCost(cost);
+
+  // skip the start (settling) & the end (the output is delayed)
+  long settle_n = fx->getSettleSamps();
+  Result r;
+  if (wola_wdw == DtBlkFx::WOLA_OFF)
+    snprintf(r.mode, sizeof(r.mode), "xfade %.2f", overlap);
+  else
+    snprintf(r.mode,
+             sizeof(r.mode),
+             "%s 1/%d",
+             wola_wdw == DtBlkFx::WOLA_HANN ? "hann" : "kaiser",
+             hop_div);
+  r.art_db = ArtifactDb(out[0], 2 * settle_n, n - settle_n);
+  r.hop = cost.blk_rate > 0.0 ? RENDER_SAMPLE_RATE / cost.blk_rate : 0.0;
+  r.blk_rate = cost.blk_rate;
+  r.cpu = secs * RENDER_SAMPLE_RATE / (double)n;
+  return r;
+}
+
+//-------------------------------------------------------------------------------------------------
+static void Print(const Result& r)
+{
+  printf("%-12s %9.1f %8.0f %9.1f %9.5f\n", r.mode, r.art_db, r.hop, r.blk_rate, r.cpu);
+}
+
+//-------------------------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  double audio_secs = argc > 1 ? atof(argv[1]) : 20.0;
+  long fft_len = argc > 2 ? atol(argv[2]) : 4096;
+  long n = (long)(audio_secs * RENDER_SAMPLE_RATE);
+
+  DtBlkFx* fx = NewRenderFx();
+
+  // fx set 0 removes everything above CUTOFF_HZ, the others are off
+  namespace P = BlkFxParam;
+  fx->setParameter(P::MIX_BACK, 0.0f);
+  fft_len = SetFFTLen(fx, fft_len);
+  SetSoloFx(fx, 0 /*filter*/, FreqParam(CUTOFF_HZ), 1.0f, /*amp*/ 0.0f, /*val*/ 0.0f);
+
+  RenderBuf in(n), out(n);
+  for (int ch = 0; ch < AUDIO_CHANNELS; ch++) {
+    for (long i = 0; i < n; i++) {
+      double t = (double)i / RENDER_SAMPLE_RATE;
+      in.ch[ch][i] = (float)(0.25 * sin(2.0 * 3.14159265358979 * KEEP_HZ * t) +
+                             0.25 * sin(2.0 * 3.14159265358979 * REMOVE_HZ * t));
+    }
+  }
+
+  printf("fft length %ld, %.1f secs of audio\n", fft_len, audio_secs);
+  printf("%-12s %9s %8s %9s %9s\n", "blks", "artifacts", "hop", "blks/sec", "cpu");
+
+  // cross-faded blks, overlap params below 0.5 (above is beat sync)
+  static const float xfade_overlaps[] = {0.0f, 0.1f, 0.2f, 0.3f, 0.35f, 0.4f, 0.45f, 0.47f, 0.49f};
+  std::vector<Result> xfade;
+  for (float overlap : xfade_overlaps) {
+    xfade.push_back(Run(fx, DtBlkFx::WOLA_OFF, 0, overlap, in, out, n));
+    Print(xfade.back());
+  }
+
+  // wola at a hop of half & a quarter of the blk (the overlap param doesn't apply)
+  std::vector<Result> wola;
+  for (int wdw = DtBlkFx::WOLA_HANN; wdw <= DtBlkFx::WOLA_KAISER; wdw++) {
+    for (int hop_div = 2; hop_div <= 4; hop_div *= 2) {
+      wola.push_back(Run(fx, wdw, hop_div, 0.0f, in, out, n));
+      Print(wola.back());
+    }
+  }
+
+  // at matched artifact levels
+  printf("\nmatched artifact levels (wola with the fewest blks that is at least as good):\n");
+  for (const Result& x : xfade) {
+    const Result* best = NULL;
+    for (const Result& w : wola)
+      if (w.art_db <= x.art_db && (!best || w.blk_rate < best->blk_rate))
+        best = &w;
+
+    printf("%-12s %6.1fdB %5.1f blks/sec : ", x.mode, x.art_db, x.blk_rate);
+    if (best)
+      printf("%-10s %6.1fdB %5.1f blks/sec, blks %.2fx cpu %.2fx\n",
+             best->mode,
+             best->art_db,
+             best->blk_rate,
+             x.blk_rate / best->blk_rate,
+             x.cpu / best->cpu);
+    else
+      printf("no wola setting gets as low\n");
+  }
+
+  delete fx;
+  return 0;
+}